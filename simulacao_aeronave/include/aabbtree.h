@@ -0,0 +1,77 @@
+#ifndef _AABBTREE_H
+#define _AABBTREE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+// Árvore dinâmica de AABBs (Axis-Aligned Bounding Boxes) para consultas
+// espaciais sobre os objetos móveis da cena: sobreposição com uma caixa, raio
+// e frustum. Cada objeto é uma folha ("proxy"), identificada pelo índice
+// retornado por AabbTree_Insert(), e guarda um inteiro escolhido por quem o
+// inseriu ("user").
+//
+// As folhas guardam a caixa do objeto aumentada de "margin" em todas as
+// direções (e na direção do deslocamento, em AabbTree_Update()). Enquanto o
+// objeto se move dentro da caixa aumentada a árvore não muda; quando sai
+// dela, a folha é removida e reinserida. Na inserção, o irmão da nova folha é
+// escolhido pelo menor aumento de área das caixas (heurística de área de
+// superfície), e a árvore é mantida balanceada por rotações, como uma árvore
+// AVL; assim as consultas visitam O(log n) nós.
+//
+// As consultas retornam candidatos: objetos cuja caixa AUMENTADA intercepta
+// a região. O teste exato fica com quem chama.
+#define AABBTREE_NULL (-1)
+#define AABBTREE_DEFAULT_MARGIN 0.1f
+
+struct AabbTreeNode
+{
+    glm::vec3 min;     // Caixa aumentada (folhas) ou união das caixas dos filhos
+    glm::vec3 max;
+    int       parent;  // Pai, ou próximo nó livre
+    int       child1;  // AABBTREE_NULL nas folhas
+    int       child2;
+    int       height;  // 0 nas folhas, -1 nos nós livres
+    int       user;
+};
+
+struct AabbTree
+{
+    std::vector<AabbTreeNode> nodes;
+    int                       root;
+    int                       free_list;
+    size_t                    num_proxies;
+    float                     margin;
+};
+
+void AabbTree_Init(AabbTree* tree, float margin = AABBTREE_DEFAULT_MARGIN);
+void AabbTree_Clear(AabbTree* tree);
+
+// Insere um objeto com a caixa [min, max] e retorna seu proxy.
+int AabbTree_Insert(AabbTree* tree, const glm::vec3& min, const glm::vec3& max, int user);
+void AabbTree_Remove(AabbTree* tree, int proxy);
+
+// Atualiza a caixa de um objeto. "displacement" é o deslocamento esperado até
+// a próxima atualização, utilizado para aumentar a caixa na direção do
+// movimento. Retorna true se a folha precisou ser reinserida.
+bool AabbTree_Update(AabbTree* tree, int proxy, const glm::vec3& min, const glm::vec3& max,
+                     const glm::vec3& displacement = glm::vec3(0.0f));
+
+int AabbTree_User(const AabbTree& tree, int proxy);
+
+// Acrescenta a "users" os objetos cuja caixa intercepta [min, max].
+void AabbTree_QueryOverlap(const AabbTree& tree, const glm::vec3& min, const glm::vec3& max, std::vector<int>* users);
+
+// Idem, para o segmento origin + t*direction, com t em [0, max_t].
+void AabbTree_QueryRay(const AabbTree& tree, const glm::vec3& origin, const glm::vec3& direction, float max_t,
+                       std::vector<int>* users);
+
+// Idem, para o frustum dado pelos planos a*x + b*y + c*z + d >= 0 (veja
+// Culling_GetPlanes() em "culling.h").
+void AabbTree_QueryFrustum(const AabbTree& tree, const float planes[6][4], std::vector<int>* users);
+
+// Altura da árvore (0 com uma única folha, -1 vazia)
+int AabbTree_Height(const AabbTree& tree);
+
+#endif // _AABBTREE_H
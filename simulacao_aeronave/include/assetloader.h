@@ -0,0 +1,49 @@
+#ifndef _ASSETLOADER_H
+#define _ASSETLOADER_H
+
+#include <cstddef>
+#include <functional>
+
+// Carregamento assíncrono de recursos (modelos e texturas). Cada tarefa é
+// dividida em duas partes:
+//
+//   - "load": leitura do disco, decodificação de imagens, leitura de ".obj",
+//     etc. Executada em uma thread de trabalho, e portanto NÃO pode chamar
+//     funções da OpenGL;
+//
+//   - "upload": envio dos dados para a GPU. Executada na thread principal
+//     (dona do contexto OpenGL) por AssetLoader_Update(), em passos. Cada
+//     chamada deve enviar uma parte limitada dos dados e retornar true
+//     quando a tarefa estiver concluída.
+//
+// Assim o programa pode começar a renderizar imediatamente, e os objetos
+// passam a ser desenhados à medida que ficam prontos.
+typedef std::function<void()> AssetLoadFunction;
+typedef std::function<bool()> AssetUploadFunction;
+
+// Cria as threads de trabalho. Se "num_threads" for zero, utiliza uma thread
+// a menos que o número de núcleos da máquina (no mínimo uma).
+void AssetLoader_Init(unsigned int num_threads = 0);
+
+// Finaliza as threads de trabalho, aguardando as tarefas em andamento.
+// Tarefas ainda não enviadas para a GPU são descartadas, e os contadores de
+// tarefas voltam a zero.
+void AssetLoader_Shutdown();
+
+// Agenda uma tarefa. As tarefas são lidas na ordem em que são agendadas, mas
+// podem ficar prontas em qualquer ordem.
+void AssetLoader_Submit(const AssetLoadFunction& load, const AssetUploadFunction& upload);
+
+// Executa passos de envio para a GPU das tarefas já lidas, até que
+// "budget_ms" milissegundos se passem. Pelo menos um passo é executado por
+// chamada, se houver algum pendente. Deve ser chamada uma vez por quadro.
+void AssetLoader_Update(double budget_ms);
+
+// Número de tarefas concluídas e agendadas até o momento
+size_t AssetLoader_NumCompleted();
+size_t AssetLoader_NumSubmitted();
+
+// Retorna true se todas as tarefas agendadas já foram concluídas
+bool AssetLoader_Idle();
+
+#endif // _ASSETLOADER_H
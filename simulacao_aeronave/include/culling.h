@@ -0,0 +1,55 @@
+#ifndef _CULLING_H
+#define _CULLING_H
+
+#include <cstddef>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+// Descarte dos objetos fora da pirâmide de visualização (frustum culling).
+// Os seis planos do frustum são extraídos da matriz projection*view
+// (Culling_SetFrustum()); cada objeto é representado por uma esfera
+// envolvente no sistema de coordenadas global (Culling_Add()), e
+// Culling_Run() testa todas as esferas do quadro de uma vez.
+//
+// As esferas ficam em vetores separados por coordenada (x, y, z e raio;
+// "structure of arrays"), de modo que o teste de um plano contra quatro
+// esferas (SSE) ou oito (AVX, se o compilador o habilitar, por exemplo com
+// -mavx) é uma sequência de multiplicações e somas sem embaralhar dados. Em
+// outras arquiteturas o mesmo teste é feito uma esfera por vez.
+//
+// Uma esfera é descartada se estiver inteiramente atrás de algum dos planos.
+// O teste é conservador: esferas próximas de um canto do frustum podem ser
+// consideradas visíveis sem estar.
+
+struct CullingStats
+{
+    size_t objects;  // Esferas testadas no último Culling_Run()
+    size_t visible;
+    size_t culled;
+};
+
+// Define o frustum a partir da matriz "projection * view". Com a matriz
+// "projection * view * model" os planos ficam no sistema do modelo.
+void Culling_SetFrustum(const glm::mat4& projection_view);
+
+// Copia os planos do frustum atual, a*x + b*y + c*z + d >= 0 do lado de
+// dentro, com (a,b,c) unitário.
+void Culling_GetPlanes(float planes[6][4]);
+
+// Esvazia a lista de esferas do quadro.
+void Culling_Clear();
+
+// Acrescenta uma esfera e retorna seu índice, utilizado em Culling_Visible().
+size_t Culling_Add(const glm::vec3& center, float radius);
+
+// Testa todas as esferas acrescentadas desde Culling_Clear(). Retorna o
+// número de esferas visíveis.
+size_t Culling_Run();
+
+// Resultado de Culling_Run() para a esfera "index".
+bool Culling_Visible(size_t index);
+
+const CullingStats& Culling_Stats();
+
+#endif // _CULLING_H
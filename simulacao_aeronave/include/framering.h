@@ -0,0 +1,76 @@
+#ifndef _FRAMERING_H
+#define _FRAMERING_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Buffer circular para os dados gerados a cada quadro: o bloco de uniforms
+// do quadro (FrameUniforms, abaixo), as instâncias da fila de renderização
+// (veja "renderqueue.h") e os vértices do texto. Em vez de um glBufferData()
+// ou glBufferSubData() por desenho, os dados são escritos diretamente na
+// memória de um único buffer mapeado, e os desenhos apenas apontam para a
+// faixa correspondente.
+//
+// O buffer é dividido em FRAMERING_FRAMES partes, uma por quadro em voo. Ao
+// final de cada quadro FrameRing_EndFrame() insere uma fence (glFenceSync());
+// quando a mesma parte volta a ser utilizada, FrameRing_BeginFrame() espera
+// que a GPU tenha terminado os desenhos daquele quadro antes de sobrescrevê-la.
+//
+// Com GL_ARB_buffer_storage o buffer fica mapeado durante todo o programa
+// (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT). Sem a extensão cada
+// alocação é mapeada com GL_MAP_UNSYNCHRONIZED_BIT, protegida pelas mesmas
+// fences, e desmapeada por FrameRing_Commit().
+//
+// Se um quadro precisar de mais espaço do que uma parte, FrameRing_Allocate()
+// retorna NULL (quem chama deve ter outro caminho) e o buffer é aumentado no
+// início do quadro seguinte.
+#define FRAMERING_FRAMES            3
+#define FRAMERING_DEFAULT_FRAME_SIZE (1 << 20)
+
+// Ponto de ligação (glBindBufferRange(GL_UNIFORM_BUFFER, ...)) do bloco de
+// uniforms do quadro, utilizado pelo programa da cena.
+#define FRAME_UNIFORMS_BINDING 0
+
+// Bloco "FrameUniforms" dos shaders, com layout std140
+struct FrameUniforms
+{
+    float view[16];            // Matriz "view", por colunas
+    float projection[16];      // Matriz "projection"
+    float camera_position[4];  // Posição da câmera no sistema global
+};
+
+typedef void (*PFN_FrameRingBufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+struct FrameRingStats
+{
+    size_t frame_size;   // Bytes disponíveis por quadro
+    size_t used;         // Bytes utilizados no último quadro
+    size_t overflows;    // Alocações recusadas por falta de espaço
+    size_t waits;        // Vezes em que a CPU esperou pela GPU
+    double wait_ms;      // Tempo total dessas esperas
+    bool   persistent;
+};
+
+// Cria o buffer. "buffer_storage" é glBufferStorage(), ou NULL se a extensão
+// não estiver disponível.
+void FrameRing_Init(size_t frame_size, PFN_FrameRingBufferStorage buffer_storage);
+void FrameRing_Shutdown();
+
+void FrameRing_BeginFrame();
+void FrameRing_EndFrame();
+
+// Reserva "bytes" bytes, com o início alinhado em "alignment" bytes, e
+// retorna o ponteiro para escrita e a posição no buffer ("offset"). Os dados
+// devem ser escritos antes de FrameRing_Commit(), que deve ser chamada antes
+// da próxima alocação e de qualquer desenho que os utilize.
+void* FrameRing_Allocate(size_t bytes, size_t alignment, GLintptr* offset);
+void  FrameRing_Commit();
+
+// Escreve "uniforms" no buffer e o liga a FRAME_UNIFORMS_BINDING.
+void FrameRing_SetFrameUniforms(const FrameUniforms& uniforms);
+
+GLuint FrameRing_Buffer();
+const FrameRingStats& FrameRing_Stats();
+
+#endif // _FRAMERING_H
@@ -0,0 +1,52 @@
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Arquivo mapeado em memória somente para leitura (mmap() em sistemas POSIX,
+// MapViewOfFile() no Windows). O conteúdo fica acessível em "data" até que o
+// objeto seja destruído ou que MappedFile_Close() seja chamada.
+struct MappedFile
+{
+    const unsigned char* data;
+    size_t               size;
+
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+
+    MappedFile();
+    ~MappedFile();
+
+private:
+    // Um mapeamento não pode ser copiado, pois seria desfeito duas vezes.
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+// Mapeia o arquivo "filename" inteiro. Retorna false se o arquivo não existir,
+// estiver vazio, ou não puder ser mapeado.
+bool MappedFile_Open(const char* filename, MappedFile* file);
+void MappedFile_Close(MappedFile* file);
+
+// Troca os mapeamentos de "a" e "b", transferindo a posse de cada um.
+void MappedFile_Swap(MappedFile* a, MappedFile* b);
+
+// Obtém tamanho (em bytes) e data de modificação (em segundos) de um arquivo.
+// Utilizado para detectar caches desatualizados em relação ao arquivo fonte.
+bool File_GetStamp(const char* filename, uint64_t* size, int64_t* mtime);
+
+// Escreve "size" bytes em "filename" de maneira atômica: os dados são
+// escritos em um arquivo temporário, que então é renomeado. Assim um cache
+// parcialmente escrito nunca é lido por outra execução do programa.
+bool File_WriteAtomic(const char* filename, const void* data, size_t size);
+
+// Auxiliares dos formatos de cache binários: alinha "offset" ao próximo
+// múltiplo de 16 bytes, e verifica se a seção [offset, offset+size) está
+// dentro de um arquivo de "file_size" bytes (sem estourar a soma).
+uint64_t File_AlignTo16(uint64_t offset);
+bool File_SectionFits(uint64_t offset, uint64_t size, uint64_t file_size);
+
+#endif // _MAPPEDFILE_H
@@ -0,0 +1,29 @@
+#ifndef _MESHADJACENCY_H
+#define _MESHADJACENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Adjacência vértice -> triângulos em formato compacto (CSR, "compressed
+// sparse row"): os triângulos que utilizam o vértice "v" são
+// triangles[offsets[v]], ..., triangles[offsets[v+1] - 1], em ordem
+// crescente. Um triângulo que repete um vértice aparece repetido na lista
+// desse vértice. Construída uma vez por malha e compartilhada pelos passos
+// que percorrem a vizinhança dos vértices (cálculo de normais, reordenação
+// de triângulos, simplificação, ...).
+struct MeshAdjacency
+{
+    std::vector<uint32_t> offsets;   // num_vertices + 1 posições
+    std::vector<uint32_t> triangles; // Um elemento por índice
+};
+
+// Constrói a adjacência dos triângulos "indices[0..num_indices)" cujos
+// vértices estão em [0, num_vertices). A memória de "adjacency" é
+// reaproveitada entre chamadas.
+void MeshAdjacency_Build(const uint32_t* indices, size_t num_indices, size_t num_vertices, MeshAdjacency* adjacency);
+
+// Número de triângulos que utilizam o vértice "v"
+uint32_t MeshAdjacency_Degree(const MeshAdjacency& adjacency, uint32_t v);
+
+#endif // _MESHADJACENCY_H
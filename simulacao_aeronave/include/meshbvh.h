@@ -0,0 +1,69 @@
+#ifndef _MESHBVH_H
+#define _MESHBVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+// Hierarquia de volumes envolventes (BVH) sobre os triângulos de um shape,
+// para os testes exatos de colisão (a fase estreita, depois de "aabbtree.h",
+// "spatialgrid.h" e "obb.h") e para os raios da arma instantânea. Todas as
+// consultas são feitas no sistema de coordenadas do modelo.
+//
+// A hierarquia é construída uma única vez, quando a malha é carregada, pela
+// heurística de área de superfície (SAH): a cada nó os centróides dos
+// triângulos são distribuídos em MESHBVH_BINS intervalos em cada eixo, e é
+// escolhida a divisão que minimiza o custo esperado de uma consulta (área de
+// cada filho vezes seu número de triângulos).
+//
+// Os nós ficam em um único vetor, em profundidade: o primeiro filho de um nó
+// interno é o nó seguinte, e só o índice do segundo é guardado. Cada nó ocupa
+// 32 bytes (dois por linha de cache), e os vértices dos triângulos são
+// copiados na ordem das folhas, de modo que uma folha lê posições contíguas.
+#define MESHBVH_BINS          16
+#define MESHBVH_MAX_LEAF_SIZE 8
+#define MESHBVH_MAX_DEPTH     64  // Também o tamanho da pilha das consultas
+
+struct MeshBvhNode
+{
+    glm::vec3 bbox_min;
+    int32_t   first;    // Folha: primeiro triângulo; nó interno: índice do segundo filho
+    glm::vec3 bbox_max;
+    int32_t   count;    // Número de triângulos da folha; 0 em nós internos
+};
+
+struct MeshBvh
+{
+    std::vector<MeshBvhNode> nodes;
+    std::vector<glm::vec3>   vertices; // Três por triângulo, na ordem das folhas
+};
+
+// Resultado de MeshBvh_Raycast(): o ponto atingido é origin + t*direction.
+struct MeshBvhHit
+{
+    float    t;
+    uint32_t triangle; // Índice em "vertices" dividido por 3
+};
+
+// Constrói a hierarquia dos "num_indices" / 3 triângulos em "indices"
+// ("index_size" = 2 ou 4 bytes por índice). A posição (3 floats) do vértice
+// i está em "positions" + i*"stride" bytes.
+void MeshBvh_Build(MeshBvh* bvh, const float* positions, size_t stride, const void* indices, size_t index_size, size_t num_indices);
+
+void MeshBvh_Clear(MeshBvh* bvh);
+
+// Memória ocupada pela hierarquia, em bytes.
+size_t MeshBvh_Bytes(const MeshBvh& bvh);
+
+// Triângulo mais próximo atingido pelo segmento origin + t*direction, com t
+// em [0, max_t]. Retorna false se nenhum for atingido.
+bool MeshBvh_Raycast(const MeshBvh& bvh, const glm::vec3& origin, const glm::vec3& direction, float max_t, MeshBvhHit* hit);
+
+// Retorna true se algum triângulo está a uma distância de no máximo "radius"
+// do segmento de "from" a "to" (a cápsula varrida por uma esfera que vai de
+// "from" a "to"). Com "from" igual a "to", testa uma esfera.
+bool MeshBvh_IntersectCapsule(const MeshBvh& bvh, const glm::vec3& from, const glm::vec3& to, float radius);
+
+#endif // _MESHBVH_H
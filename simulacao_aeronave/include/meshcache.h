@@ -0,0 +1,46 @@
+#ifndef _MESHCACHE_H
+#define _MESHCACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "meshdata.h"
+
+// Cache binário de malhas. Depois que um arquivo ".obj" é lido e convertido
+// para o formato final da GPU (veja BuildTriangles() em main.cpp), o resultado
+// é gravado em "<arquivo>.meshcache". Nas execuções seguintes o cache é
+// mapeado em memória e os atributos são enviados para a GPU diretamente do
+// arquivo, sem leitura de texto nem cálculo de normais.
+//
+// O cache é descartado se:
+//   - a versão do formato (MESHCACHE_VERSION) mudou;
+//   - o tamanho ou a data de modificação do arquivo fonte mudou;
+//   - as opções de construção ("flags") são diferentes.
+//
+// Layout do arquivo (todas as seções alinhadas em 16 bytes):
+//
+//   MeshCacheHeader
+//   MeshCacheShape[num_shapes]
+//   MeshCacheLod[num_lods]                     (níveis de detalhe dos shapes)
+//   nomes dos shapes (sem '\0')
+//   PackedVertex vertices[num_vertices]
+//   uint16_t ou uint32_t indices[num_indices]  (veja MeshOpt_PackIndices())
+//
+#define MESHCACHE_VERSION 5
+
+// Opções de construção que alteram o conteúdo do cache
+#define MESHCACHE_FLAG_COMPUTED_NORMALS 0x1
+#define MESHCACHE_FLAG_OPTIMIZED        0x2 // Veja MeshOpt_OptimizeVertexCache()
+#define MESHCACHE_FLAG_LODS             0x4 // Veja MeshOpt_GenerateLods()
+
+std::string MeshCache_PathFor(const char* source_filename);
+
+// Tenta mapear o cache de "source_filename". Retorna false se o cache não
+// existir, estiver desatualizado ou corrompido; neste caso "mesh" não é
+// alterado.
+bool MeshCache_Load(const char* source_filename, uint32_t flags, MeshData* mesh);
+
+// Grava o cache de "source_filename" a partir de uma malha já construída.
+bool MeshCache_Save(const char* source_filename, uint32_t flags, const MeshData& mesh);
+
+#endif // _MESHCACHE_H
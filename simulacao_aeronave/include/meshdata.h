@@ -0,0 +1,114 @@
+#ifndef _MESHDATA_H
+#define _MESHDATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "mappedfile.h"
+#include "meshbvh.h"
+
+// Nível de detalhe (LOD) simplificado de um shape: outro intervalo do vetor
+// de índices, que utiliza os mesmos vértices do shape original (veja
+// MeshOpt_GenerateLods()).
+struct MeshLod
+{
+    size_t       first_index; // Posição do primeiro índice dentro de indices[]
+    size_t       num_indices; // Número de índices do nível
+    float        error;       // Erro geométrico máximo estimado, em coordenadas do modelo
+};
+
+// Um "shape" de um modelo: intervalo do vetor de índices que forma um objeto
+// nomeado da cena virtual (veja SceneObject em main.cpp).
+struct MeshShape
+{
+    std::string  name;        // Nome do objeto
+    size_t       first_index; // Posição do primeiro índice dentro de indices[]
+    size_t       num_indices; // Número de índices do objeto
+    glm::vec3    bbox_min;    // Axis-Aligned Bounding Box do objeto
+    glm::vec3    bbox_max;
+    std::vector<MeshLod> lods; // Níveis simplificados, do mais para o menos detalhado
+    MeshBvh      bvh;         // Hierarquia dos triângulos, para colisões (veja LoadMesh() em main.cpp)
+};
+
+// Formato compacto de um vértice, como é enviado para a GPU: um único buffer
+// com os atributos intercalados, 20 bytes por vértice (contra 40 bytes em
+// três buffers de floats). Veja "shader_vertex.glsl".
+struct PackedVertex
+{
+    float    position[3]; // X, Y, Z; W = 1 é implícito
+    uint32_t normal;      // Normal unitária em GL_INT_2_10_10_10_REV normalizado; W = 0
+    uint16_t texcoord[2]; // U, V em GL_HALF_FLOAT
+};
+
+// Atributos presentes em PackedVertex (a posição está sempre presente)
+#define MESHDATA_HAS_NORMALS   0x1
+#define MESHDATA_HAS_TEXCOORDS 0x2
+
+// Malha de triângulos de todos os shapes de um modelo. Os ponteiros abaixo
+// apontam ou para os vetores "*_storage", quando a malha é construída a partir
+// de um ObjModel, ou diretamente para um arquivo de cache mapeado em memória
+// (veja "meshcache.h"), o que evita qualquer cópia no carregamento.
+//
+// Os atributos em floats separados ("*_coefficients") são utilizados somente
+// durante a construção da malha (soldagem, reordenação, etc.; veja
+// "meshopt.h"), assim como os índices de 32 bits "indices", e não existem em
+// malhas lidas do cache. O que é enviado para a GPU são os vértices compactos
+// "packed_vertices" e os índices "packed_indices".
+struct MeshData
+{
+    const float*    model_coefficients;   // 4 floats (X,Y,Z,W) por vértice
+    const float*    normal_coefficients;  // 4 floats por vértice, ou NULL
+    const float*    texture_coefficients; // 2 floats por vértice, ou NULL
+    const PackedVertex* packed_vertices;  // Vértices compactos, veja MeshOpt_PackVertices()
+    uint32_t        vertex_attributes;    // MESHDATA_HAS_NORMALS | MESHDATA_HAS_TEXCOORDS
+    const uint32_t* indices;              // Índices de 32 bits
+    const void*     packed_indices;       // Índices enviados à GPU, veja MeshOpt_PackIndices()
+    size_t          index_size;           // Bytes por índice em packed_indices: 2 ou 4
+    size_t          num_vertices;
+    size_t          num_indices;
+
+    std::vector<MeshShape> shapes;
+
+    std::vector<float>    model_storage;
+    std::vector<float>    normal_storage;
+    std::vector<float>    texture_storage;
+    std::vector<PackedVertex> packed_storage;
+    std::vector<uint32_t> index_storage;
+    std::vector<uint16_t> packed_index_storage;
+    MappedFile            mapping;
+
+    MeshData()
+        : model_coefficients(NULL), normal_coefficients(NULL),
+          texture_coefficients(NULL), packed_vertices(NULL),
+          vertex_attributes(0), indices(NULL),
+          packed_indices(NULL), index_size(0),
+          num_vertices(0), num_indices(0)
+    {
+    }
+
+    // Faz os ponteiros apontarem para os vetores "*_storage". Fluxos de
+    // normais e coordenadas de textura que não cobrem todos os vértices são
+    // descartados.
+    void UseStorage()
+    {
+        num_vertices = model_storage.size() / 4;
+        num_indices  = index_storage.size();
+
+        model_coefficients   = model_storage.empty() ? NULL : model_storage.data();
+        normal_coefficients  = normal_storage.size() == 4*num_vertices && num_vertices > 0 ? normal_storage.data() : NULL;
+        texture_coefficients = texture_storage.size() == 2*num_vertices && num_vertices > 0 ? texture_storage.data() : NULL;
+        packed_vertices      = packed_storage.size() == num_vertices && num_vertices > 0 ? packed_storage.data() : NULL;
+        indices              = index_storage.empty() ? NULL : index_storage.data();
+    }
+
+private:
+    // Os ponteiros acima se referem ao próprio objeto, logo ele não pode ser copiado.
+    MeshData(const MeshData&);
+    MeshData& operator=(const MeshData&);
+};
+
+#endif // _MESHDATA_H
@@ -0,0 +1,43 @@
+#ifndef _MESHNORMALS_H
+#define _MESHNORMALS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "meshadjacency.h"
+
+// Cálculo das normais dos vértices de uma malha de triângulos, para modelos
+// ".obj" sem normais. É feito em duas etapas, ambas paralelas e sem
+// sincronização entre threads:
+//
+//   1. a normal de cada triângulo é calculada com produtos vetoriais SIMD,
+//      quatro triângulos por vez, e gravada na posição do triângulo;
+//
+//   2. cada vértice soma as normais dos triângulos de sua lista de
+//      adjacência (veja "meshadjacency.h") e a normaliza. Como cada thread
+//      escreve somente nos seus vértices, não há escrita concorrente, ao
+//      contrário de espalhar a normal de cada triângulo em seus três
+//      vértices.
+
+// Peso de cada triângulo na normal de um vértice
+#define MESHNORMALS_WEIGHT_AREA  0 // Proporcional à área (normal de Gouraud usual)
+#define MESHNORMALS_WEIGHT_ANGLE 1 // Proporcional ao ângulo do triângulo no vértice
+
+// Calcula as normais dos "num_vertices" vértices ("positions" com 3 floats
+// por vértice) dos triângulos "indices[0..num_indices)", cuja adjacência foi
+// construída por MeshAdjacency_Build(). "normals" recebe 3 floats por
+// vértice; vértices sem triângulos (ou só com triângulos degenerados)
+// recebem a normal nula.
+void MeshNormals_Compute(const float* positions, size_t num_vertices,
+                         const uint32_t* indices, size_t num_indices,
+                         const MeshAdjacency& adjacency, int weighting, float* normals);
+
+// Compara o tempo do cálculo anterior (serial, espalhando a normal de cada
+// triângulo nos seus vértices) com o de MeshAdjacency_Build() e
+// MeshNormals_Compute() para cada arquivo ".obj", verificando também a maior
+// diferença entre as normais. Imprime os resultados no terminal.
+void MeshNormals_Benchmark(const std::vector<std::string>& filenames, int repetitions = 5);
+
+#endif // _MESHNORMALS_H
@@ -0,0 +1,80 @@
+#ifndef _MESHOPT_H
+#define _MESHOPT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "meshdata.h"
+
+// Otimizações aplicadas às malhas antes de serem enviadas para a GPU (e
+// gravadas no cache, veja "meshcache.h").
+
+// Solda vértices com atributos idênticos (posição, normal e coordenada de
+// textura, considerando somente os fluxos presentes na malha), gerando um
+// vetor de índices que realmente compartilha vértices entre triângulos. Os
+// intervalos de índices dos shapes não mudam. O resultado fica nos vetores
+// "*_storage" da malha. Retorna o número de vértices resultante.
+size_t MeshOpt_WeldVertices(MeshData* mesh);
+
+// Número de vértices distintos referenciados pelos índices de um shape
+size_t MeshOpt_CountShapeVertices(const MeshData& mesh, const MeshShape& shape);
+
+// Tamanho da cache de vértices pós-transformação (FIFO) considerado pela
+// reordenação de triângulos e pelo cálculo do ACMR.
+#define MESHOPT_CACHE_SIZE 16
+
+// Reordena os triângulos de cada shape para aproveitar a cache de vértices
+// pós-transformação da GPU, utilizando o algoritmo "Tipsify" (Sander, Nehab
+// e Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw", 2007). Os triângulos continuam dentro do intervalo de índices de
+// seu shape.
+void MeshOpt_OptimizeVertexCache(MeshData* mesh, size_t cache_size = MESHOPT_CACHE_SIZE);
+
+// Reordena os vértices na ordem em que são usados pelos índices, para que as
+// leituras de atributos sejam sequenciais na memória. Vértices não
+// referenciados ficam no final.
+void MeshOpt_OptimizeVertexFetch(MeshData* mesh);
+
+// ACMR ("average cache miss ratio"): número médio de vértices transformados
+// por triângulo, simulando uma cache FIFO de "cache_size" vértices. Varia de
+// 3.0 (nenhum reaproveitamento) até cerca de 0.5 (malhas regulares ideais).
+float MeshOpt_ComputeACMR(const MeshData& mesh, const MeshShape& shape, size_t cache_size = MESHOPT_CACHE_SIZE);
+
+// Simplifica os triângulos "indices[0..num_indices)" por colapso de arestas
+// guiado por quádricas de erro (Garland e Heckbert, "Surface Simplification
+// Using Quadric Error Metrics", 1997), até restarem no máximo
+// "target_index_count" índices ou até que o próximo colapso tenha erro maior
+// que "max_error". Cada aresta é colapsada sobre um de seus vértices, logo o
+// resultado utiliza os mesmos vértices da malha. Vértices de borda e de
+// costuras (posições repetidas com normais ou coordenadas de textura
+// diferentes) não são movidos. Retorna o erro geométrico estimado do resultado.
+float MeshOpt_SimplifyQuadric(const MeshData& mesh, const uint32_t* indices, size_t num_indices,
+                              size_t target_index_count, float max_error, std::vector<uint32_t>* destination);
+
+// Parâmetros da cadeia de níveis de detalhe (veja MeshOpt_GenerateLods())
+#define MESHOPT_LOD_MAX_LEVELS    4     // Número máximo de níveis por shape
+#define MESHOPT_LOD_MIN_TRIANGLES 256   // Shapes e níveis menores não são simplificados
+#define MESHOPT_LOD_MAX_ERROR     0.05f // Erro máximo, relativo à diagonal da bounding box
+
+// Gera para cada shape uma cadeia de níveis de detalhe, cada um com cerca de
+// metade dos triângulos do anterior, armazenados em "lods" do shape. Os
+// índices dos níveis são adicionados ao final do vetor de índices. Deve ser
+// chamada após MeshOpt_WeldVertices() e antes das demais otimizações, que
+// também são aplicadas aos níveis.
+void MeshOpt_GenerateLods(MeshData* mesh);
+
+// Gera os vértices compactos (PackedVertex, veja "meshdata.h") a partir dos
+// atributos em floats da malha. Deve ser a última etapa da construção.
+void MeshOpt_PackVertices(MeshData* mesh);
+
+// Compacta um único vértice: "position" com 3 floats, e "normal" (3 floats,
+// normalizada aqui) e "texcoord" (2 floats) opcionais, que podem ser NULL.
+void MeshOpt_PackVertex(const float* position, const float* normal, const float* texcoord, PackedVertex* vertex);
+
+// Gera os índices enviados para a GPU: de 16 bits (GL_UNSIGNED_SHORT) se a
+// malha tiver no máximo 65536 vértices, ou os próprios índices de 32 bits
+// (GL_UNSIGNED_INT) caso contrário. Deve ser chamada após MeshOpt_PackVertices().
+void MeshOpt_PackIndices(MeshData* mesh);
+
+#endif // _MESHOPT_H
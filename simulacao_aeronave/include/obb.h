@@ -0,0 +1,60 @@
+#ifndef _OBB_H
+#define _OBB_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+// Caixas orientadas (OBB, Oriented Bounding Box) para os testes de colisão.
+// Ao contrário de transformar somente os cantos mínimo e máximo da bounding
+// box (que depois de uma rotação deixam de descrever a caixa), a OBB guarda o
+// centro, os três eixos unitários e as meias-dimensões ao longo de cada eixo
+// no sistema de coordenadas global.
+//
+// Os testes são feitos em lotes: uma OBB contra um conjunto de
+// OBBs guardadas por componente ("structure of arrays", ObbSet), quatro por
+// vez com SSE ou oito com AVX (se o compilador o habilitar), como em
+// "culling.h". O teste entre duas OBBs é o dos eixos separadores (SAT): as
+// caixas são disjuntas se e somente se as projeções em algum dos 15 eixos
+// candidatos (3 de cada caixa e os 9 produtos vetoriais entre eles) não se
+// sobrepõem. Veja Gottschalk et al., "OBBTree" (SIGGRAPH 1996).
+
+struct Obb
+{
+    glm::vec3 center;
+    glm::vec3 axes[3];   // Unitários e ortogonais
+    glm::vec3 extents;   // Meias-dimensões ao longo de cada eixo
+};
+
+// Conjunto de OBBs por componente: c[k] é a coordenada k dos centros, u[3*j +
+// k] a coordenada k do eixo j e e[j] a meia-dimensão ao longo do eixo j. Os
+// vetores são completados com caixas distantes até um múltiplo do tamanho do
+// lote.
+struct ObbSet
+{
+    std::vector<float> c[3];
+    std::vector<float> u[9];
+    std::vector<float> e[3];
+    size_t             count;
+};
+
+// OBB da bounding box [bbox_min, bbox_max] de um modelo transformada por
+// "model", que deve ser composta de rotações, translações e escalas
+// uniformes (ou escalas aplicadas antes das rotações).
+void Obb_FromModel(const glm::mat4& model, const glm::vec3& bbox_min, const glm::vec3& bbox_max, Obb* obb);
+
+// Menor coordenada y da caixa
+float Obb_LowestY(const Obb& obb);
+
+void ObbSet_Clear(ObbSet* set);
+
+// Acrescenta uma OBB ao conjunto e retorna seu índice
+size_t ObbSet_Add(ObbSet* set, const Obb& obb);
+
+// Grava em "overlap[i]" 1 se "obb" intercepta a OBB i do conjunto, e 0 caso
+// contrário. Retorna o número de interseções.
+size_t Obb_TestSet(const Obb& obb, const ObbSet& set, unsigned char* overlap);
+
+#endif // _OBB_H
@@ -0,0 +1,31 @@
+#ifndef _OBJLOADER_H
+#define _OBJLOADER_H
+
+#include <string>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+// Leitor paralelo de arquivos ".obj". O arquivo é mapeado em memória e
+// dividido em blocos alinhados em quebras de linha; cada bloco tem suas
+// linhas "v", "vn", "vt" e "f" interpretadas em uma thread diferente. Os
+// resultados de cada bloco são então concatenados, em ordem, nas mesmas
+// estruturas attrib_t/shape_t/material_t produzidas por tinyobj::LoadObj(),
+// respeitando as mesmas regras de divisão em shapes ("g", "o", "usemtl").
+//
+// Arquivos com recursos não suportados (por exemplo tags "t") são repassados
+// para tinyobj::LoadObj().
+bool ObjLoader_LoadParallel(tinyobj::attrib_t* attrib,
+                            std::vector<tinyobj::shape_t>* shapes,
+                            std::vector<tinyobj::material_t>* materials,
+                            std::string* err,
+                            const char* filename,
+                            const char* mtl_basepath = NULL,
+                            bool triangulate = true);
+
+// Compara o tempo de carregamento de tinyobj::LoadObj() e de
+// ObjLoader_LoadParallel() para cada arquivo, verificando também se os
+// resultados são equivalentes. Imprime os resultados no terminal.
+void ObjLoader_Benchmark(const std::vector<std::string>& filenames, int repetitions = 5);
+
+#endif // _OBJLOADER_H
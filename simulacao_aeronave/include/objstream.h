@@ -0,0 +1,58 @@
+#ifndef _OBJSTREAM_H
+#define _OBJSTREAM_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "meshdata.h"
+
+// Importação de arquivos ".obj" direto para os buffers da GPU, sem as
+// estruturas intermediárias attrib_t/shape_t da tinyobjloader nem os vetores
+// de floats de BuildTriangles(). O arquivo é lido duas vezes por
+// tinyobj::LoadObjWithCallback():
+//
+//   1. ObjStream_Open() guarda somente as posições, normais e coordenadas de
+//      textura (as linhas "v", "vn" e "vt", que podem ser referenciadas por
+//      qualquer face posterior), conta os vértices dos triângulos e divide as
+//      faces em shapes, com as mesmas regras de LoadObj(). Se o modelo não
+//      tiver normais, elas são acumuladas por posição, como em
+//      ComputeNormals() de main.cpp;
+//
+//   2. ObjStream_Write() converte cada triângulo para PackedVertex e grava
+//      os vértices e índices em lotes de OBJSTREAM_BATCH_VERTICES, copiados
+//      em sequência para a memória de destino (em geral um buffer da GPU
+//      mapeado por main.cpp).
+//
+// Assim a memória utilizada não depende do número de faces: além dos
+// atributos do arquivo, somente um lote fica na memória. Os vértices não são
+// soldados nem reordenados (veja "meshopt.h"), e o resultado não é gravado
+// no cache de malhas.
+#define OBJSTREAM_BATCH_VERTICES 4096
+
+struct ObjStream
+{
+    std::string        filename;
+    std::vector<float> positions; // 3 floats por linha "v"
+    std::vector<float> normals;   // 3 floats por linha "vn", ou por "v" se calculadas
+    std::vector<float> texcoords; // 2 floats por linha "vt"
+    bool               computed_normals;
+
+    // Somente os contadores, "vertex_attributes", "index_size" e os shapes
+    // (com bounding boxes) são preenchidos; os ponteiros ficam nulos.
+    MeshData           mesh;
+
+    ObjStream() : computed_normals(false) {}
+};
+
+// Primeira leitura de "filename". Retorna false em caso de erro, descrito em
+// "err".
+bool ObjStream_Open(const char* filename, bool compute_normals, ObjStream* stream, std::string* err);
+
+// Segunda leitura: grava stream->mesh.num_vertices vértices em "vertices" e
+// stream->mesh.num_indices índices de stream->mesh.index_size bytes em
+// "indices". Ao final os atributos guardados por ObjStream_Open() são
+// liberados.
+bool ObjStream_Write(ObjStream* stream, PackedVertex* vertices, void* indices, std::string* err);
+
+#endif // _OBJSTREAM_H
@@ -0,0 +1,77 @@
+#ifndef _RENDERQUEUE_H
+#define _RENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+
+// Fila de renderização. Em vez de alterar o estado da OpenGL e desenhar cada
+// objeto na ordem em que aparece em main(), o jogo submete pacotes de desenho
+// (RenderPacket) durante o quadro, e RenderQueue_Flush() os ordena por uma
+// chave de 64 bits:
+//
+//   bits 63-56  programa de GPU (índice de RenderQueue_SetProgram())
+//   bits 55-40  VAO
+//   bits 39-24  faixa de índices (objeto e nível de detalhe) dentro do VAO
+//   bits 23-0   distância até a câmera, da mais próxima para a mais distante
+//
+// Pacotes consecutivos com o mesmo programa, VAO e faixa de índices são
+// desenhados por um único glDrawElementsInstanced(): a matriz de modelagem e
+// o material (valor de "object_id" em shader_fragment.glsl, que escolhe as
+// texturas e a cor) de cada pacote são gravados em um buffer de instâncias,
+// lido pelo vertex shader como atributos por instância. Assim o número de
+// chamadas de desenho depende do número de malhas distintas, e não do
+// número de objetos. Dentro de cada grupo as instâncias ficam de frente para
+// trás, aproveitando o teste de profundidade; todos os objetos são opacos.
+//
+// Os uniforms ("view", "projection", etc.) são responsabilidade de quem
+// chama, antes de RenderQueue_Flush().
+#define RENDERQUEUE_MAX_PROGRAMS 256
+
+// Localizações dos atributos por instância nos shaders: a matriz de
+// modelagem ocupa quatro localizações, uma por coluna.
+#define RENDERQUEUE_INSTANCE_MODEL_LOCATION    3
+#define RENDERQUEUE_INSTANCE_MATERIAL_LOCATION 7
+
+struct RenderPacket
+{
+    int          program;        // Índice registrado com RenderQueue_SetProgram()
+    GLuint       vertex_array_object_id;
+    GLenum       rendering_mode;
+    GLenum       index_type;
+    int          num_indices;
+    void*        first_index;    // Deslocamento (em bytes) do primeiro índice
+    int          material;
+    glm::mat4    model;
+};
+
+// Contadores do último RenderQueue_Flush()
+struct RenderQueueStats
+{
+    size_t packets;          // Objetos (instâncias) desenhados
+    size_t draw_calls;       // glDrawElementsInstanced()
+    size_t program_changes;  // glUseProgram()
+    size_t vao_changes;      // glBindVertexArray()
+};
+
+// Registra o programa "program_id" no índice "program". Deve ser chamada
+// novamente se o programa for recriado.
+void RenderQueue_SetProgram(int program, GLuint program_id);
+
+// Acrescenta um pacote à fila. "depth" é a distância (não negativa) do
+// objeto até a câmera.
+void RenderQueue_Submit(const RenderPacket& packet, float depth);
+
+// Ordena e desenha todos os pacotes submetidos, esvaziando a fila. Ao final
+// o VAO 0 fica ligado e o último programa utilizado continua em uso.
+void RenderQueue_Flush();
+
+// Desenha imediatamente um pacote, como uma única instância, com o programa
+// atualmente em uso (o campo "program" é ignorado).
+void RenderQueue_Draw(const RenderPacket& packet);
+
+const RenderQueueStats& RenderQueue_Stats();
+
+#endif // _RENDERQUEUE_H
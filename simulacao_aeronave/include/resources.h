@@ -0,0 +1,81 @@
+#ifndef _RESOURCES_H
+#define _RESOURCES_H
+
+#include <cstddef>
+#include <cstdio>
+
+#include <glad/glad.h>
+
+// Gerenciador dos objetos da OpenGL (buffers, texturas, VAOs, samplers,
+// framebuffers e renderbuffers) e contabilidade da memória utilizada pelo
+// programa. Todo objeto é criado por Resource_Create(), pertence a um "dono"
+// (em geral o nome do arquivo de onde veio) e a uma categoria, e é destruído
+// explicitamente por Resource_Release(), Resource_ReleaseOwner() ou, ao final
+// do programa, Resource_ReleaseAll().
+//
+// A memória da GPU é estimada pelo tamanho nominal dos dados alocados
+// (Resource_SetGpuBytes()): o driver pode utilizar mais, por exemplo ao
+// guardar texturas RGB8 como RGBA8. A memória principal é informada por quem
+// a aloca (Resource_AddCpuBytes()), e deve ser descontada quando liberada;
+// assim é possível verificar que as cópias dos dados enviados para a GPU não
+// ficam na memória.
+//
+// Resource_AddCpuBytes() pode ser chamada por qualquer thread; as demais
+// funções somente pela thread dona do contexto OpenGL.
+
+enum ResourceCategory
+{
+    RESOURCE_MESHES,          // Buffers de vértices e índices, VAOs
+    RESOURCE_TEXTURES,        // Imagens de textura e seus samplers
+    RESOURCE_VIRTUAL_TEXTURE, // Cache de páginas e tabela de indireção (veja "vtexture.h")
+    RESOURCE_RENDER_TARGETS,  // Framebuffers, renderbuffers e pixel buffers
+    RESOURCE_TEXT,            // Fonte e vértices do texto na tela
+    RESOURCE_STREAMING,       // Dados escritos a cada quadro (veja "framering.h")
+    RESOURCE_NUM_CATEGORIES
+};
+
+enum ResourceType
+{
+    RESOURCE_BUFFER,
+    RESOURCE_TEXTURE,
+    RESOURCE_VERTEX_ARRAY,
+    RESOURCE_SAMPLER,
+    RESOURCE_FRAMEBUFFER,
+    RESOURCE_RENDERBUFFER,
+    RESOURCE_NUM_TYPES
+};
+
+// Cria um objeto (glGen*()) e o registra. Retorna seu identificador.
+GLuint Resource_Create(ResourceType type, ResourceCategory category, const char* owner);
+
+// Informa a memória da GPU ocupada pelo objeto, depois de alocá-la (por
+// exemplo com glBufferData() ou glTexImage2D()). Substitui o valor anterior.
+void Resource_SetGpuBytes(ResourceType type, GLuint id, size_t bytes);
+
+// Destrói um objeto (glDelete*()). Objetos não registrados são ignorados.
+void Resource_Release(ResourceType type, GLuint id);
+
+// Destrói todos os objetos de um dono, ou todos os objetos.
+void Resource_ReleaseOwner(const char* owner);
+void Resource_ReleaseAll();
+
+// Soma "bytes" (negativo ao liberar) à memória principal ocupada por dados
+// do dono "owner" na categoria "category".
+void Resource_AddCpuBytes(ResourceCategory category, const char* owner, ptrdiff_t bytes);
+
+// Totais atuais e máximos desde o início do programa, de uma categoria ou,
+// com RESOURCE_NUM_CATEGORIES, de todas.
+size_t Resource_GpuBytes(ResourceCategory category);
+size_t Resource_CpuBytes(ResourceCategory category);
+size_t Resource_PeakGpuBytes(ResourceCategory category);
+size_t Resource_PeakCpuBytes(ResourceCategory category);
+size_t Resource_NumObjects(ResourceCategory category);
+
+// Memória residente do processo (atual e máxima), segundo o sistema
+// operacional. Retorna false se não estiver disponível.
+bool Resource_ProcessMemory(size_t* resident, size_t* peak_resident);
+
+// Imprime as totalizações por categoria e por dono.
+void Resource_PrintReport(FILE* out);
+
+#endif // _RESOURCES_H
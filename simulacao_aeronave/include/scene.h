@@ -0,0 +1,69 @@
+#ifndef _SCENE_H
+#define _SCENE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/vec3.hpp>
+
+// Registro dos objetos da cena virtual. Cada nome de objeto é associado uma
+// única vez a um identificador inteiro (SceneHandle), em geral antes do laço
+// de renderização, e os objetos são guardados em vetores densos indexados por
+// ele. Assim o desenho de um objeto não constrói std::string nem percorre um
+// dicionário: basta indexar um vetor.
+//
+// Os dados lidos a cada quadro (SceneObject) ficam separados dos utilizados
+// somente na carga ou em depuração (os nomes), e os níveis de detalhe de
+// todos os objetos ficam em um único vetor.
+//
+// Um identificador pode ser obtido antes de o objeto ser carregado (veja
+// "assetloader.h"): Scene_Get() retorna NULL até que Scene_Set() seja chamada
+// para ele. Todas as funções devem ser chamadas pela thread principal.
+typedef int SceneHandle;
+#define SCENE_INVALID_HANDLE (-1)
+
+// Nível de detalhe simplificado de um objeto da cena virtual (veja
+// MeshOpt_GenerateLods() e SelectLod() em main.cpp).
+struct SceneObjectLod
+{
+    void*        first_index; // Primeiro índice do nível (em bytes), no mesmo buffer do objeto
+    int          num_indices;
+    float        error;       // Erro geométrico, em coordenadas do modelo
+};
+
+// Dados necessários para renderizar cada objeto da cena virtual.
+struct SceneObject
+{
+    GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo (0 se ainda não carregado)
+    GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
+    GLenum       index_type;  // Tipo dos índices: GL_UNSIGNED_SHORT (até 65536 vértices no VAO) ou GL_UNSIGNED_INT
+    int          num_indices; // Número de índices do objeto no buffer de índices do VAO
+    void*        first_index; // Deslocamento (em bytes) do primeiro índice do objeto
+    int          first_lod;   // Níveis de detalhe: Scene_Lods(), do mais para o menos detalhado
+    int          num_lods;
+    glm::vec3    bbox_min;    // Axis-Aligned Bounding Box do objeto
+    glm::vec3    bbox_max;
+};
+
+// Retorna o identificador do objeto "name", registrando-o se necessário.
+SceneHandle Scene_Handle(const char* name);
+
+// Idem, sem registrar: retorna SCENE_INVALID_HANDLE se o nome for desconhecido.
+SceneHandle Scene_Find(const char* name);
+
+// Define (ou substitui) os dados do objeto "handle" e seus níveis de detalhe.
+// Os campos first_lod e num_lods de "object" são ignorados.
+void Scene_Set(SceneHandle handle, const SceneObject& object, const std::vector<SceneObjectLod>& lods);
+
+// Dados do objeto "handle", ou NULL se o identificador for inválido ou o
+// objeto ainda não tiver sido carregado.
+const SceneObject* Scene_Get(SceneHandle handle);
+
+// Primeiro nível de detalhe de um objeto (são object.num_lods consecutivos).
+const SceneObjectLod* Scene_Lods(const SceneObject& object);
+
+const char* Scene_Name(SceneHandle handle);
+size_t Scene_NumObjects();
+
+#endif // _SCENE_H
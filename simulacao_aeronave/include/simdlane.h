@@ -0,0 +1,82 @@
+#ifndef _SIMDLANE_H
+#define _SIMDLANE_H
+
+#include <cmath>
+#include <algorithm>
+
+// Operações sobre um lote de LANE_WIDTH floats (uma "Lane"), para que os
+// testes de colisão em lotes ("obb.cpp", "sweep.cpp") sejam escritos uma
+// única vez: oito por vez com AVX (se o compilador o habilitar), quatro com
+// SSE, ou um de cada vez. As comparações retornam máscaras com todos os bits
+// em 1 (ou 1.0f, sem SIMD) nas posições verdadeiras, e LaneMask() as
+// converte em um inteiro com um bit por posição.
+//
+// Deve ser incluído somente por arquivos ".cpp".
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LANE_WIDTH 8
+typedef __m256 Lane;
+static inline Lane LaneLoad(const float* p)          { return _mm256_loadu_ps(p); }
+static inline void LaneStore(float* p, Lane a)       { _mm256_storeu_ps(p, a); }
+static inline Lane LaneSet(float x)                  { return _mm256_set1_ps(x); }
+static inline Lane LaneAdd(Lane a, Lane b)           { return _mm256_add_ps(a, b); }
+static inline Lane LaneSub(Lane a, Lane b)           { return _mm256_sub_ps(a, b); }
+static inline Lane LaneMul(Lane a, Lane b)           { return _mm256_mul_ps(a, b); }
+static inline Lane LaneDiv(Lane a, Lane b)           { return _mm256_div_ps(a, b); }
+static inline Lane LaneMin(Lane a, Lane b)           { return _mm256_min_ps(a, b); }
+static inline Lane LaneMax(Lane a, Lane b)           { return _mm256_max_ps(a, b); }
+static inline Lane LaneSqrt(Lane a)                  { return _mm256_sqrt_ps(a); }
+static inline Lane LaneAbs(Lane a)                   { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline Lane LaneGreater(Lane a, Lane b)       { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline Lane LaneLessEqual(Lane a, Lane b)     { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline Lane LaneOr(Lane a, Lane b)            { return _mm256_or_ps(a, b); }
+static inline Lane LaneAnd(Lane a, Lane b)           { return _mm256_and_ps(a, b); }
+static inline Lane LaneSelect(Lane m, Lane a, Lane b) { return _mm256_blendv_ps(b, a, m); }
+static inline int  LaneMask(Lane a)                  { return _mm256_movemask_ps(a); }
+static inline Lane LaneFalse()                       { return _mm256_setzero_ps(); }
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define LANE_WIDTH 4
+typedef __m128 Lane;
+static inline Lane LaneLoad(const float* p)          { return _mm_loadu_ps(p); }
+static inline void LaneStore(float* p, Lane a)       { _mm_storeu_ps(p, a); }
+static inline Lane LaneSet(float x)                  { return _mm_set1_ps(x); }
+static inline Lane LaneAdd(Lane a, Lane b)           { return _mm_add_ps(a, b); }
+static inline Lane LaneSub(Lane a, Lane b)           { return _mm_sub_ps(a, b); }
+static inline Lane LaneMul(Lane a, Lane b)           { return _mm_mul_ps(a, b); }
+static inline Lane LaneDiv(Lane a, Lane b)           { return _mm_div_ps(a, b); }
+static inline Lane LaneMin(Lane a, Lane b)           { return _mm_min_ps(a, b); }
+static inline Lane LaneMax(Lane a, Lane b)           { return _mm_max_ps(a, b); }
+static inline Lane LaneSqrt(Lane a)                  { return _mm_sqrt_ps(a); }
+static inline Lane LaneAbs(Lane a)                   { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline Lane LaneGreater(Lane a, Lane b)       { return _mm_cmpgt_ps(a, b); }
+static inline Lane LaneLessEqual(Lane a, Lane b)     { return _mm_cmple_ps(a, b); }
+static inline Lane LaneOr(Lane a, Lane b)            { return _mm_or_ps(a, b); }
+static inline Lane LaneAnd(Lane a, Lane b)           { return _mm_and_ps(a, b); }
+static inline Lane LaneSelect(Lane m, Lane a, Lane b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+static inline int  LaneMask(Lane a)                  { return _mm_movemask_ps(a); }
+static inline Lane LaneFalse()                       { return _mm_setzero_ps(); }
+#else
+#define LANE_WIDTH 1
+typedef float Lane;
+static inline Lane LaneLoad(const float* p)          { return *p; }
+static inline void LaneStore(float* p, Lane a)       { *p = a; }
+static inline Lane LaneSet(float x)                  { return x; }
+static inline Lane LaneAdd(Lane a, Lane b)           { return a + b; }
+static inline Lane LaneSub(Lane a, Lane b)           { return a - b; }
+static inline Lane LaneMul(Lane a, Lane b)           { return a * b; }
+static inline Lane LaneDiv(Lane a, Lane b)           { return a / b; }
+static inline Lane LaneMin(Lane a, Lane b)           { return std::min(a, b); }
+static inline Lane LaneMax(Lane a, Lane b)           { return std::max(a, b); }
+static inline Lane LaneSqrt(Lane a)                  { return sqrtf(a); }
+static inline Lane LaneAbs(Lane a)                   { return fabsf(a); }
+static inline Lane LaneGreater(Lane a, Lane b)       { return (a > b) ? 1.0f : 0.0f; }
+static inline Lane LaneLessEqual(Lane a, Lane b)     { return (a <= b) ? 1.0f : 0.0f; }
+static inline Lane LaneOr(Lane a, Lane b)            { return std::max(a, b); }
+static inline Lane LaneAnd(Lane a, Lane b)           { return std::min(a, b); }
+static inline Lane LaneSelect(Lane m, Lane a, Lane b) { return (m != 0.0f) ? a : b; }
+static inline int  LaneMask(Lane a)                  { return (a != 0.0f) ? 1 : 0; }
+static inline Lane LaneFalse()                       { return 0.0f; }
+#endif
+
+#endif // _SIMDLANE_H
@@ -0,0 +1,52 @@
+#ifndef _SPATIALGRID_H
+#define _SPATIALGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// Grade uniforme com hash espacial, para encontrar rapidamente quais esferas
+// (os alvos) podem conter um ponto ou interceptar uma esfera pequena (os
+// tiros). O espaço é dividido em células cúbicas de lado "cell_size", e cada
+// célula (ix, iy, iz) é associada por uma função de hash a um de
+// "num_buckets" baldes; assim a grade não tem limites e ocupa memória
+// proporcional ao número de objetos, não ao volume da cena.
+//
+// A grade é reconstruída a cada passo por SpatialGrid_Build(), com uma
+// ordenação por contagem: conta quantos alvos caem em cada balde, calcula as
+// somas prefixadas e espalha os índices dos alvos em um único vetor, já
+// agrupados por balde. Não há listas encadeadas nem alocações depois que os
+// vetores atingem seu tamanho máximo.
+//
+// Cada alvo é colocado somente na célula do seu centro, e o lado das células
+// é pelo menos o diâmetro do maior alvo. Uma consulta examina as células a
+// menos de "raio da consulta + maior raio" do ponto: no máximo 2x2x2 células
+// para consultas pontuais. As consultas retornam candidatos (alvos em baldes
+// próximos, inclusive por colisão do hash); o teste exato fica com quem chama.
+struct SpatialGrid
+{
+    float                 cell_size;
+    float                 max_radius;     // Maior raio entre os alvos
+    uint32_t              bucket_mask;    // Número de baldes - 1 (potência de 2)
+    std::vector<uint32_t> bucket_start;   // Primeira posição de cada balde em "objects", mais o total
+    std::vector<uint32_t> objects;        // Índices dos alvos, agrupados por balde
+    std::vector<uint32_t> object_bucket;  // Balde de cada alvo (auxiliar de SpatialGrid_Build())
+};
+
+// Reconstrói a grade com os alvos "spheres[0..count)": centro em xyz e raio
+// em w. Se "cell_size" for 0, utiliza o diâmetro do maior alvo.
+void SpatialGrid_Build(SpatialGrid* grid, const glm::vec4* spheres, size_t count, float cell_size = 0.0f);
+
+// Acrescenta a "candidates" os índices dos alvos que podem interceptar a
+// esfera de centro "point" e raio "radius" (0 para um ponto), sem repetições.
+void SpatialGrid_Query(const SpatialGrid& grid, const glm::vec3& point, float radius, std::vector<uint32_t>* candidates);
+
+// Simula "num_projectiles" tiros contra "num_targets" alvos em movimento,
+// reconstruindo a grade e consultando-a a cada passo, e compara o tempo e os
+// acertos com o teste de todos os pares. Imprime os resultados no terminal.
+void SpatialGrid_Benchmark(int num_projectiles = 10000, int num_targets = 1000, int steps = 120);
+
+#endif // _SPATIALGRID_H
@@ -0,0 +1,73 @@
+#ifndef _SWEEP_H
+#define _SWEEP_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "obb.h"
+
+// Detecção contínua de colisões dos tiros. Um tiro rápido percorre, em um
+// quadro, uma distância maior que o tamanho dos alvos, e testar somente a sua
+// posição ao final do quadro deixa-o atravessar os alvos ("tunneling"),
+// tanto mais quanto menor a taxa de quadros.
+//
+// Aqui o tiro é uma esfera que se move em linha reta de "from" a "to"
+// durante o quadro, e cada alvo também se move em linha reta (sem girar) da
+// sua posição no início do quadro à do final. O movimento relativo é então
+// linear, e o instante de impacto (TOI, "time of impact") é a menor fração t
+// do quadro, em [0, 1], em que as duas formas se tocam:
+//
+//   - esfera contra esfera: raiz de uma equação de segundo grau;
+//
+//   - esfera contra caixa orientada: o segmento relativo, no sistema de
+//     coordenadas da caixa, contra a caixa aumentada do raio da esfera
+//     (teste das "fatias"). Nos cantos e arestas essa caixa é um pouco
+//     maior que a soma exata (caixa com cantos arredondados), no máximo
+//     (sqrt(3) - 1) vezes o raio, o que é desprezível para os tiros e ainda
+//     é seguido do teste com a malha (veja "meshbvh.h").
+//
+// Os alvos ficam guardados por componente, como em "obb.h", e são testados
+// em lotes de LANE_WIDTH (veja "simdlane.h").
+
+// Valor de TOI dos alvos que não são atingidos durante o quadro
+#define SWEEP_NO_HIT 2.0f
+
+// Esferas em movimento: c[k] é a coordenada k do centro no início do quadro,
+// d[k] a do deslocamento durante o quadro e r o raio.
+struct MovingSphereSet
+{
+    std::vector<float> c[3];
+    std::vector<float> d[3];
+    std::vector<float> r;
+    size_t             count;
+};
+
+// Caixas orientadas em movimento: as caixas no início do quadro e os
+// deslocamentos dos seus centros durante o quadro.
+struct MovingObbSet
+{
+    ObbSet             boxes;
+    std::vector<float> d[3];
+};
+
+void MovingSphereSet_Clear(MovingSphereSet* set);
+
+// Acrescenta uma esfera de raio "radius" que vai de "start" a "end" durante
+// o quadro, e retorna seu índice.
+size_t MovingSphereSet_Add(MovingSphereSet* set, const glm::vec3& start, const glm::vec3& end, float radius);
+
+void MovingObbSet_Clear(MovingObbSet* set);
+
+// Acrescenta a caixa "start", cujo centro vai até "end_center" durante o
+// quadro, e retorna seu índice.
+size_t MovingObbSet_Add(MovingObbSet* set, const Obb& start, const glm::vec3& end_center);
+
+// Grava em "toi[i]" o instante de impacto da esfera de raio "radius", que vai
+// de "from" a "to", com o alvo i (0 se já se tocam no início do quadro), ou
+// SWEEP_NO_HIT. Retorna o número de alvos atingidos.
+size_t Sweep_SphereVsSpheres(const glm::vec3& from, const glm::vec3& to, float radius, const MovingSphereSet& set, float* toi);
+size_t Sweep_SphereVsObbs(const glm::vec3& from, const glm::vec3& to, float radius, const MovingObbSet& set, float* toi);
+
+#endif // _SWEEP_H
@@ -0,0 +1,45 @@
+#ifndef _TEXCOMPRESS_H
+#define _TEXCOMPRESS_H
+
+#include "texturecache.h"
+
+// Compressão de texturas nos formatos de blocos S3TC, suportados pelas GPUs
+// através da extensão GL_EXT_texture_compression_s3tc:
+//
+//   - BC1 (DXT1): blocos de 4x4 pixels RGB em 8 bytes, com duas cores de
+//     referência em RGB565 e um índice de 2 bits por pixel, que escolhe entre
+//     as referências e duas cores interpoladas. 6 vezes menor que RGB8;
+//
+//   - BC3 (DXT5): bloco de cor igual ao BC1, mais um bloco de alpha de 8
+//     bytes (dois valores de referência e um índice de 3 bits por pixel). 4
+//     vezes menor que RGBA8.
+//
+// Os blocos são comprimidos em paralelo, dividindo as linhas de blocos de
+// cada nível entre os núcleos da máquina.
+
+// Compromisso entre qualidade e velocidade da compressão
+#define TEXCOMPRESS_QUALITY_FAST   0 // Cores de referência pela bounding box das cores do bloco
+#define TEXCOMPRESS_QUALITY_NORMAL 1 // Eixo principal das cores e um refinamento por mínimos quadrados
+#define TEXCOMPRESS_QUALITY_BEST   2 // Vários refinamentos, e ambos os modos dos blocos de alpha
+
+// Comprime um nível RGB ou RGBA ("channels" = 3 ou 4; alpha é ignorado) em
+// BC1. "out" deve ter TextureCache_LevelSize(TEXTURE_FORMAT_BC1, ...) bytes.
+void TexCompress_EncodeBC1(const unsigned char* pixels, int channels, int width, int height, int quality, unsigned char* out);
+
+// Comprime um nível RGBA em BC3. "out" deve ter
+// TextureCache_LevelSize(TEXTURE_FORMAT_BC3, ...) bytes.
+void TexCompress_EncodeBC3(const unsigned char* rgba, int width, int height, int quality, unsigned char* out);
+
+// Descomprime um nível BC1 ou BC3 para RGBA (4 bytes por pixel)
+void TexCompress_Decode(uint32_t format, const unsigned char* blocks, int width, int height, unsigned char* rgba);
+
+// PSNR (em dB) dos canais RGB de "compressed" (BC1 ou BC3) em relação a
+// "original" (RGB8 ou RGBA8). Retorna infinito se as imagens forem iguais.
+float TexCompress_PSNR(const TextureLevel& original, uint32_t original_format,
+                       const TextureLevel& compressed, uint32_t compressed_format);
+
+// Comprime todos os níveis de uma textura: RGB8 para BC1 e RGBA8 para BC3.
+// Retorna o PSNR do nível 0 (veja TexCompress_PSNR()).
+float TexCompress_CompressTexture(TextureData* texture, int quality);
+
+#endif // _TEXCOMPRESS_H
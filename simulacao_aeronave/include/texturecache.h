@@ -0,0 +1,96 @@
+#ifndef _TEXTURECACHE_H
+#define _TEXTURECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+
+// Número máximo de níveis de mipmap (texturas de até 32768x32768)
+#define TEXTURE_MAX_LEVELS 16
+
+// Formato dos pixels de uma textura. Os formatos sem compressão têm linhas
+// sem preenchimento (GL_UNPACK_ALIGNMENT = 1); os comprimidos são formados
+// por blocos de 4x4 pixels (veja "texcompress.h"). A primeira linha (ou linha
+// de blocos) é a de baixo.
+#define TEXTURE_FORMAT_RGB8  0 // 3 bytes por pixel, sRGB
+#define TEXTURE_FORMAT_RGBA8 1 // 4 bytes por pixel, sRGB com alpha linear
+#define TEXTURE_FORMAT_BC1   2 // 8 bytes por bloco (S3TC DXT1), sRGB
+#define TEXTURE_FORMAT_BC3   3 // 16 bytes por bloco (S3TC DXT5), sRGB com alpha linear
+
+// Tamanho em bytes de um nível de "width" x "height" pixels no formato dado
+size_t TextureCache_LevelSize(uint32_t format, int width, int height);
+
+// Um nível de mipmap
+struct TextureLevel
+{
+    int                  width;
+    int                  height;
+    const unsigned char* data;
+    size_t               size; // Bytes do nível
+};
+
+// Imagem de textura com a cadeia de mipmaps completa, pronta para ser
+// enviada para a GPU nível a nível. Assim como em MeshData, os níveis apontam
+// ou para "storage", quando a cadeia é gerada por TextureCache_BuildMipmaps(),
+// ou diretamente para um arquivo de cache mapeado em memória.
+struct TextureData
+{
+    int                        width;
+    int                        height;
+    uint32_t                   format; // TEXTURE_FORMAT_*
+    std::vector<TextureLevel>  levels;
+
+    std::vector<unsigned char> storage;
+    MappedFile                 mapping;
+
+    TextureData() : width(0), height(0), format(TEXTURE_FORMAT_RGB8) {}
+
+private:
+    // Os níveis apontam para o próprio objeto, logo ele não pode ser copiado.
+    TextureData(const TextureData&);
+    TextureData& operator=(const TextureData&);
+};
+
+// Gera a cadeia de mipmaps de uma imagem RGB ou RGBA ("channels" = 3 ou 4,
+// cores no espaço sRGB) até o nível 1x1. Cada nível é a média de blocos 2x2
+// (ou 3x3 / 2x3 em dimensões ímpares) do anterior, calculada em espaço
+// linear, como a GPU faria ao amostrar uma textura GL_SRGB8.
+void TextureCache_BuildMipmaps(const unsigned char* pixels, int width, int height, int channels, TextureData* texture);
+
+// Cache binário de texturas. Depois que uma imagem ".jpg" (ou outro formato
+// lido pela stb_image) é decodificada e sua cadeia de mipmaps é gerada, o
+// resultado é gravado em "<arquivo>.texcache". Nas execuções seguintes o
+// cache é mapeado em memória e os níveis são enviados para a GPU diretamente
+// do arquivo, sem decodificação nem glGenerateMipmap().
+//
+// O cache é descartado se:
+//   - a versão do formato (TEXTURECACHE_VERSION) mudou;
+//   - o tamanho ou a data de modificação do arquivo fonte mudou;
+//   - as opções de construção ("flags") são diferentes.
+//
+// Layout do arquivo (todas as seções alinhadas em 16 bytes):
+//
+//   TextureCacheHeader
+//   TextureCacheLevel[num_levels]
+//   pixels de cada nível, do maior para o menor
+//
+#define TEXTURECACHE_VERSION 2
+
+// Opções de construção que alteram o conteúdo do cache
+#define TEXTURECACHE_FLAG_COMPRESSED  0x1 // Níveis em BC1/BC3, veja "texcompress.h"
+#define TEXTURECACHE_QUALITY_SHIFT    8   // Bits 8-15: qualidade da compressão
+
+std::string TextureCache_PathFor(const char* source_filename);
+
+// Tenta mapear o cache de "source_filename". Retorna false se o cache não
+// existir, estiver desatualizado ou corrompido; neste caso "texture" não é
+// alterada.
+bool TextureCache_Load(const char* source_filename, uint32_t flags, TextureData* texture);
+
+// Grava o cache de "source_filename" a partir de uma textura com mipmaps.
+bool TextureCache_Save(const char* source_filename, uint32_t flags, const TextureData& texture);
+
+#endif // _TEXTURECACHE_H
@@ -0,0 +1,136 @@
+#ifndef _VTEXTURE_H
+#define _VTEXTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mappedfile.h"
+
+// Textura virtual esparsa, para imagens aéreas grandes demais para uma única
+// textura da GPU. A imagem (com sua cadeia de mipmaps) é dividida em páginas
+// de VTEX_PAGE_SIZE x VTEX_PAGE_SIZE texels, gravadas em um arquivo
+// "<imagem>.vtex" que é mapeado em memória. Na GPU ficam somente:
+//
+//   - um cache físico de páginas: uma textura com VTEX_CACHE_SLOTS x
+//     VTEX_CACHE_SLOTS posições ("slots"), cada uma com uma página e sua
+//     borda de VTEX_PAGE_BORDER texels (para a filtragem bilinear não
+//     misturar páginas vizinhas);
+//
+//   - uma tabela de indireção: uma textura RGBA8 com mipmaps, com um texel
+//     por página de cada nível, que indica o slot (R, G) e o nível (B) da
+//     página residente mais detalhada que cobre aquela página.
+//
+// A cada quadro a GPU escreve, em uma passada de "feedback" de baixa
+// resolução, as páginas de que precisa; essas são lidas pela CPU e entregues
+// a VirtualTexture_ProcessFeedback(), que as marca como utilizadas e agenda
+// as que faltam. Este módulo não chama a OpenGL: o envio das páginas e da
+// tabela é feito em "main.cpp".
+//
+// O nível 0 tem VTEX_MAX_PAGES páginas por lado no máximo (imagens de até
+// 32768x32768 texels), para que as coordenadas de página caibam em um byte.
+
+#define VTEX_PAGE_SIZE   128
+#define VTEX_PAGE_BORDER 4
+#define VTEX_PAGE_STRIDE (VTEX_PAGE_SIZE + 2*VTEX_PAGE_BORDER) // Lado de uma página com as bordas
+#define VTEX_MAX_PAGES   256
+#define VTEX_MAX_LEVELS  9
+#define VTEX_CACHE_SLOTS 16 // Slots por lado do cache físico
+
+// Layout do arquivo (todas as seções alinhadas em 16 bytes):
+//
+//   VirtualTextureHeader
+//   uint64_t page_offsets[num_pages] (0 = página vazia, fora da imagem)
+//   texels de cada página não vazia, nível a nível, linha a linha
+//
+// As opções de construção são as mesmas do cache de texturas
+// (TEXTURECACHE_FLAG_COMPRESSED e TEXTURECACHE_QUALITY_SHIFT, veja
+// "texturecache.h"): com compressão as páginas são gravadas em BC1.
+#define VTEX_VERSION 1
+
+// Uma página da textura virtual
+struct VirtualTexturePage
+{
+    int level;
+    int x;
+    int y;
+};
+
+struct VirtualTexture
+{
+    int      width;      // Dimensões da imagem fonte
+    int      height;
+    int      pages;      // Páginas por lado no nível 0 (potência de 2)
+    int      num_levels; // Níveis, até o que tem uma única página
+    uint32_t format;     // TEXTURE_FORMAT_RGB8 ou TEXTURE_FORMAT_BC1
+    size_t   page_size;  // Bytes de uma página com bordas
+
+    std::vector<uint64_t> page_offsets; // Veja VirtualTexture_PageIndex()
+    MappedFile            mapping;
+
+    VirtualTexture() : width(0), height(0), pages(0), num_levels(0), format(0), page_size(0) {}
+
+private:
+    VirtualTexture(const VirtualTexture&);
+    VirtualTexture& operator=(const VirtualTexture&);
+};
+
+// Páginas por lado do nível "level"
+int VirtualTexture_PagesAt(const VirtualTexture& vt, int level);
+
+// Índice de uma página em "page_offsets": níveis em sequência, do mais
+// detalhado para o menos, e em cada nível linha a linha, de baixo para cima.
+size_t VirtualTexture_PageIndex(const VirtualTexture& vt, int level, int x, int y);
+
+// Número total de páginas, em todos os níveis
+size_t VirtualTexture_NumPages(const VirtualTexture& vt);
+
+// Texels de uma página (VTEX_PAGE_STRIDE x VTEX_PAGE_STRIDE, com bordas), ou
+// NULL se a página estiver inteiramente fora da imagem.
+const unsigned char* VirtualTexture_PageData(const VirtualTexture& vt, int level, int x, int y);
+
+std::string VirtualTexture_PathFor(const char* source_filename);
+
+// Mapeia as páginas de "source_filename". Retorna false se o arquivo não
+// existir, estiver desatualizado (mesmos critérios de TextureCache_Load()) ou
+// corrompido.
+bool VirtualTexture_Load(const char* source_filename, uint32_t flags, VirtualTexture* vt);
+
+// Divide uma imagem RGB (primeira linha embaixo) em páginas e grava o
+// arquivo de "source_filename".
+bool VirtualTexture_Build(const char* source_filename, uint32_t flags, const unsigned char* pixels, int width, int height);
+
+// Estado do cache físico de páginas e da tabela de indireção
+struct VirtualTextureCache
+{
+    int                             slots;          // Slots por lado
+    std::vector<VirtualTexturePage> slot_pages;     // Página em cada slot (level = -1 se livre)
+    std::vector<uint32_t>           slot_last_used; // Último quadro em que o slot foi utilizado
+    std::vector<int>                page_slots;     // Slot de cada página, ou -1
+    std::vector<uint32_t>           page_requested; // Último quadro em que a página foi pedida
+    std::vector<VirtualTexturePage> requests;       // Páginas pedidas e não residentes, as menos detalhadas primeiro
+    std::vector<unsigned char>      indirection;    // RGBA por página, na ordem de VirtualTexture_PageIndex()
+    uint32_t                        frame;
+    bool                            indirection_dirty;
+};
+
+// Inicializa o cache com "slots" x "slots" posições, todas livres
+void VirtualTexture_InitCache(const VirtualTexture& vt, int slots, VirtualTextureCache* cache);
+
+// Processa a saída da passada de feedback: "num_pixels" texels RGBA8, cada um
+// com (x, y, nível + 1) de uma página, ou nível zero se nenhuma. As páginas
+// pedidas e as que as contêm nos níveis menos detalhados são marcadas como
+// utilizadas neste quadro; as não residentes são agendadas em "requests".
+void VirtualTexture_ProcessFeedback(const VirtualTexture& vt, VirtualTextureCache* cache, const unsigned char* pixels, size_t num_pixels);
+
+// Reserva um slot para "page", liberando o usado há mais tempo se necessário
+// (nunca um utilizado no quadro atual, nem o da página do último nível).
+// Retorna o slot, ou -1 se todos estiverem em uso.
+int VirtualTexture_AllocateSlot(const VirtualTexture& vt, VirtualTextureCache* cache, const VirtualTexturePage& page);
+
+// Recalcula a tabela de indireção, se alguma página entrou ou saiu do cache
+// desde a última chamada. Retorna true se a tabela mudou.
+bool VirtualTexture_UpdateIndirection(const VirtualTexture& vt, VirtualTextureCache* cache);
+
+#endif // _VTEXTURE_H
@@ -0,0 +1,453 @@
+// Árvore dinâmica de AABBs. Veja "include/aabbtree.h".
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <glm/common.hpp>
+
+#include "aabbtree.h"
+
+// Capacidade das pilhas das consultas. Uma busca em profundidade guarda no
+// máximo um nó por nível, mais um, e as rotações mantêm a altura próxima de
+// log2(n).
+#define AABBTREE_STACK_SIZE 256
+
+static float SurfaceArea(const glm::vec3& min, const glm::vec3& max)
+{
+    const glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static bool Contains(const AabbTreeNode& node, const glm::vec3& min, const glm::vec3& max)
+{
+    return node.min.x <= min.x && node.min.y <= min.y && node.min.z <= min.z
+        && max.x <= node.max.x && max.y <= node.max.y && max.z <= node.max.z;
+}
+
+static bool Overlaps(const AabbTreeNode& node, const glm::vec3& min, const glm::vec3& max)
+{
+    return node.min.x <= max.x && min.x <= node.max.x
+        && node.min.y <= max.y && min.y <= node.max.y
+        && node.min.z <= max.z && min.z <= node.max.z;
+}
+
+static int AllocateNode(AabbTree* tree)
+{
+    if (tree->free_list == AABBTREE_NULL)
+    {
+        AabbTreeNode node;
+        node.parent = AABBTREE_NULL;
+        tree->nodes.push_back(node);
+        tree->free_list = (int)tree->nodes.size() - 1;
+    }
+
+    const int index = tree->free_list;
+    AabbTreeNode& node = tree->nodes[index];
+    tree->free_list = node.parent;
+    node.parent = AABBTREE_NULL;
+    node.child1 = AABBTREE_NULL;
+    node.child2 = AABBTREE_NULL;
+    node.height = 0;
+    node.user   = 0;
+    return index;
+}
+
+static void FreeNode(AabbTree* tree, int index)
+{
+    tree->nodes[index].parent = tree->free_list;
+    tree->nodes[index].height = -1;
+    tree->free_list = index;
+}
+
+// Recalcula a caixa e a altura de um nó interno a partir dos filhos
+static void FitNode(AabbTree* tree, int index)
+{
+    AabbTreeNode& node = tree->nodes[index];
+    const AabbTreeNode& child1 = tree->nodes[node.child1];
+    const AabbTreeNode& child2 = tree->nodes[node.child2];
+    node.min = glm::min(child1.min, child2.min);
+    node.max = glm::max(child1.max, child2.max);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+// Se as alturas dos filhos de "a" diferirem de mais de 1, promove o filho
+// mais alto ao lugar de "a" (uma rotação). Retorna o nó que ocupa a posição
+// de "a" ao final.
+static int Balance(AabbTree* tree, int a)
+{
+    std::vector<AabbTreeNode>& nodes = tree->nodes;
+    if (nodes[a].child1 == AABBTREE_NULL || nodes[a].height < 2)
+        return a;
+
+    const int b = nodes[a].child1;
+    const int c = nodes[a].child2;
+    const int balance = nodes[c].height - nodes[b].height;
+    if (balance >= -1 && balance <= 1)
+        return a;
+
+    // "up" é o filho mais alto, que sobe; "down" é o outro filho de "a"
+    const int up   = (balance > 1) ? c : b;
+    const int down = (balance > 1) ? b : c;
+    const int f = nodes[up].child1;
+    const int g = nodes[up].child2;
+
+    // "up" toma o lugar de "a" no pai
+    nodes[up].child1 = a;
+    nodes[up].parent = nodes[a].parent;
+    nodes[a].parent = up;
+    if (nodes[up].parent != AABBTREE_NULL)
+    {
+        AabbTreeNode& parent = nodes[nodes[up].parent];
+        if (parent.child1 == a)
+            parent.child1 = up;
+        else
+            parent.child2 = up;
+    }
+    else
+    {
+        tree->root = up;
+    }
+
+    // O neto mais alto fica com "up"; o outro desce para "a", junto de "down"
+    const int keep = (nodes[f].height > nodes[g].height) ? f : g;
+    const int move = (keep == f) ? g : f;
+    nodes[up].child2 = keep;
+    nodes[a].child1 = down;
+    nodes[a].child2 = move;
+    nodes[move].parent = a;
+
+    FitNode(tree, a);
+    FitNode(tree, up);
+    return up;
+}
+
+// Sobe a partir de "index" até a raiz, balanceando e ajustando as caixas
+static void FixUpwards(AabbTree* tree, int index)
+{
+    while (index != AABBTREE_NULL)
+    {
+        index = Balance(tree, index);
+        FitNode(tree, index);
+        index = tree->nodes[index].parent;
+    }
+}
+
+static void InsertLeaf(AabbTree* tree, int leaf)
+{
+    if (tree->root == AABBTREE_NULL)
+    {
+        tree->root = leaf;
+        tree->nodes[leaf].parent = AABBTREE_NULL;
+        return;
+    }
+
+    // Descemos pela árvore escolhendo, em cada nó, entre criar ali um novo
+    // pai para a folha ou descer para o filho cujo aumento de área é menor.
+    const glm::vec3 leaf_min = tree->nodes[leaf].min;
+    const glm::vec3 leaf_max = tree->nodes[leaf].max;
+
+    int index = tree->root;
+    while (tree->nodes[index].child1 != AABBTREE_NULL)
+    {
+        const AabbTreeNode& node = tree->nodes[index];
+        const float area = SurfaceArea(node.min, node.max);
+        const float combined_area = SurfaceArea(glm::min(node.min, leaf_min), glm::max(node.max, leaf_max));
+
+        // Custo de criar um pai para este nó e a folha, e o custo mínimo que
+        // a folha acrescenta aos ancestrais se descer.
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        float child_cost[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            const AabbTreeNode& child = tree->nodes[i == 0 ? node.child1 : node.child2];
+            const float child_area = SurfaceArea(glm::min(child.min, leaf_min), glm::max(child.max, leaf_max));
+            child_cost[i] = inheritance_cost + child_area;
+            if (child.child1 != AABBTREE_NULL)
+                child_cost[i] -= SurfaceArea(child.min, child.max);
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1])
+            break;
+
+        index = (child_cost[0] <= child_cost[1]) ? node.child1 : node.child2;
+    }
+
+    // "index" é o irmão da nova folha, sob um novo pai
+    const int sibling = index;
+    const int old_parent = tree->nodes[sibling].parent;
+    const int new_parent = AllocateNode(tree);
+    tree->nodes[new_parent].parent = old_parent;
+    tree->nodes[new_parent].child1 = sibling;
+    tree->nodes[new_parent].child2 = leaf;
+    tree->nodes[sibling].parent = new_parent;
+    tree->nodes[leaf].parent = new_parent;
+
+    if (old_parent == AABBTREE_NULL)
+    {
+        tree->root = new_parent;
+    }
+    else if (tree->nodes[old_parent].child1 == sibling)
+    {
+        tree->nodes[old_parent].child1 = new_parent;
+    }
+    else
+    {
+        tree->nodes[old_parent].child2 = new_parent;
+    }
+
+    FixUpwards(tree, new_parent);
+}
+
+static void RemoveLeaf(AabbTree* tree, int leaf)
+{
+    if (leaf == tree->root)
+    {
+        tree->root = AABBTREE_NULL;
+        return;
+    }
+
+    // O irmão da folha toma o lugar do pai, que é liberado
+    const int parent = tree->nodes[leaf].parent;
+    const int grandparent = tree->nodes[parent].parent;
+    const int sibling = (tree->nodes[parent].child1 == leaf) ? tree->nodes[parent].child2 : tree->nodes[parent].child1;
+
+    tree->nodes[sibling].parent = grandparent;
+    FreeNode(tree, parent);
+
+    if (grandparent == AABBTREE_NULL)
+    {
+        tree->root = sibling;
+        return;
+    }
+
+    if (tree->nodes[grandparent].child1 == parent)
+        tree->nodes[grandparent].child1 = sibling;
+    else
+        tree->nodes[grandparent].child2 = sibling;
+
+    FixUpwards(tree, grandparent);
+}
+
+// Caixa aumentada de uma folha
+static void FattenBox(const AabbTree& tree, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement,
+                      AabbTreeNode* node)
+{
+    const glm::vec3 margin(tree.margin);
+    node->min = min - margin;
+    node->max = max + margin;
+
+    // A caixa é estendida pelo dobro do deslocamento esperado, de modo que um
+    // objeto em movimento uniforme seja reinserido a cada poucos quadros.
+    node->min += glm::min(2.0f * displacement, glm::vec3(0.0f));
+    node->max += glm::max(2.0f * displacement, glm::vec3(0.0f));
+}
+
+void AabbTree_Init(AabbTree* tree, float margin)
+{
+    tree->nodes.clear();
+    tree->root = AABBTREE_NULL;
+    tree->free_list = AABBTREE_NULL;
+    tree->num_proxies = 0;
+    tree->margin = margin;
+}
+
+void AabbTree_Clear(AabbTree* tree)
+{
+    AabbTree_Init(tree, tree->margin);
+}
+
+int AabbTree_Insert(AabbTree* tree, const glm::vec3& min, const glm::vec3& max, int user)
+{
+    const int leaf = AllocateNode(tree);
+    FattenBox(*tree, min, max, glm::vec3(0.0f), &tree->nodes[leaf]);
+    tree->nodes[leaf].user = user;
+
+    InsertLeaf(tree, leaf);
+    tree->num_proxies += 1;
+    return leaf;
+}
+
+void AabbTree_Remove(AabbTree* tree, int proxy)
+{
+    if (proxy < 0 || proxy >= (int)tree->nodes.size() || tree->nodes[proxy].height != 0)
+        return;
+
+    RemoveLeaf(tree, proxy);
+    FreeNode(tree, proxy);
+    tree->num_proxies -= 1;
+}
+
+bool AabbTree_Update(AabbTree* tree, int proxy, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement)
+{
+    if (proxy < 0 || proxy >= (int)tree->nodes.size() || tree->nodes[proxy].height != 0)
+        return false;
+
+    if (Contains(tree->nodes[proxy], min, max))
+        return false;
+
+    RemoveLeaf(tree, proxy);
+    FattenBox(*tree, min, max, displacement, &tree->nodes[proxy]);
+    InsertLeaf(tree, proxy);
+    return true;
+}
+
+int AabbTree_User(const AabbTree& tree, int proxy)
+{
+    return tree.nodes[proxy].user;
+}
+
+void AabbTree_QueryOverlap(const AabbTree& tree, const glm::vec3& min, const glm::vec3& max, std::vector<int>* users)
+{
+    if (tree.root == AABBTREE_NULL)
+        return;
+
+    int stack[AABBTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = tree.root;
+    while (top > 0)
+    {
+        const AabbTreeNode& node = tree.nodes[stack[--top]];
+        if (!Overlaps(node, min, max))
+            continue;
+
+        if (node.child1 == AABBTREE_NULL)
+        {
+            users->push_back(node.user);
+        }
+        else
+        {
+            stack[top++] = node.child1;
+            stack[top++] = node.child2;
+        }
+    }
+}
+
+void AabbTree_QueryRay(const AabbTree& tree, const glm::vec3& origin, const glm::vec3& direction, float max_t,
+                       std::vector<int>* users)
+{
+    if (tree.root == AABBTREE_NULL)
+        return;
+
+    // Teste das "fatias" (slabs): o segmento intercepta a caixa se os
+    // intervalos de t em que está entre os planos de cada eixo se sobrepõem.
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; ++axis)
+        inverse[axis] = (direction[axis] != 0.0f) ? 1.0f / direction[axis] : FLT_MAX;
+
+    int stack[AABBTREE_STACK_SIZE];
+    int top = 0;
+    stack[top++] = tree.root;
+    while (top > 0)
+    {
+        const AabbTreeNode& node = tree.nodes[stack[--top]];
+
+        float t_enter = 0.0f;
+        float t_exit = max_t;
+        for (int axis = 0; axis < 3 && t_enter <= t_exit; ++axis)
+        {
+            if (direction[axis] == 0.0f)
+            {
+                if (origin[axis] < node.min[axis] || origin[axis] > node.max[axis])
+                    t_enter = FLT_MAX;
+                continue;
+            }
+            float t0 = (node.min[axis] - origin[axis]) * inverse[axis];
+            float t1 = (node.max[axis] - origin[axis]) * inverse[axis];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            t_enter = std::max(t_enter, t0);
+            t_exit  = std::min(t_exit, t1);
+        }
+        if (t_enter > t_exit)
+            continue;
+
+        if (node.child1 == AABBTREE_NULL)
+        {
+            users->push_back(node.user);
+        }
+        else
+        {
+            stack[top++] = node.child1;
+            stack[top++] = node.child2;
+        }
+    }
+}
+
+// Acrescenta todas as folhas abaixo de "index"
+static void CollectLeaves(const AabbTree& tree, int index, std::vector<int>* users)
+{
+    const AabbTreeNode& node = tree.nodes[index];
+    if (node.child1 == AABBTREE_NULL)
+    {
+        users->push_back(node.user);
+        return;
+    }
+    CollectLeaves(tree, node.child1, users);
+    CollectLeaves(tree, node.child2, users);
+}
+
+void AabbTree_QueryFrustum(const AabbTree& tree, const float planes[6][4], std::vector<int>* users)
+{
+    if (tree.root == AABBTREE_NULL)
+        return;
+
+    // Cada entrada da pilha guarda o nó e os planos que ainda cortam a caixa
+    // do pai: os planos com o pai inteiramente do lado de dentro não
+    // precisam ser testados nos filhos.
+    int stack[AABBTREE_STACK_SIZE];
+    int masks[AABBTREE_STACK_SIZE];
+    int top = 0;
+    stack[top] = tree.root;
+    masks[top] = 0x3F;
+    top += 1;
+    while (top > 0)
+    {
+        top -= 1;
+        const int index = stack[top];
+        const AabbTreeNode& node = tree.nodes[index];
+
+        int mask = masks[top];
+        bool outside = false;
+        for (int plane = 0; plane < 6 && !outside; ++plane)
+        {
+            if (!(mask & (1 << plane)))
+                continue;
+
+            // Vértices da caixa mais à frente e mais atrás em relação ao plano
+            const float* p = planes[plane];
+            const float front = p[0] * (p[0] >= 0.0f ? node.max.x : node.min.x)
+                              + p[1] * (p[1] >= 0.0f ? node.max.y : node.min.y)
+                              + p[2] * (p[2] >= 0.0f ? node.max.z : node.min.z) + p[3];
+            const float back  = p[0] * (p[0] >= 0.0f ? node.min.x : node.max.x)
+                              + p[1] * (p[1] >= 0.0f ? node.min.y : node.max.y)
+                              + p[2] * (p[2] >= 0.0f ? node.min.z : node.max.z) + p[3];
+            if (front < 0.0f)
+                outside = true;
+            else if (back >= 0.0f)
+                mask &= ~(1 << plane);
+        }
+        if (outside)
+            continue;
+
+        if (mask == 0 || node.child1 == AABBTREE_NULL)
+        {
+            CollectLeaves(tree, index, users);
+        }
+        else
+        {
+            stack[top] = node.child1;
+            masks[top] = mask;
+            top += 1;
+            stack[top] = node.child2;
+            masks[top] = mask;
+            top += 1;
+        }
+    }
+}
+
+int AabbTree_Height(const AabbTree& tree)
+{
+    return (tree.root == AABBTREE_NULL) ? -1 : tree.nodes[tree.root].height;
+}
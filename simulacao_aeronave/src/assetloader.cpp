@@ -0,0 +1,159 @@
+// Carregamento assíncrono de recursos. Veja "include/assetloader.h".
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include "assetloader.h"
+
+struct AssetTask
+{
+    AssetLoadFunction   load;
+    AssetUploadFunction upload;
+};
+
+// Estado compartilhado entre a thread principal e as threads de trabalho.
+// Tarefas agendadas ficam em g_LoadQueue até serem lidas por uma thread de
+// trabalho, e então passam para g_UploadQueue, que é esvaziada pela thread
+// principal em AssetLoader_Update().
+static std::mutex                g_AssetMutex;
+static std::condition_variable   g_AssetCondition;   // Sinaliza novas tarefas para as threads de trabalho
+static std::deque<AssetTask>     g_LoadQueue;
+static std::deque<AssetTask>     g_UploadQueue;
+static std::vector<std::thread>  g_AssetWorkers;
+static bool                      g_AssetStop = false;
+
+static size_t g_AssetSubmitted = 0;
+static size_t g_AssetCompleted = 0; // Acessado somente pela thread principal
+
+static void AssetLoader_WorkerMain()
+{
+    for (;;)
+    {
+        AssetTask task;
+        {
+            std::unique_lock<std::mutex> lock(g_AssetMutex);
+            while (!g_AssetStop && g_LoadQueue.empty())
+                g_AssetCondition.wait(lock);
+
+            if (g_AssetStop)
+                return;
+
+            task = g_LoadQueue.front();
+            g_LoadQueue.pop_front();
+        }
+
+        if (task.load)
+            task.load();
+
+        {
+            std::lock_guard<std::mutex> lock(g_AssetMutex);
+            g_UploadQueue.push_back(task);
+        }
+    }
+}
+
+void AssetLoader_Init(unsigned int num_threads)
+{
+    if (!g_AssetWorkers.empty())
+        return;
+
+    if (num_threads == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        num_threads = cores > 1 ? cores - 1 : 1;
+    }
+
+    g_AssetStop = false;
+    for (unsigned int i = 0; i < num_threads; ++i)
+        g_AssetWorkers.push_back(std::thread(AssetLoader_WorkerMain));
+}
+
+void AssetLoader_Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_AssetMutex);
+        g_AssetStop = true;
+        g_LoadQueue.clear();
+    }
+    g_AssetCondition.notify_all();
+
+    for (size_t i = 0; i < g_AssetWorkers.size(); ++i)
+        g_AssetWorkers[i].join();
+    g_AssetWorkers.clear();
+
+    g_UploadQueue.clear();
+
+    // As tarefas descartadas nunca serão concluídas
+    g_AssetSubmitted = 0;
+    g_AssetCompleted = 0;
+}
+
+void AssetLoader_Submit(const AssetLoadFunction& load, const AssetUploadFunction& upload)
+{
+    AssetTask task;
+    task.load = load;
+    task.upload = upload;
+
+    {
+        std::lock_guard<std::mutex> lock(g_AssetMutex);
+        g_LoadQueue.push_back(task);
+    }
+    g_AssetCondition.notify_one();
+
+    g_AssetSubmitted += 1;
+}
+
+void AssetLoader_Update(double budget_ms)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now()
+        + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(budget_ms));
+
+    do
+    {
+        // A tarefa é retirada da fila enquanto um passo é executado, e volta
+        // para o início dela caso ainda não tenha terminado; assim o envio
+        // continua no próximo quadro se o orçamento acabar. Isso também
+        // permite que o passo chame AssetLoader_Shutdown() em caso de erro.
+        AssetTask task;
+        {
+            std::lock_guard<std::mutex> lock(g_AssetMutex);
+            if (g_UploadQueue.empty())
+                return;
+            task = g_UploadQueue.front();
+            g_UploadQueue.pop_front();
+        }
+
+        bool done = !task.upload || task.upload();
+
+        if (done)
+        {
+            g_AssetCompleted += 1;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(g_AssetMutex);
+            g_UploadQueue.push_front(task);
+        }
+    }
+    while (Clock::now() < deadline);
+}
+
+size_t AssetLoader_NumCompleted()
+{
+    return g_AssetCompleted;
+}
+
+size_t AssetLoader_NumSubmitted()
+{
+    return g_AssetSubmitted;
+}
+
+bool AssetLoader_Idle()
+{
+    return g_AssetCompleted == g_AssetSubmitted;
+}
@@ -0,0 +1,173 @@
+// Descarte dos objetos fora do frustum. Veja "include/culling.h".
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULLING_BATCH 8
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CULLING_SSE
+#define CULLING_BATCH 4
+#else
+#define CULLING_BATCH 1
+#endif
+
+#include "culling.h"
+
+// Planos a*x + b*y + c*z + d = 0, com (a,b,c) unitário apontando para dentro
+static float g_CullingPlanes[6][4];
+
+static std::vector<float>         g_CullingX;
+static std::vector<float>         g_CullingY;
+static std::vector<float>         g_CullingZ;
+static std::vector<float>         g_CullingRadius;
+static std::vector<unsigned char> g_CullingVisible;
+static CullingStats               g_CullingStats;
+
+void Culling_SetFrustum(const glm::mat4& projection_view)
+{
+    // Método de Gribb e Hartmann: um ponto está dentro do frustum se
+    // -w <= x, y, z <= w no sistema de coordenadas de recorte, ou seja, os
+    // planos são as somas e diferenças da última linha da matriz com as
+    // demais. A glm guarda as matrizes por colunas: m[coluna][linha].
+    const glm::mat4& m = projection_view;
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        const int   row  = plane / 2;
+        const float sign = (plane % 2 == 0) ? 1.0f : -1.0f;
+
+        float length2 = 0.0f;
+        for (int column = 0; column < 4; ++column)
+        {
+            g_CullingPlanes[plane][column] = m[column][3] + sign * m[column][row];
+            if (column < 3)
+                length2 += g_CullingPlanes[plane][column] * g_CullingPlanes[plane][column];
+        }
+
+        const float inverse_length = (length2 > 0.0f) ? 1.0f / sqrtf(length2) : 0.0f;
+        for (int column = 0; column < 4; ++column)
+            g_CullingPlanes[plane][column] *= inverse_length;
+    }
+}
+
+void Culling_GetPlanes(float planes[6][4])
+{
+    memcpy(planes, g_CullingPlanes, sizeof(g_CullingPlanes));
+}
+
+void Culling_Clear()
+{
+    g_CullingX.clear();
+    g_CullingY.clear();
+    g_CullingZ.clear();
+    g_CullingRadius.clear();
+}
+
+size_t Culling_Add(const glm::vec3& center, float radius)
+{
+    g_CullingX.push_back(center.x);
+    g_CullingY.push_back(center.y);
+    g_CullingZ.push_back(center.z);
+    g_CullingRadius.push_back(radius);
+    return g_CullingX.size() - 1;
+}
+
+// Testa as esferas [first, first + CULLING_BATCH), gravando 1 em "visible"
+// para as que não estão inteiramente atrás de nenhum plano.
+static void TestBatch(size_t first, unsigned char* visible)
+{
+#if defined(__AVX__)
+    const __m256 x = _mm256_loadu_ps(&g_CullingX[first]);
+    const __m256 y = _mm256_loadu_ps(&g_CullingY[first]);
+    const __m256 z = _mm256_loadu_ps(&g_CullingZ[first]);
+    const __m256 minus_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&g_CullingRadius[first]));
+
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        __m256 distance = _mm256_set1_ps(g_CullingPlanes[plane][3]);
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(x, _mm256_set1_ps(g_CullingPlanes[plane][0])));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(y, _mm256_set1_ps(g_CullingPlanes[plane][1])));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(g_CullingPlanes[plane][2])));
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, minus_radius, _CMP_GE_OQ));
+    }
+
+    const int mask = _mm256_movemask_ps(inside);
+    for (int i = 0; i < CULLING_BATCH; ++i)
+        visible[i] = (unsigned char)((mask >> i) & 1);
+#elif defined(CULLING_SSE)
+    const __m128 x = _mm_loadu_ps(&g_CullingX[first]);
+    const __m128 y = _mm_loadu_ps(&g_CullingY[first]);
+    const __m128 z = _mm_loadu_ps(&g_CullingZ[first]);
+    const __m128 minus_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&g_CullingRadius[first]));
+
+    __m128 inside = _mm_cmpeq_ps(x, x); // Todos os bits em 1 (exceto para NaN)
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        __m128 distance = _mm_set1_ps(g_CullingPlanes[plane][3]);
+        distance = _mm_add_ps(distance, _mm_mul_ps(x, _mm_set1_ps(g_CullingPlanes[plane][0])));
+        distance = _mm_add_ps(distance, _mm_mul_ps(y, _mm_set1_ps(g_CullingPlanes[plane][1])));
+        distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(g_CullingPlanes[plane][2])));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, minus_radius));
+    }
+
+    const int mask = _mm_movemask_ps(inside);
+    for (int i = 0; i < CULLING_BATCH; ++i)
+        visible[i] = (unsigned char)((mask >> i) & 1);
+#else
+    bool inside = true;
+    for (int plane = 0; plane < 6 && inside; ++plane)
+    {
+        const float distance = g_CullingPlanes[plane][0] * g_CullingX[first]
+                             + g_CullingPlanes[plane][1] * g_CullingY[first]
+                             + g_CullingPlanes[plane][2] * g_CullingZ[first]
+                             + g_CullingPlanes[plane][3];
+        inside = (distance >= -g_CullingRadius[first]);
+    }
+    visible[0] = inside ? 1 : 0;
+#endif
+}
+
+size_t Culling_Run()
+{
+    const size_t count = g_CullingX.size();
+
+    // Completamos o último grupo com esferas de raio negativo, sempre
+    // descartadas, para que todos os grupos tenham CULLING_BATCH esferas.
+    const size_t padded = (count + CULLING_BATCH - 1) / CULLING_BATCH * CULLING_BATCH;
+    g_CullingX.resize(padded, 0.0f);
+    g_CullingY.resize(padded, 0.0f);
+    g_CullingZ.resize(padded, 0.0f);
+    g_CullingRadius.resize(padded, -FLT_MAX);
+    g_CullingVisible.resize(padded);
+
+    for (size_t first = 0; first < padded; first += CULLING_BATCH)
+        TestBatch(first, &g_CullingVisible[first]);
+
+    g_CullingX.resize(count);
+    g_CullingY.resize(count);
+    g_CullingZ.resize(count);
+    g_CullingRadius.resize(count);
+
+    size_t visible = 0;
+    for (size_t i = 0; i < count; ++i)
+        visible += g_CullingVisible[i];
+
+    g_CullingStats.objects = count;
+    g_CullingStats.visible = visible;
+    g_CullingStats.culled  = count - visible;
+    return visible;
+}
+
+bool Culling_Visible(size_t index)
+{
+    return index < g_CullingVisible.size() && g_CullingVisible[index] != 0;
+}
+
+const CullingStats& Culling_Stats()
+{
+    return g_CullingStats;
+}
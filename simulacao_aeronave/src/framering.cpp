@@ -0,0 +1,215 @@
+// Buffer circular de dados por quadro. Veja "include/framering.h".
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include "framering.h"
+#include "resources.h"
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
+
+static PFN_FrameRingBufferStorage g_RingBufferStorage = NULL;
+static GLuint         g_RingBuffer = 0;
+static char*          g_RingMapped = NULL;      // Mapeamento persistente, ou NULL
+static bool           g_RingRangeMapped = false; // Faixa mapeada sem GL_ARB_buffer_storage
+static size_t         g_RingFrameSize = 0;
+static size_t         g_RingRequired = 0;        // Maior uso pedido em um quadro
+static int            g_RingFrame = 0;           // Parte do buffer do quadro atual
+static size_t         g_RingHead = 0;            // Bytes já alocados no quadro atual
+static GLsync         g_RingFences[FRAMERING_FRAMES];
+static GLint          g_RingUniformAlignment = 256;
+static FrameRingStats g_RingStats;
+
+// Buffer do bloco de uniforms utilizado quando não há espaço no anel
+static GLuint g_FrameUniformsBuffer = 0;
+
+static void CreateRingBuffer()
+{
+    const size_t size = FRAMERING_FRAMES * g_RingFrameSize;
+
+    g_RingBuffer = Resource_Create(RESOURCE_BUFFER, RESOURCE_STREAMING, "dados por quadro");
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_RingBuffer);
+    if (g_RingBufferStorage != NULL)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        g_RingBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+        g_RingMapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    Resource_SetGpuBytes(RESOURCE_BUFFER, g_RingBuffer, size);
+
+    g_RingStats.frame_size = g_RingFrameSize;
+    g_RingStats.persistent = (g_RingMapped != NULL);
+}
+
+static void DestroyRingBuffer()
+{
+    for (int i = 0; i < FRAMERING_FRAMES; ++i)
+    {
+        if (g_RingFences[i] != NULL)
+        {
+            glClientWaitSync(g_RingFences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(g_RingFences[i]);
+            g_RingFences[i] = NULL;
+        }
+    }
+
+    if (g_RingMapped != NULL)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, g_RingBuffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        g_RingMapped = NULL;
+    }
+    Resource_Release(RESOURCE_BUFFER, g_RingBuffer);
+    g_RingBuffer = 0;
+}
+
+void FrameRing_Init(size_t frame_size, PFN_FrameRingBufferStorage buffer_storage)
+{
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &g_RingUniformAlignment);
+
+    memset(&g_RingStats, 0, sizeof(g_RingStats));
+    g_RingBufferStorage = buffer_storage;
+    g_RingFrameSize = frame_size;
+    CreateRingBuffer();
+
+    g_FrameUniformsBuffer = Resource_Create(RESOURCE_BUFFER, RESOURCE_STREAMING, "dados por quadro");
+    glBindBuffer(GL_UNIFORM_BUFFER, g_FrameUniformsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    Resource_SetGpuBytes(RESOURCE_BUFFER, g_FrameUniformsBuffer, sizeof(FrameUniforms));
+}
+
+void FrameRing_Shutdown()
+{
+    if (g_RingBuffer != 0)
+        DestroyRingBuffer();
+    Resource_Release(RESOURCE_BUFFER, g_FrameUniformsBuffer);
+    g_FrameUniformsBuffer = 0;
+}
+
+void FrameRing_BeginFrame()
+{
+    if (g_RingBuffer == 0)
+        return;
+
+    // Um quadro anterior não coube: recriamos o buffer com o dobro do
+    // necessário, depois que a GPU terminar de utilizar o atual.
+    if (g_RingRequired > g_RingFrameSize)
+    {
+        g_RingFrameSize = std::max(2 * g_RingRequired, 2 * g_RingFrameSize);
+        DestroyRingBuffer();
+        CreateRingBuffer();
+        g_RingFrame = 0;
+    }
+    g_RingRequired = 0;
+
+    GLsync& fence = g_RingFences[g_RingFrame];
+    if (fence != NULL)
+    {
+        // A espera só ocorre se a CPU estiver FRAMERING_FRAMES quadros à
+        // frente da GPU.
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                ;
+            g_RingStats.waits += 1;
+            g_RingStats.wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = NULL;
+    }
+
+    g_RingHead = 0;
+}
+
+void FrameRing_EndFrame()
+{
+    if (g_RingBuffer == 0)
+        return;
+
+    g_RingStats.used = g_RingHead;
+    g_RingFences[g_RingFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    g_RingFrame = (g_RingFrame + 1) % FRAMERING_FRAMES;
+}
+
+void* FrameRing_Allocate(size_t bytes, size_t alignment, GLintptr* offset)
+{
+    if (g_RingBuffer == 0 || bytes == 0)
+        return NULL;
+
+    // O alinhamento é relativo ao início do buffer, e cada parte começa em
+    // um múltiplo de g_RingFrameSize.
+    const size_t base  = g_RingFrame * g_RingFrameSize;
+    const size_t start = ((base + g_RingHead + alignment - 1) / alignment) * alignment;
+    if (start + bytes > base + g_RingFrameSize)
+    {
+        g_RingRequired = std::max(g_RingRequired, start + bytes - base);
+        g_RingStats.overflows += 1;
+        return NULL;
+    }
+    g_RingHead = start + bytes - base;
+    *offset = (GLintptr)start;
+
+    if (g_RingMapped != NULL)
+        return g_RingMapped + start;
+
+    // A fence do quadro garante que a GPU não está lendo esta faixa
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_RingBuffer);
+    void* data = glMapBufferRange(GL_COPY_WRITE_BUFFER, start, bytes,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    g_RingRangeMapped = (data != NULL);
+    return data;
+}
+
+void FrameRing_Commit()
+{
+    if (!g_RingRangeMapped)
+        return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, g_RingBuffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    g_RingRangeMapped = false;
+}
+
+void FrameRing_SetFrameUniforms(const FrameUniforms& uniforms)
+{
+    GLintptr offset;
+    void* data = FrameRing_Allocate(sizeof(uniforms), g_RingUniformAlignment, &offset);
+    if (data != NULL)
+    {
+        memcpy(data, &uniforms, sizeof(uniforms));
+        FrameRing_Commit();
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, g_RingBuffer, offset, sizeof(uniforms));
+    }
+    else
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, g_FrameUniformsBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(uniforms), &uniforms, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, g_FrameUniformsBuffer);
+    }
+}
+
+GLuint FrameRing_Buffer()
+{
+    return g_RingBuffer;
+}
+
+const FrameRingStats& FrameRing_Stats()
+{
+    return g_RingStats;
+}
@@ -18,13 +18,17 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstddef>
+#include <cstring>
 
 // Headers abaixo são específicos de C++
 #include <map>
+#include <chrono>
 #include <stack>
 #include <string>
 #include <vector>
 #include <limits>
+#include <memory>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -37,6 +41,7 @@
 
 // Headers da biblioteca GLM: criação de matrizes e vetores.
 #include <glm/mat4x4.hpp>
+#include <glm/matrix.hpp>
 #include <glm/vec4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -50,23 +55,48 @@
 // Headers locais, definidos na pasta "include/"
 #include "utils.h"
 #include "matrices.h"
+#include "meshdata.h"
+#include "meshcache.h"
+#include "meshopt.h"
+#include "objloader.h"
+#include "assetloader.h"
+#include "texturecache.h"
+#include "texcompress.h"
+#include "vtexture.h"
+#include "meshadjacency.h"
+#include "meshnormals.h"
+#include "objstream.h"
+#include "resources.h"
+#include "scene.h"
+#include "renderqueue.h"
+#include "framering.h"
+#include "culling.h"
+#include "aabbtree.h"
+#include "spatialgrid.h"
+#include "obb.h"
+#include "meshbvh.h"
+#include "sweep.h"
 
 // Estrutura que representa um modelo geométrico carregado a partir de um
 // arquivo ".obj". Veja https://en.wikipedia.org/wiki/Wavefront_.obj_file .
 struct ObjModel
 {
+    std::string                       filename;
     tinyobj::attrib_t                 attrib;
     std::vector<tinyobj::shape_t>     shapes;
     std::vector<tinyobj::material_t>  materials;
 
-    // Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
+    // Este construtor lê o modelo de um arquivo utilizando as estruturas da
+    // biblioteca tinyobjloader. A leitura é feita em paralelo por
+    // ObjLoader_LoadParallel(); veja "src/objloader.cpp".
     // Veja: https://github.com/syoyo/tinyobjloader
     ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
+        : filename(filename)
     {
         printf("Carregando modelo \"%s\"... ", filename);
 
         std::string err;
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, basepath, triangulate);
+        bool ret = ObjLoader_LoadParallel(&attrib, &shapes, &materials, &err, filename, basepath, triangulate);
 
         if (!err.empty())
             fprintf(stderr, "\n%s\n", err.c_str());
@@ -78,6 +108,70 @@ struct ObjModel
     }
 };
 
+// Estado do envio incremental de uma malha para a GPU. Veja
+// BeginMeshUpload() e StepMeshUpload().
+struct MeshUpload
+{
+    GLuint vertex_array_object_id;
+    GLuint buffer_ids[2]; // Vértices compactos (PackedVertex) e índices
+    size_t stream;        // Fluxo de dados sendo enviado (índice de buffer_ids)
+    size_t offset;        // Bytes já enviados deste fluxo
+};
+
+// Estado do envio incremental de uma textura para a GPU. Veja
+// BeginTextureUpload() e StepTextureUpload(). Os níveis são enviados do menor
+// para o maior, e a textura pode ser amostrada assim que o menor nível chega.
+struct TextureUpload
+{
+    GLuint             texture_id;
+    GLuint             textureunit;
+    const TextureData* texture;        // Níveis de mipmap, veja "texturecache.h"
+    size_t             resident_level; // Nível mais detalhado já enviado (levels.size() se nenhum)
+    int                next_row;       // Próxima linha a ser enviada do nível resident_level-1
+};
+
+// Textura transmitida progressivamente (veja StreamTextures()): depois que os
+// níveis pequenos são enviados, os maiores são enviados ao longo dos quadros,
+// conforme o tamanho na tela dos objetos que a utilizam.
+struct StreamedTexture
+{
+    std::string   filename;
+    std::shared_ptr<TextureData> texture;
+    TextureUpload upload;
+    size_t        wanted_level; // Nível necessário no último quadro (levels.size() se não utilizada)
+    float         priority;     // Texels necessários na tela / texels residentes
+};
+
+// Tamanho máximo (largura ou altura) dos níveis enviados imediatamente ao
+// carregar uma textura, e número máximo de bytes de níveis maiores enviados
+// por quadro. Veja StreamTextures().
+#define TEXTURE_STREAM_INITIAL_SIZE 128
+#define TEXTURE_STREAM_BUDGET_BYTES (256*1024)
+
+// Tempo máximo, por quadro, gasto enviando recursos carregados em segundo
+// plano para a GPU, e tamanho máximo de cada envio. Veja "assetloader.h".
+#define ASSET_UPLOAD_BUDGET_MS  2.0
+#define ASSET_UPLOAD_CHUNK_SIZE (512*1024)
+
+// Formatos de textura comprimidos S3TC em sRGB (extensões
+// GL_EXT_texture_compression_s3tc e GL_EXT_texture_sRGB), que não fazem parte
+// da OpenGL 3.3 e portanto não são definidos pela glad. Veja "texcompress.h".
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT       0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// Bits de glBufferStorage()/glMapBufferRange() da extensão
+// GL_ARB_buffer_storage (OpenGL 4.4), também ausentes da glad. Veja
+// g_BufferStorage.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
 
 // Declaração de funções utilizadas para pilha de matrizes de modelagem.
 void PushMatrix(glm::mat4 M);
@@ -86,10 +180,42 @@ void PopMatrix(glm::mat4& M);
 // Declaração de várias funções utilizadas em main().  Essas estão definidas
 // logo após a definição de main() neste arquivo.
 void BuildTrianglesAndAddToVirtualScene(ObjModel*); // Constrói representação de um ObjModel como malha de triângulos para renderização
-void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso não existam.
+void BuildTriangles(ObjModel* model, MeshData* mesh); // Converte um ObjModel para o formato de vértices enviado à GPU
+void AddMeshToVirtualScene(const MeshData& mesh, const char* owner); // Envia uma malha para a GPU e adiciona seus objetos na cena virtual
+bool BeginMeshUpload(const MeshData& mesh, MeshUpload* upload, const char* owner, void** mapped = NULL); // Cria VAO e buffers de uma malha, sem enviar os dados
+size_t MeshCpuBytes(const MeshData& mesh); // Memória principal ocupada por uma malha
+void ReleaseMeshData(MeshData* mesh); // Libera a memória principal de uma malha já enviada para a GPU
+bool StepMeshUpload(const MeshData& mesh, MeshUpload* upload, size_t max_bytes); // Envia parte dos dados de uma malha; retorna true ao terminar
+void AddMeshShapesToVirtualScene(const MeshData& mesh, GLuint vertex_array_object_id); // Adiciona os shapes de uma malha já enviada na cena virtual
+void LoadMesh(const char* filename, const char* basepath, bool compute_normals, MeshData* mesh); // Lê uma malha, utilizando o cache binário quando possível
+void LoadModelAndAddToVirtualScene(const char* filename, const char* basepath = NULL, bool compute_normals = true); // Carrega um modelo, utilizando o cache binário quando possível
+void LoadModelAndAddToVirtualSceneAsync(const char* filename, const char* basepath = NULL, bool compute_normals = true); // Idem, em segundo plano
+void StreamModelToVirtualSceneAsync(const char* filename, bool compute_normals = true); // Lê um ".obj" direto para buffers mapeados da GPU
+void ComputeNormals(ObjModel* model, int weighting = MESHNORMALS_WEIGHT_AREA); // Computa normais de um ObjModel, caso não existam.
 void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
 void LoadTextureImage(const char* filename); // Função que carrega imagens de textura
-void DrawVirtualObject(const char* object_name); // Desenha um objeto armazenado em g_VirtualScene
+void LoadTextureImageAsync(const char* filename); // Idem, em segundo plano
+bool HasExtension(const char* name); // Verifica se a OpenGL suporta uma extensão
+bool LoadTexture(const char* filename, TextureData* texture); // Lê uma imagem com mipmaps, utilizando o cache binário quando possível
+void BeginTextureUpload(TextureUpload* upload, GLuint textureunit, const TextureData* texture, const char* owner); // Cria a textura, sem enviar os dados
+size_t TextureCpuBytes(const TextureData& texture); // Memória principal ocupada pelos níveis de uma textura
+bool StepTextureUpload(TextureUpload* upload, size_t max_bytes, size_t target_level); // Envia parte dos mipmaps, até "target_level"; retorna true ao terminar
+void StreamTextures(size_t budget_bytes); // Envia níveis maiores das texturas transmitidas progressivamente
+void RequestTextureResolution(GLuint textureunit, SceneHandle object, const glm::mat4& model); // Informa o tamanho na tela de um objeto que utiliza a textura
+uint32_t TextureBuildFlags(); // Opções de construção dos caches de textura, conforme a compressão
+void LoadVirtualTextureAsync(const char* filename); // Carrega uma imagem aérea como textura virtual do plano
+void UpdateVirtualTexture(int max_pages); // Processa o feedback e envia páginas da textura virtual
+void SetVirtualTextureUniforms(); // Envia os parâmetros da textura virtual para o programa de GPU
+void RenderVirtualTextureFeedback(SceneHandle object, int material, const glm::mat4& model, int width, int height); // Passada de feedback
+void DrawVirtualObject(SceneHandle object, int material, const glm::mat4& model); // Desenha imediatamente um objeto da cena virtual
+void SubmitVirtualObject(SceneHandle object, int material, const glm::mat4& model); // Idem, pela fila de renderização
+void SubmitVisibleObjects(); // Descarta os objetos fora do frustum e submete os demais
+void WorldBoundingBox(const glm::mat4& model, const glm::vec3& bbox_min, const glm::vec3& bbox_max, glm::vec3* world_min, glm::vec3* world_max); // AABB global de uma bbox transformada
+const MeshBvh* GetSceneBvh(SceneHandle object); // Hierarquia dos triângulos de um objeto, ou NULL
+bool ShotHitsMesh(SceneHandle object, const glm::mat4& start_model, const glm::mat4& end_model, const glm::vec4& from, const glm::vec4& to, float radius); // Fase estreita dos tiros
+bool RaycastMesh(SceneHandle object, const glm::mat4& model, const glm::vec3& origin, const glm::vec3& direction, float max_t, float* t); // Raio contra a malha de um objeto
+void UpdateSceneProxy(int* proxy, bool present, int user, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement); // Mantém um objeto em g_SceneTree
+bool MakeRenderPacket(SceneHandle object, const glm::mat4* model, RenderPacket* packet); // VAO e índices a desenhar de um objeto
 GLuint LoadShader_Vertex(const char* filename);   // Carrega um vertex shader
 GLuint LoadShader_Fragment(const char* filename); // Carrega um fragment shader
 void LoadShader(const char* filename, GLuint shader_id); // Função utilizada pelas duas acima
@@ -113,6 +239,10 @@ void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 project
 void TextRendering_ShowEulerAngles(GLFWwindow* window);
 void TextRendering_ShowProjection(GLFWwindow* window);
 void TextRendering_ShowFramesPerSecond(GLFWwindow* window);
+void TextRendering_ShowTriangleCount(GLFWwindow* window);
+void TextRendering_ShowMemoryUsage(GLFWwindow* window);
+void TextRendering_ShowRenderQueueStats(GLFWwindow* window);
+void TextRendering_ShowCullingStats(GLFWwindow* window);
 
 // Funções callback para comunicação com o sistema operacional e interação do
 // usuário. Veja mais comentários nas definições das mesmas, abaixo.
@@ -125,26 +255,9 @@ void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 void Anda();
 glm::vec4 curva_bezier(int which_cow);
 
-// Definimos uma estrutura que armazenará dados necessários para renderizar
-// cada objeto da cena virtual.
-struct SceneObject
-{
-    std::string  name;        // Nome do objeto
-    void*        first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    int          num_indices; // Número de índices do objeto dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
-    GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo
-    glm::vec3    bbox_min; // Axis-Aligned Bounding Box do objeto
-    glm::vec3    bbox_max;
-};
+float ProjectedPixelsPerUnit(const SceneObject& theobject, const glm::mat4& model); // Pixels na tela por unidade do modelo
 // Abaixo definimos variáveis globais utilizadas em várias funções do código.
 
-// A cena virtual é uma lista de objetos nomeados, guardados em um dicionário
-// (map).  Veja dentro da função BuildTrianglesAndAddToVirtualScene() como que são incluídos
-// objetos dentro da variável g_VirtualScene, e veja na função main() como
-// estes são acessados.
-std::map<std::string, SceneObject> g_VirtualScene;
-
 // Pilha que guardará as matrizes de modelagem.
 std::stack<glm::mat4>  g_MatrixStack;
 
@@ -184,6 +297,121 @@ bool g_UsePerspectiveProjection = true;
 // Variável que controla se o texto informativo será mostrado na tela.
 bool g_ShowInfoText = true;
 
+// Variável que controla se as malhas são reordenadas para a cache de vértices
+// da GPU ao serem carregadas (veja LoadMesh() e "meshopt.h"). Desligada pela
+// opção "--no-mesh-opt" na linha de comando.
+bool g_OptimizeMeshes = true;
+
+// Variável que controla se os modelos são lidos diretamente para buffers
+// mapeados da GPU, em lotes, sem o cache e sem otimizações (veja
+// StreamModelToVirtualSceneAsync() e "objstream.h"). Ligada pela opção
+// "--stream-models" na linha de comando.
+bool g_StreamModels = false;
+
+// Variável que controla se a memória utilizada (veja "resources.h") é
+// impressa no terminal quando todos os recursos são carregados e ao final do
+// programa. Ligada pela opção "--mem-report" na linha de comando.
+bool g_MemReport = false;
+
+// Número de vacas adicionais, somente decorativas, espalhadas sobre o plano
+// para testar o desenho de muitos objetos (veja "renderqueue.h"). Definido
+// pela opção "--cows=N" na linha de comando.
+int g_ExtraCows = 0;
+
+// Variáveis que controlam a compressão das texturas em BC1/BC3 (veja
+// "texcompress.h"): desligada pela opção "--no-texture-compression", ou se a
+// GPU não suportar os formatos S3TC; a qualidade (0, 1 ou 2) é definida pela
+// opção "--texture-quality=N".
+bool g_CompressTextures = true;
+bool g_SupportsS3TC = false;
+int  g_TextureQuality = TEXCOMPRESS_QUALITY_NORMAL;
+
+// Texturas cujos níveis maiores ainda estão sendo enviados para a GPU (veja
+// StreamTextures()).
+std::vector<StreamedTexture> g_StreamedTextures;
+
+// glTexStorage2D() não faz parte da OpenGL 3.3 (e portanto da glad gerada
+// para este projeto); é obtida de GL_ARB_texture_storage quando disponível.
+// Veja BeginTextureUpload().
+typedef void (*PFN_TexStorage2D)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+PFN_TexStorage2D g_TexStorage2D = NULL;
+
+// Da mesma forma, glBufferStorage() é obtida de GL_ARB_buffer_storage. Com
+// ela os buffers de StreamModelToVirtualSceneAsync() ficam mapeados de forma
+// persistente e coerente enquanto são preenchidos.
+typedef void (*PFN_BufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+PFN_BufferStorage g_BufferStorage = NULL;
+
+// Textura virtual do plano (veja "vtexture.h"): páginas de uma imagem aérea
+// carregadas sob demanda, conforme uma passada de "feedback" com 1/8 da
+// resolução da janela. Desligada pela opção "--no-virtual-texture", caso em
+// que o plano utiliza a textura comum "porto-alegre.jpg" (TextureImage0). As
+// unidades de textura são fixas, depois das unidades das imagens comuns.
+#define VIRTUAL_TEXTURE_PAGES_UNIT       3
+#define VIRTUAL_TEXTURE_INDIRECTION_UNIT 4
+#define VIRTUAL_TEXTURE_FEEDBACK_SCALE   8
+#define VIRTUAL_TEXTURE_PAGES_PER_FRAME  8
+bool                g_UseVirtualTexture = true;
+bool                g_VirtualTextureReady = false;
+VirtualTexture      g_VirtualTexture;
+VirtualTextureCache g_VirtualTextureCache;
+GLuint              g_VirtualPagesTexture = 0;
+GLuint              g_VirtualIndirectionTexture = 0;
+size_t              g_VirtualPagesUploaded = 0;
+
+// Framebuffer da passada de feedback, e dois pixel buffer objects onde o
+// resultado é copiado: cada um é lido pela CPU dois quadros depois, para que
+// a leitura não espere pela GPU. Veja RenderVirtualTextureFeedback().
+GLuint g_FeedbackFramebuffer = 0;
+GLuint g_FeedbackRenderbuffers[2] = { 0, 0 }; // Cor e profundidade
+GLuint g_FeedbackBuffers[2] = { 0, 0 };
+size_t g_FeedbackPixels[2] = { 0, 0 };        // Pixels copiados para cada buffer, ainda não lidos
+int    g_FeedbackIndex = 0;
+int    g_FeedbackWidth = 0;
+int    g_FeedbackHeight = 0;
+
+// Variável que controla se são gerados e utilizados níveis de detalhe (LODs)
+// simplificados das malhas (veja MeshOpt_GenerateLods() e SelectLod()).
+// Desligada pela opção "--no-lod" na linha de comando.
+bool g_UseLods = true;
+
+// Erro máximo, em pixels, que um nível de detalhe pode introduzir na tela
+#define LOD_MAX_PIXEL_ERROR 1.0f
+
+// Parâmetros da câmera utilizados por SelectLod(), atualizados a cada quadro:
+// número de pixels ocupados por uma unidade de comprimento do mundo a uma
+// distância 1 da câmera (projeção perspectiva) ou a qualquer distância
+// (projeção ortográfica).
+glm::vec4 g_LodCameraPosition = glm::vec4(0.0f,0.0f,0.0f,1.0f);
+float     g_LodPixelsPerUnit = 1.0f;
+bool      g_LodPerspective = true;
+
+// Variável que controla o descarte dos objetos fora do frustum (veja
+// "culling.h" e SubmitVisibleObjects()). Desligada pela opção "--no-culling"
+// na linha de comando.
+bool g_UseCulling = true;
+
+// Objetos submetidos no quadro por SubmitVirtualObject(), na mesma ordem das
+// suas esferas envolventes em "culling.h", aguardando SubmitVisibleObjects().
+struct PendingObject
+{
+    SceneHandle object;
+    int         material;
+    glm::mat4   model;
+};
+std::vector<PendingObject> g_PendingObjects;
+
+// Hierarquias dos triângulos dos objetos da cena virtual, indexadas pelo
+// SceneHandle (veja AddMeshShapesToVirtualScene() e GetSceneBvh()). Ficam
+// vazias nos modelos lidos por "objstream.h", que não guardam as posições na
+// memória principal.
+std::vector<MeshBvh> g_SceneBvhs;
+
+// Número de triângulos desenhados no quadro atual, e quantos seriam
+// desenhados sem os níveis de detalhe. Veja TextRendering_ShowTriangleCount().
+size_t g_TrianglesDrawn = 0;
+size_t g_TrianglesFullDetail = 0;
+
 // Variaveis look_at
 bool Look_at =true;
 int primeiro=0;
@@ -192,12 +420,18 @@ int primeiro=0;
 GLuint vertex_shader_id;
 GLuint fragment_shader_id;
 GLuint program_id = 0;
-GLint model_uniform;
-GLint view_uniform;
-GLint projection_uniform;
-GLint object_id_uniform;
 GLint bbox_min_uniform;
 GLint bbox_max_uniform;
+GLint virtual_texture_enabled_uniform;
+GLint virtual_texture_feedback_uniform;
+GLint virtual_texture_uv_scale_uniform;
+GLint virtual_texture_pages_uniform;
+GLint virtual_texture_levels_uniform;
+GLint virtual_texture_cache_size_uniform;
+GLint virtual_texture_lod_bias_uniform;
+
+// Índice do programa acima na fila de renderização (veja "renderqueue.h")
+#define SCENE_PROGRAM 0
 
 float rotationX = 0.00f;
 int rotateR =0;
@@ -218,6 +452,13 @@ int vel_maxima = 0;
 
 // Tiro da nave
 float atira=0;
+
+// Arma instantânea, alternada pela tecla 'T': em vez de lançar um projétil,
+// cada tiro é um raio testado na hora contra as malhas dos alvos (veja
+// "meshbvh.h"). O alcance é o dos projéteis, em múltiplos do vetor "view":
+// velocidade 25 durante 2 segundos.
+bool g_HitscanWeapon = false;
+#define HITSCAN_RANGE 50.0f
 std::vector <std::pair<glm::mat4,glm::vec4>> tiros;
 double tprev=glfwGetTime();
 double tnow;
@@ -245,38 +486,31 @@ float raioesfera;
 
 // Funcões de contato/intersecção
 // Intersecção cubo-plano
-bool isPlaneBox(glm::vec4 boxmin,glm::vec4 boxmax)
-{
-  return (boxmin.y <= -1.0f);
-}
-// Intersecção ponto-esfera
-bool isPointCircle(glm::vec4 point,glm::vec4 circle,float raio)
+bool isPlaneBox(const Obb& box)
 {
-  float distance =norm((point-circle));
-  return distance<raio;
+  return (Obb_LowestY(box) <= -1.0f);
 }
-// Intersecção cubo-cubo
-bool boxintersect(glm::vec4 boxmin1,glm::vec4 boxmax1,glm::vec4 boxmin2,glm::vec4 boxmax2)
-{
-    return (((((boxmin1.x>=boxmin2.x) && (boxmin1.x<=boxmax2.x)) ||
-              ((boxmax1.x>=boxmin2.x) && (boxmax1.x<=boxmax2.x))) ||
-             (((boxmin1.x<=boxmin2.x) && (boxmin1.x>=boxmax2.x)) ||
-              ((boxmax1.x<=boxmin2.x) && (boxmax1.x>=boxmax2.x)))) &&
-
-            ((((boxmin1.y>=boxmin2.y) && (boxmin1.y<=boxmax2.y)) ||
-              ((boxmax1.y>=boxmin2.y) && (boxmax1.y<=boxmax2.y))) ||
-             (((boxmin1.y<=boxmin2.y) && (boxmin1.y>=boxmax2.y)) ||
-              ((boxmax1.y<=boxmin2.y) && (boxmax1.y>=boxmax2.y)))) &&
-
-            ((((boxmin1.z>=boxmin2.z) && (boxmin1.z<=boxmax2.z)) ||
-              ((boxmax1.z>=boxmin2.z) && (boxmax1.z<=boxmax2.z))) ||
-             (((boxmin1.z<=boxmin2.z) && (boxmin1.z>=boxmax2.z)) ||
-              ((boxmax1.z<=boxmin2.z) && (boxmax1.z>=boxmax2.z)))));
-}
-
 //RANGE DO TIRO
 std::vector<double> shotrange;
 
+// Objetos móveis da cena (nave, vacas, tiros e a esfera alvo), em uma árvore
+// de AABBs (veja "aabbtree.h") consultada pelos testes de colisão e pelo
+// descarte das vacas adicionais. O valor "user" de cada folha guarda o tipo
+// do objeto nos 8 bits mais significativos e seu índice nos demais.
+enum SceneEntity
+{
+    ENTITY_SHIP,
+    ENTITY_TARGET_COW,    // Vacas 1 e 2, alvos dos tiros
+    ENTITY_COW,           // Vacas adicionais ("--cows=N"), sem colisão
+    ENTITY_SHOT,
+    ENTITY_TARGET_SPHERE
+};
+#define ENTITY_USER(kind, index) (((kind) << 24) | (index))
+#define ENTITY_KIND(user)        ((user) >> 24)
+#define ENTITY_INDEX(user)       ((user) & 0xFFFFFF)
+
+AabbTree g_SceneTree;
+
 // Vetor de posição das vacas nas curvas bezier
 glm::vec4 posicao_vaca;
 
@@ -331,6 +565,106 @@ float sphere_size = 0.3;
 
 int main(int argc, char* argv[])
 {
+    // Com "--headless" a janela não é mostrada, e com "--frames=N" o programa
+    // termina depois de N quadros. Juntas permitem executar o programa em
+    // testes automatizados, com OpenGL por software (por exemplo Mesa com
+    // LIBGL_ALWAYS_SOFTWARE=1 em um servidor X virtual).
+    bool headless = false;
+    int  max_frames = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--no-mesh-opt") == 0)
+            g_OptimizeMeshes = false;
+        else if (strcmp(argv[i], "--stream-models") == 0)
+            g_StreamModels = true;
+        else if (strcmp(argv[i], "--mem-report") == 0)
+            g_MemReport = true;
+        else if (strncmp(argv[i], "--cows=", 7) == 0)
+            g_ExtraCows = std::max(0, atoi(argv[i] + 7));
+        else if (strcmp(argv[i], "--no-lod") == 0)
+            g_UseLods = false;
+        else if (strcmp(argv[i], "--no-culling") == 0)
+            g_UseCulling = false;
+        else if (strcmp(argv[i], "--no-texture-compression") == 0)
+            g_CompressTextures = false;
+        else if (strncmp(argv[i], "--texture-quality=", 18) == 0)
+            g_TextureQuality = std::max(0, std::min(2, atoi(argv[i] + 18)));
+        else if (strcmp(argv[i], "--no-virtual-texture") == 0)
+            g_UseVirtualTexture = false;
+        else if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (strncmp(argv[i], "--frames=", 9) == 0)
+            max_frames = atoi(argv[i] + 9);
+    }
+
+    // Com "--bench-obj" apenas comparamos o tempo de leitura dos modelos
+    // pela tinyobjloader e pelo leitor paralelo, sem abrir a janela.
+    if (argc > 1 && strcmp(argv[1], "--bench-obj") == 0)
+    {
+        std::vector<std::string> filenames;
+        filenames.push_back("../../data/cow.obj");
+        filenames.push_back("../../data/bunny.obj");
+        filenames.push_back("../../data/sphere.obj");
+        filenames.push_back("../../data/plane.obj");
+        filenames.push_back("../../data/arwing SNES.obj");
+        for (int i = 2; i < argc; ++i)
+            filenames.push_back(argv[i]);
+        ObjLoader_Benchmark(filenames);
+        return 0;
+    }
+
+    // Com "--bench-normals" apenas comparamos o cálculo serial das normais
+    // com o paralelo (veja "meshnormals.h"), sem abrir a janela.
+    if (argc > 1 && strcmp(argv[1], "--bench-normals") == 0)
+    {
+        std::vector<std::string> filenames;
+        filenames.push_back("../../data/bunny.obj");
+        filenames.push_back("../../data/cow.obj");
+        for (int i = 2; i < argc; ++i)
+            filenames.push_back(argv[i]);
+        MeshNormals_Benchmark(filenames);
+        return 0;
+    }
+
+    // Com "--bench-grid [tiros] [alvos]" apenas medimos a grade com hash
+    // espacial utilizada nos testes dos tiros (veja "spatialgrid.h"), sem
+    // abrir a janela.
+    if (argc > 1 && strcmp(argv[1], "--bench-grid") == 0)
+    {
+        int num_projectiles = (argc > 2) ? std::max(1, atoi(argv[2])) : 10000;
+        int num_targets     = (argc > 3) ? std::max(1, atoi(argv[3])) : 1000;
+        SpatialGrid_Benchmark(num_projectiles, num_targets);
+        return 0;
+    }
+
+    // Com "--bake-textures" apenas convertemos as imagens para o cache de
+    // texturas com mipmaps (veja "texturecache.h"), sem abrir a janela.
+    if (argc > 1 && strcmp(argv[1], "--bake-textures") == 0)
+    {
+        std::vector<std::string> filenames;
+        filenames.push_back("../../data/porto-alegre.jpg");
+        filenames.push_back("../../data/metal_texture.jpg");
+        filenames.push_back("../../data/tc-earth_daymap_surface.jpg");
+        filenames.push_back("../../data/tc-earth_nightmap_citylights.gif");
+        for (int i = 2; i < argc; ++i)
+            filenames.push_back(argv[i]);
+
+        // Sem contexto OpenGL, assumimos que a GPU suporta S3TC
+        g_SupportsS3TC = true;
+        stbi_set_flip_vertically_on_load(true);
+        int failures = 0;
+        for (size_t i = 0; i < filenames.size(); ++i)
+        {
+            TextureData texture;
+            if ( !LoadTexture(filenames[i].c_str(), &texture) )
+            {
+                fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", filenames[i].c_str());
+                failures += 1;
+            }
+        }
+        return failures == 0 ? 0 : EXIT_FAILURE;
+    }
 
     // Inicializamos a biblioteca GLFW, utilizada para criar uma janela do
     // sistema operacional, onde poderemos renderizar com OpenGL.
@@ -356,6 +690,9 @@ int main(int argc, char* argv[])
     // funções modernas de OpenGL.
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    if ( headless )
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     // Criamos uma janela do sistema operacional, com 800 colunas e 600 linhas
     // de pixels, e com título "INF01047 ...".
     GLFWwindow* window;
@@ -398,36 +735,56 @@ int main(int argc, char* argv[])
 
     printf("GPU: %s, %s, OpenGL %s, GLSL %s\n", vendor, renderer, glversion, glslversion);
 
+    g_SupportsS3TC = HasExtension("GL_EXT_texture_compression_s3tc") && HasExtension("GL_EXT_texture_sRGB");
+    if ( g_CompressTextures && !g_SupportsS3TC )
+        printf("GPU sem suporte a S3TC: texturas serão enviadas sem compressão.\n");
+
+    if ( HasExtension("GL_ARB_texture_storage") )
+        g_TexStorage2D = (PFN_TexStorage2D) glfwGetProcAddress("glTexStorage2D");
+    if ( HasExtension("GL_ARB_buffer_storage") )
+        g_BufferStorage = (PFN_BufferStorage) glfwGetProcAddress("glBufferStorage");
+
+    // Buffer circular para os uniforms do quadro, as instâncias e o texto
+    FrameRing_Init(FRAMERING_DEFAULT_FRAME_SIZE, g_BufferStorage);
+
     // Carregamos os shaders de vértices e de fragmentos que serão utilizados
     // para renderização. Veja slides 217-219 do documento "Aula_03_Rendering_Pipeline_Grafico.pdf".
     //
     LoadShadersFromFiles();
 
-    // Carregamos duas imagens para serem utilizadas como textura
-    LoadTextureImage("../../data/porto-alegre.jpg");      // TextureImage0
-    LoadTextureImage("../../data/metal_texture.jpg");  // TextureImage1
-
-    // Construímos a representação de objetos geométricos através de malhas de triângulos
-    ObjModel spheremodel("../../data/sphere.obj");
-    ComputeNormals(&spheremodel);
-    BuildTrianglesAndAddToVirtualScene(&spheremodel);
-
-    ObjModel shipmodel("../../data/arwing SNES.obj","../../data/");
-    ComputeNormals(&shipmodel);
-    BuildTrianglesAndAddToVirtualScene(&shipmodel);
-
-    ObjModel planemodel("../../data/plane.obj");
-    ComputeNormals(&planemodel);
-    BuildTrianglesAndAddToVirtualScene(&planemodel);
-
-    ObjModel cow("../../data/cow.obj");
-    ComputeNormals(&cow);
-    BuildTrianglesAndAddToVirtualScene(&cow);
-
-    if ( argc > 1 )
+    // Carregamos as imagens de textura e os modelos em segundo plano, para que
+    // a tela inicial seja mostrada imediatamente. Os objetos passam a ser
+    // desenhados à medida que são enviados para a GPU, dentro do laço de
+    // renderização (veja AssetLoader_Update() abaixo e "assetloader.h").
+    AssetLoader_Init();
+
+    // Carregamos duas imagens para serem utilizadas como textura. Com a
+    // textura virtual, a imagem do plano é carregada por página, e a unidade
+    // de TextureImage0 fica sem uso.
+    if ( g_UseVirtualTexture )
+        g_NumLoadedTextures += 1;
+    else
+        LoadTextureImageAsync("../../data/porto-alegre.jpg");  // TextureImage0
+    LoadTextureImageAsync("../../data/metal_texture.jpg");  // TextureImage1
+
+    if ( g_UseVirtualTexture )
+        LoadVirtualTextureAsync("../../data/porto-alegre.jpg");
+
+    // Construímos a representação de objetos geométricos através de malhas de
+    // triângulos. Veja LoadModelAndAddToVirtualScene() e "meshcache.h".
+    LoadModelAndAddToVirtualSceneAsync("../../data/sphere.obj");
+    LoadModelAndAddToVirtualSceneAsync("../../data/arwing SNES.obj","../../data/");
+    LoadModelAndAddToVirtualSceneAsync("../../data/plane.obj");
+    LoadModelAndAddToVirtualSceneAsync("../../data/cow.obj");
+
+    // Demais argumentos da linha de comando: opções começam com "--", e um
+    // nome de arquivo é carregado como modelo adicional.
+    for (int i = 1; i < argc; ++i)
     {
-        ObjModel model(argv[1]);
-        BuildTrianglesAndAddToVirtualScene(&model);
+        if ( strncmp(argv[i], "--", 2) == 0 )
+            continue;
+
+        LoadModelAndAddToVirtualSceneAsync(argv[i], NULL, false);
     }
 
     // Inicializamos o código para renderização de texto.
@@ -451,21 +808,41 @@ int main(int argc, char* argv[])
     float rotation = 0.0; //Rotação da nave baseada no precionamento de direita e esquerda
     glm::mat4 model_free_camera;
 
-    // bbox dos objetos
-    glm::vec4 cow1_bbox_min_const = glm::vec4(g_VirtualScene["cow"].bbox_min.x,g_VirtualScene["cow"].bbox_min.y,g_VirtualScene["cow"].bbox_min.z,1.0f);
-    glm::vec4 cow1_bbox_min;
-    glm::vec4 cow1_bbox_max_const = glm::vec4(g_VirtualScene["cow"].bbox_max.x,g_VirtualScene["cow"].bbox_max.y,g_VirtualScene["cow"].bbox_max.z,1.0f);
-    glm::vec4 cow1_bbox_max;
-
-    glm::vec4 cow2_bbox_min_const = cow1_bbox_min_const;
-    glm::vec4 cow2_bbox_min;
-    glm::vec4 cow2_bbox_max_const = cow1_bbox_max_const;
-    glm::vec4 cow2_bbox_max;
-
-    glm::vec4 nave_bbox_max_const = glm::vec4(g_VirtualScene["Arwing_SNES_Vert.001"].bbox_max.x,g_VirtualScene["Arwing_SNES_Vert.001"].bbox_max.y,g_VirtualScene["Arwing_SNES_Vert.001"].bbox_max.z,1.0f);
-    glm::vec4 nave_bbox_min_const = glm::vec4(g_VirtualScene["Arwing_SNES_Vert.001"].bbox_min.x,g_VirtualScene["Arwing_SNES_Vert.001"].bbox_min.y,g_VirtualScene["Arwing_SNES_Vert.001"].bbox_min.z,1.0f);
-    glm::vec4 nave_bbox_max;
-    glm::vec4 nave_bbox_min;
+    // bbox dos objetos. Os valores "_const" são definidos dentro do laço de
+    // renderização, quando os modelos terminam de ser carregados.
+    // Identificadores dos objetos desenhados a cada quadro (veja "scene.h").
+    // Os objetos podem ainda não ter sido carregados.
+    const SceneHandle sphere_object = Scene_Handle("sphere");
+    const SceneHandle ship_object   = Scene_Handle("Arwing_SNES_Vert.001");
+    const SceneHandle plane_object  = Scene_Handle("plane");
+    const SceneHandle cow_object    = Scene_Handle("cow");
+
+    bool bbox_carregadas = false;
+
+    glm::vec4 cow_bbox_min_const;
+    glm::vec4 cow_bbox_max_const;
+
+    glm::vec4 nave_bbox_max_const;
+    glm::vec4 nave_bbox_min_const;
+    glm::mat4 nave_model = Matrix_Identity();
+
+    // Caixas orientadas da nave e das vacas alvo (veja "obb.h"). Transformar
+    // somente os cantos da bbox não descreve a caixa depois de uma rotação.
+    Obb nave_obb;
+    Obb vaca1_obb;
+    Obb vaca2_obb;
+
+    // Matrizes dos alvos, para os testes com as suas malhas
+    glm::mat4 vaca1_model = Matrix_Identity();
+    glm::mat4 vaca2_model = Matrix_Identity();
+    glm::mat4 esfera_model = Matrix_Identity();
+
+    // Matrizes e caixas das vacas no início do quadro (as do quadro
+    // anterior), para os testes contínuos dos tiros (veja "sweep.h").
+    glm::mat4 vaca1_model_anterior = Matrix_Identity();
+    glm::mat4 vaca2_model_anterior = Matrix_Identity();
+    Obb vaca1_obb_anterior;
+    Obb vaca2_obb_anterior;
 
     glm::vec4 vaca1_centro;
     glm::vec4 vaca2_centro;
@@ -473,9 +850,67 @@ int main(int argc, char* argv[])
     float vaca1_raio;
     float vaca2_raio;
 
+    // Folhas de cada objeto em g_SceneTree (AABBTREE_NULL se ausente), as
+    // matrizes das vacas adicionais, que não se movem, e os resultados das
+    // consultas.
+    AabbTree_Init(&g_SceneTree);
+    int ship_proxy = AABBTREE_NULL;
+    int cow_proxies[2] = { AABBTREE_NULL, AABBTREE_NULL };
+    int sphere_proxy = AABBTREE_NULL;
+    std::vector<int> shot_proxies;
+    std::vector<glm::mat4> extra_cow_models;
+    std::vector<int> query_results;
+
+    // Alvos dos tiros (esferas: centro em xyz e raio em w) e seus tipos, como
+    // em g_SceneTree, reorganizados a cada quadro em uma grade com hash
+    // espacial (veja "spatialgrid.h").
+    SpatialGrid target_grid;
+    std::vector<glm::vec4> target_spheres;
+    std::vector<int> target_users;
+    std::vector<uint32_t> target_candidates;
+
+    // Os alvos em movimento durante o quadro, para os testes contínuos dos
+    // tiros: as caixas orientadas das vacas e as esferas. "target_slots"
+    // guarda o índice de cada alvo de "target_spheres" no seu conjunto, e
+    // "box_toi" e "ball_toi" os instantes de impacto de um tiro com os alvos
+    // de cada conjunto (veja "sweep.h").
+    MovingObbSet target_boxes;
+    MovingSphereSet target_balls;
+    std::vector<int> target_slots;
+    std::vector<float> box_toi;
+    std::vector<float> ball_toi;
+    MovingObbSet_Clear(&target_boxes);
+    MovingSphereSet_Clear(&target_balls);
+
+    // Caixas orientadas das vacas próximas da nave, para o teste de colisão
+    ObbSet collision_obbs;
+    std::vector<unsigned char> obb_overlap;
+    ObbSet_Clear(&collision_obbs);
+
+    // Instantes (segundos desde glfwInit()) em que o primeiro quadro foi
+    // mostrado e em que todos os recursos terminaram de ser carregados.
+    double tempo_primeiro_quadro = -1.0;
+    double tempo_recursos_carregados = -1.0;
+
     // Ficamos em loop, renderizando, até que o usuário feche a janela
+    int num_frames = 0;
     while (!glfwWindowShouldClose(window))
     {
+        if ( max_frames > 0 && num_frames == max_frames )
+        {
+            printf("%d quadros renderizados; textura virtual: %d páginas enviadas, %d pedidas no último quadro.\n",
+                   num_frames, (int)g_VirtualPagesUploaded, (int)g_VirtualTextureCache.requests.size());
+            const FrameRingStats& ring = FrameRing_Stats();
+            printf("Buffer circular%s: %.1f de %.1f KB no último quadro, %d alocações recusadas, %d esperas pela GPU (%.2f ms).\n",
+                   ring.persistent ? " (persistente)" : "", ring.used / 1024.0, ring.frame_size / 1024.0,
+                   (int)ring.overflows, (int)ring.waits, ring.wait_ms);
+            printf("Árvore de AABBs: %d objetos, altura %d.\n", (int)g_SceneTree.num_proxies, AabbTree_Height(g_SceneTree));
+            if ( g_UseCulling )
+                printf("Descarte pelo frustum: %d objetos visíveis, %d descartados no último quadro.\n",
+                       (int)Culling_Stats().visible, (int)Culling_Stats().culled);
+            break;
+        }
+        num_frames += 1;
 
         double tnow = glfwGetTime();
         deltat = tnow - tprev;
@@ -490,6 +925,57 @@ int main(int argc, char* argv[])
         //           R     G     B     A
         glClearColor(0.7f, 0.7f, 0.7f, 1.0f);
 
+        // Reutilizamos a parte do buffer circular de FRAMERING_FRAMES quadros
+        // atrás, esperando pela GPU se necessário.
+        FrameRing_BeginFrame();
+
+        // Enviamos para a GPU parte dos recursos já carregados em segundo
+        // plano, limitando o tempo gasto neste quadro.
+        AssetLoader_Update(ASSET_UPLOAD_BUDGET_MS);
+
+        // Enviamos níveis maiores das texturas, conforme os tamanhos na tela
+        // pedidos no quadro anterior (veja RequestTextureResolution()).
+        StreamTextures(TEXTURE_STREAM_BUDGET_BYTES);
+
+        // E páginas da textura virtual, conforme o feedback de quadros anteriores
+        UpdateVirtualTexture(VIRTUAL_TEXTURE_PAGES_PER_FRAME);
+
+        g_TrianglesDrawn = 0;
+        g_TrianglesFullDetail = 0;
+
+        if ( !bbox_carregadas && Scene_Get(cow_object) && Scene_Get(ship_object) )
+        {
+            const SceneObject& cow = *Scene_Get(cow_object);
+            const SceneObject& ship = *Scene_Get(ship_object);
+
+            cow_bbox_min_const = glm::vec4(cow.bbox_min.x,cow.bbox_min.y,cow.bbox_min.z,1.0f);
+            cow_bbox_max_const = glm::vec4(cow.bbox_max.x,cow.bbox_max.y,cow.bbox_max.z,1.0f);
+
+            nave_bbox_max_const = glm::vec4(ship.bbox_max.x,ship.bbox_max.y,ship.bbox_max.z,1.0f);
+            nave_bbox_min_const = glm::vec4(ship.bbox_min.x,ship.bbox_min.y,ship.bbox_min.z,1.0f);
+
+            bbox_carregadas = true;
+        }
+
+        // Vacas adicionais ("--cows=N"), em uma grade sobre o plano
+        if ( extra_cow_models.empty() && g_ExtraCows > 0 && Scene_Get(cow_object) )
+        {
+            const SceneObject& cow = *Scene_Get(cow_object);
+            const int side = (int)ceilf(sqrtf((float)g_ExtraCows));
+            const float spacing = 56.0f / side;
+            for (int i = 0; i < g_ExtraCows; ++i)
+            {
+                float x = -28.0f + spacing * (0.5f + i % side);
+                float z = -28.0f + spacing * (0.5f + i / side);
+                glm::mat4 cow_model = Matrix_Translate(x, -0.6f, z) * Matrix_Rotate_Y(0.7f * i);
+
+                glm::vec3 cow_min, cow_max;
+                WorldBoundingBox(cow_model, cow.bbox_min, cow.bbox_max, &cow_min, &cow_max);
+                AabbTree_Insert(&g_SceneTree, cow_min, cow_max, ENTITY_USER(ENTITY_COW, i));
+                extra_cow_models.push_back(cow_model);
+            }
+        }
+
         // Fazemos a chamada da função de movimentação da nave, onde é calculada sua velocidade.
         Anda();
 
@@ -500,6 +986,7 @@ int main(int argc, char* argv[])
         // Pedimos para a GPU utilizar o programa de GPU criado acima (contendo
         // os shaders de vértice e fragmentos).
         glUseProgram(program_id);
+        SetVirtualTextureUniforms();
 
         // Computamos a posição da câmera utilizando coordenadas esféricas.  As
         // variáveis g_CameraDistance, g_CameraPhi, e g_CameraTheta são
@@ -551,6 +1038,10 @@ int main(int argc, char* argv[])
         // Agora computamos a matriz de Projeção.
         glm::mat4 projection;
 
+        // Altura da janela em pixels, para a escolha dos níveis de detalhe
+        int framebuffer_width, framebuffer_height;
+        glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+
         // Note que, no sistema de coordenadas da câmera, os planos near e far
         // estão no sentido negativo! Veja slides 190-193 do documento "Aula_09_Projecoes.pdf".
         float nearplane = -0.1f;  // Posição do "near plane"
@@ -562,6 +1053,9 @@ int main(int argc, char* argv[])
             // Para definição do field of view (FOV), veja slide 227 do documento "Aula_09_Projecoes.pdf".
             float field_of_view = 3.141592 / 3.0f;
             projection = Matrix_Perspective(field_of_view, g_ScreenRatio, nearplane, farplane);
+
+            g_LodPixelsPerUnit = framebuffer_height / (2.0f * tanf(field_of_view / 2.0f));
+            g_LodPerspective = true;
         }
         else
         {
@@ -575,14 +1069,24 @@ int main(int argc, char* argv[])
             float r = t*g_ScreenRatio;
             float l = -r;
             projection = Matrix_Orthographic(l, r, b, t, nearplane, farplane);
+
+            g_LodPixelsPerUnit = framebuffer_height / (t - b);
+            g_LodPerspective = false;
         }
+        g_LodCameraPosition = camera_position_c;
+        Culling_SetFrustum(projection * view);
         glm::mat4 model = Matrix_Identity(); // Transformação identidade de modelagem
 
         // Enviamos as matrizes "view" e "projection" para a placa de vídeo
-        // (GPU). Veja o arquivo "shader_vertex.glsl", onde estas são
-        // efetivamente aplicadas em todos os pontos.
-        glUniformMatrix4fv(view_uniform       , 1 , GL_FALSE , glm::value_ptr(view));
-        glUniformMatrix4fv(projection_uniform , 1 , GL_FALSE , glm::value_ptr(projection));
+        // (GPU), junto com os demais dados do quadro, em um uniform buffer
+        // compartilhado pelos shaders da cena. Veja o arquivo
+        // "shader_vertex.glsl", onde estas são efetivamente aplicadas em
+        // todos os pontos, e "framering.h".
+        FrameUniforms frame_uniforms;
+        memcpy(frame_uniforms.view, glm::value_ptr(view), sizeof(frame_uniforms.view));
+        memcpy(frame_uniforms.projection, glm::value_ptr(projection), sizeof(frame_uniforms.projection));
+        memcpy(frame_uniforms.camera_position, glm::value_ptr(camera_position_c), sizeof(frame_uniforms.camera_position));
+        FrameRing_SetFrameUniforms(frame_uniforms);
 
         #define SPHERE 0
         #define SHIP 1
@@ -592,9 +1096,7 @@ int main(int argc, char* argv[])
         /*
         // Desenhamos o modelo da esfera
         model = Matrix_Translate(-1.0f,0.0f,0.0f);
-        glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(object_id_uniform, SPHERE);
-        DrawVirtualObject("sphere");
+        SubmitVirtualObject(sphere_object, SPHERE, model);
         */
         int dx = anda_esquerda-anda_direita;
         if(dx == 0)
@@ -646,12 +1148,9 @@ int main(int argc, char* argv[])
             /*model = Matrix_Scale(0.04f,0.04f,0.04f)*Matrix_Rotate_Y(0.0f)*
                     Matrix_Rotate_Z(g_CameraPhi)*Matrix_Rotate_Y(3.14+3.14/2)*Matrix_Rotate_Z((rotation)*((3.14/2)*0.8)/ROTATELIMIT);*/
 
-            // Define as medidas de bbox da nave a partir das modificações no modelo
-            nave_bbox_max = Matrix_Scale(0.04f,0.04f,0.04f)*Matrix_Rotate_Y(0.0f)*
-                                            Matrix_Rotate_Z(g_CameraPhi)*Matrix_Rotate_Y(3.14+3.14/2)*Matrix_Rotate_Z((rotation)*((3.14/2)*0.8)/ROTATELIMIT) * nave_bbox_max_const;
-
-            nave_bbox_min = Matrix_Scale(0.04f,0.04f,0.04f)*Matrix_Rotate_Y(0.0f)*
-                                            Matrix_Rotate_Z(g_CameraPhi)*Matrix_Rotate_Y(3.14+3.14/2)*Matrix_Rotate_Z((rotation)*((3.14/2)*0.8)/ROTATELIMIT) * nave_bbox_min_const;
+            // A caixa da nave segue as modificações no modelo
+            nave_model = Matrix_Scale(0.04f,0.04f,0.04f)*Matrix_Rotate_Y(0.0f)*
+                         Matrix_Rotate_Z(g_CameraPhi)*Matrix_Rotate_Y(3.14+3.14/2)*Matrix_Rotate_Z((rotation)*((3.14/2)*0.8)/ROTATELIMIT);
         }
         else
         {
@@ -663,17 +1162,24 @@ int main(int argc, char* argv[])
                     Matrix_Rotate_Z(g_CameraPhi)*Matrix_Rotate_Y(3.14+3.14/2)*Matrix_Rotate_Z((rotation)*((3.14/2)*0.8)/ROTATELIMIT);
             model_free_camera = model;
 
-            // Define as medidas de bbox da nave a partir das modificações no modelo
-            nave_bbox_max = model * nave_bbox_max_const;
+            // A caixa da nave segue as modificações no modelo
+            nave_model = model;
+        }
 
-            nave_bbox_min = model * nave_bbox_min_const;
+        // Caixa da nave no sistema global, para as consultas à árvore
+        glm::vec3 nave_world_min(0.0f), nave_world_max(0.0f);
+        if(bbox_carregadas)
+        {
+            Obb_FromModel(nave_model, glm::vec3(nave_bbox_min_const), glm::vec3(nave_bbox_max_const), &nave_obb);
+            WorldBoundingBox(nave_model, glm::vec3(nave_bbox_min_const), glm::vec3(nave_bbox_max_const), &nave_world_min, &nave_world_max);
         }
+        UpdateSceneProxy(&ship_proxy, bbox_carregadas && !nave_bateu, ENTITY_USER(ENTITY_SHIP, 0),
+                         nave_world_min, nave_world_max, glm::vec3(0.0f));
 
         if(!nave_bateu)
         {
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(object_id_uniform, SHIP);
-            DrawVirtualObject("Arwing_SNES_Vert.001");
+            SubmitVirtualObject(ship_object, SHIP, model);
+            RequestTextureResolution(1, ship_object, model);
         }
         else
         {
@@ -683,27 +1189,59 @@ int main(int argc, char* argv[])
         // Desenhamos o modelo do plano do chão
         model = Matrix_Translate(0.0f,-1.0f,0.0f)
               * Matrix_Scale(30.0f,1.0f,30.0f);
-        glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-        glUniform1i(object_id_uniform, PLANE);
-        DrawVirtualObject("plane");
+        SubmitVirtualObject(plane_object, PLANE, model);
+        RequestTextureResolution(0, plane_object, model);
+
+        // A passada de feedback desenha o plano imediatamente, em outro
+        // framebuffer
+        RenderVirtualTextureFeedback(plane_object, PLANE, model, framebuffer_width, framebuffer_height);
+
+        // Vacas adicionais ("--cows=N"). Todas são desenhadas por uma única
+        // chamada instanciada por nível de detalhe (veja "renderqueue.h"), e
+        // só as que a árvore encontra dentro do frustum são submetidas.
+        if ( g_UseCulling )
+        {
+            float planes[6][4];
+            Culling_GetPlanes(planes);
+            query_results.clear();
+            AabbTree_QueryFrustum(g_SceneTree, planes, &query_results);
+            for (size_t i = 0; i < query_results.size(); ++i)
+            {
+                if ( ENTITY_KIND(query_results[i]) != ENTITY_COW )
+                    continue;
+                int cow = ENTITY_INDEX(query_results[i]);
+                SubmitVirtualObject(cow_object, (cow % 2) ? COWTWO : COW, extra_cow_models[cow]);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < extra_cow_models.size(); ++i)
+                SubmitVirtualObject(cow_object, (i % 2) ? COWTWO : COW, extra_cow_models[i]);
+        }
 
         if(texto == 4 && !vaca1_acertada)
         {
             // Vaca 1
             posicao_vaca = curva_bezier(1);
             model = Matrix_Translate(posicao_vaca.x,posicao_vaca.y,posicao_vaca.z)*Matrix_Scale(1.0f,1.0f,1.0f)*Matrix_Rotate_Y(PI/2);
-            glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(object_id_uniform, COW);
-            DrawVirtualObject("cow");
-            glm::vec4 posicao_vaca;
-
-            //termina modelo de boxman e boxmin da primeira vaca
-            cow1_bbox_min = model * cow1_bbox_min_const;
-            cow1_bbox_max = model * cow1_bbox_max_const;
+            SubmitVirtualObject(cow_object, COW, model);
+            vaca1_model_anterior = vaca1_model;
+            vaca1_obb_anterior = vaca1_obb;
+            vaca1_model = model;
+
+            //termina a caixa da primeira vaca
+            Obb_FromModel(model, glm::vec3(cow_bbox_min_const), glm::vec3(cow_bbox_max_const), &vaca1_obb);
+
+            // Se a vaca acabou de aparecer, ela não se moveu neste quadro
+            if(cow_proxies[0] == AABBTREE_NULL)
+            {
+                vaca1_model_anterior = vaca1_model;
+                vaca1_obb_anterior = vaca1_obb;
+            }
             // Centro da vaca 1
-            vaca1_centro = (cow1_bbox_max + cow1_bbox_min) * 0.5f;
+            vaca1_centro = glm::vec4(vaca1_obb.center, 1.0f);
             // Raio da vaca 1
-            vaca1_raio = norm(vaca1_centro - cow1_bbox_min);
+            vaca1_raio = norm(glm::vec4(vaca1_obb.extents, 0.0f));
         }
 
         if(texto == 4 && !vaca2_acertada)
@@ -711,19 +1249,65 @@ int main(int argc, char* argv[])
             // Vaca 2
             posicao_vaca = curva_bezier(2);
             model = Matrix_Translate(posicao_vaca.x,posicao_vaca.y,posicao_vaca.z)*Matrix_Scale(1.0f,1.0f,1.0f)*Matrix_Rotate_Y(-PI/2);
-            glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(object_id_uniform, COWTWO);
-            DrawVirtualObject("cow");
+            SubmitVirtualObject(cow_object, COWTWO, model);
+            vaca2_model_anterior = vaca2_model;
+            vaca2_obb_anterior = vaca2_obb;
+            vaca2_model = model;
 
-            //termina modelo de boxman e boxmin da segunda vaca
-            cow2_bbox_min = model * cow2_bbox_min_const;
-            cow2_bbox_max = model * cow2_bbox_max_const;
+            //termina a caixa da segunda vaca
+            Obb_FromModel(model, glm::vec3(cow_bbox_min_const), glm::vec3(cow_bbox_max_const), &vaca2_obb);
+
+            // Se a vaca acabou de aparecer, ela não se moveu neste quadro
+            if(cow_proxies[1] == AABBTREE_NULL)
+            {
+                vaca2_model_anterior = vaca2_model;
+                vaca2_obb_anterior = vaca2_obb;
+            }
             // Centro vaca 2
-            vaca2_centro = (cow2_bbox_max + cow2_bbox_min) * 0.5f;
+            vaca2_centro = glm::vec4(vaca2_obb.center, 1.0f);
             // Raio da vaca 2
-            vaca2_raio = norm(vaca2_centro - cow2_bbox_min);
+            vaca2_raio = norm(glm::vec4(vaca2_obb.extents, 0.0f));
         }
 
+        // As vacas entram na árvore com a caixa da sua esfera envolvente,
+        // que contém a caixa orientada em qualquer rotação.
+        UpdateSceneProxy(&cow_proxies[0], bbox_carregadas && texto == 4 && !vaca1_acertada, ENTITY_USER(ENTITY_TARGET_COW, 1),
+                         glm::vec3(vaca1_centro) - glm::vec3(vaca1_raio), glm::vec3(vaca1_centro) + glm::vec3(vaca1_raio), glm::vec3(0.0f));
+        UpdateSceneProxy(&cow_proxies[1], bbox_carregadas && texto == 4 && !vaca2_acertada, ENTITY_USER(ENTITY_TARGET_COW, 2),
+                         glm::vec3(vaca2_centro) - glm::vec3(vaca2_raio), glm::vec3(vaca2_centro) + glm::vec3(vaca2_raio), glm::vec3(0.0f));
+
+
+        // Alvos presentes neste quadro. A esfera alvo é a do quadro anterior,
+        // atualizada mais abaixo. Na grade, cada vaca ocupa a esfera que
+        // envolve todo o seu movimento durante o quadro, ao longo da curva.
+        target_spheres.clear();
+        target_users.clear();
+        target_slots.clear();
+        MovingObbSet_Clear(&target_boxes);
+        MovingSphereSet_Clear(&target_balls);
+        if(cow_proxies[0] != AABBTREE_NULL)
+        {
+            glm::vec3 percurso = vaca1_obb.center - vaca1_obb_anterior.center;
+            target_spheres.push_back(glm::vec4(vaca1_obb_anterior.center + 0.5f*percurso, vaca1_raio + 0.5f*glm::length(percurso)));
+            target_users.push_back(ENTITY_USER(ENTITY_TARGET_COW, 1));
+            target_slots.push_back(MovingObbSet_Add(&target_boxes, vaca1_obb_anterior, vaca1_obb.center));
+        }
+        if(cow_proxies[1] != AABBTREE_NULL)
+        {
+            glm::vec3 percurso = vaca2_obb.center - vaca2_obb_anterior.center;
+            target_spheres.push_back(glm::vec4(vaca2_obb_anterior.center + 0.5f*percurso, vaca2_raio + 0.5f*glm::length(percurso)));
+            target_users.push_back(ENTITY_USER(ENTITY_TARGET_COW, 2));
+            target_slots.push_back(MovingObbSet_Add(&target_boxes, vaca2_obb_anterior, vaca2_obb.center));
+        }
+        if(sphere_proxy != AABBTREE_NULL)
+        {
+            target_spheres.push_back(glm::vec4(glm::vec3(esferacentro), raioesfera));
+            target_users.push_back(ENTITY_USER(ENTITY_TARGET_SPHERE, 0));
+            target_slots.push_back(MovingSphereSet_Add(&target_balls, glm::vec3(esferacentro), glm::vec3(esferacentro), raioesfera));
+        }
+        box_toi.resize(target_boxes.boxes.count);
+        ball_toi.resize(target_balls.count);
+        SpatialGrid_Build(&target_grid, target_spheres.empty() ? NULL : &target_spheres[0], target_spheres.size());
 
         // Detecta se ouve tiro ou não
         if(atira && !Look_at)
@@ -731,57 +1315,157 @@ int main(int argc, char* argv[])
             primeiro=1;
             atira=0;
             itiro+=1;
-            tiros.push_back(std::make_pair(model_free_camera * Matrix_Scale(0.3,0.3,0.3),glm::vec4(camera_view_vector.x,camera_view_vector.y,camera_view_vector.z,0.0)));
-            shotpoints.push_back(glm::vec4(10000.0f,10000.0f,10000.0f,10000.0f));
-            shotrange.push_back(0);
+            if(g_HitscanWeapon)
+            {
+                // O raio parte da nave na direção da câmera. A árvore da cena
+                // seleciona os alvos cujas caixas ele atravessa, e é atingido
+                // o primeiro triângulo encontrado entre as suas malhas.
+                const glm::vec3 origem  = glm::vec3(model_free_camera * glm::vec4(0.0f,0.0f,0.0f,1.0f));
+                const glm::vec3 direcao = glm::vec3(camera_view_vector);
+                query_results.clear();
+                AabbTree_QueryRay(g_SceneTree, origem, direcao, HITSCAN_RANGE, &query_results);
+
+                float mais_proximo = HITSCAN_RANGE;
+                int atingido = -1;
+                for(size_t j=0;j<query_results.size();j++)
+                {
+                    int kind  = ENTITY_KIND(query_results[j]);
+                    int index = ENTITY_INDEX(query_results[j]);
+                    float t;
+                    if((kind == ENTITY_TARGET_COW && texto == 4 &&
+                        RaycastMesh(cow_object, (index == 1) ? vaca1_model : vaca2_model, origem, direcao, mais_proximo, &t)) ||
+                       (kind == ENTITY_TARGET_SPHERE && texto == 3 &&
+                        RaycastMesh(sphere_object, esfera_model, origem, direcao, mais_proximo, &t)))
+                    {
+                        mais_proximo = t;
+                        atingido = query_results[j];
+                    }
+                }
+
+                if(atingido == ENTITY_USER(ENTITY_TARGET_COW, 1))
+                    vaca1_acertada = 1;
+                if(atingido == ENTITY_USER(ENTITY_TARGET_COW, 2))
+                    vaca2_acertada = 1;
+                if(atingido == ENTITY_USER(ENTITY_TARGET_SPHERE, 0))
+                {
+                    sphere_size = sphere_size + 0.1;
+                    if(sphere_size >= 1.5)
+                        texto = 4;
+                }
+            }
+            else
+            {
+                tiros.push_back(std::make_pair(model_free_camera * Matrix_Scale(0.3,0.3,0.3),glm::vec4(camera_view_vector.x,camera_view_vector.y,camera_view_vector.z,0.0)));
+                shotpoints.push_back(glm::vec4(10000.0f,10000.0f,10000.0f,10000.0f));
+                shotrange.push_back(0);
+                shot_proxies.push_back(AABBTREE_NULL);
+            }
         }
-        for(int i=0;i<tiros.size();i++)
+        for(int i=0;i<(int)tiros.size();i++)
         {
             // 25 = velocidade de tiro
-            tiros[i].first = Matrix_Translate(tiros[i].second.x*25*deltat,tiros[i].second.y*25*deltat,tiros[i].second.z*25*deltat)*tiros[i].first;
+            glm::vec4 tiro_anterior = tiros[i].first*glm::vec4(0.0f,0.0f,0.0f,1.0f);
+            glm::vec4 deslocamento = tiros[i].second*25.0f*(float)deltat;
+            tiros[i].first = Matrix_Translate(deslocamento.x,deslocamento.y,deslocamento.z)*tiros[i].first;
             shotrange[i]+= 5*deltat;
             if(shotrange[i] > 10)
             {
-                tiros.erase(std::remove(tiros.begin(), tiros.end(), tiros[i]), tiros.end());
-                shotrange.erase(std::remove(shotrange.begin(), shotrange.end(), shotrange[i]), shotrange.end());
+                UpdateSceneProxy(&shot_proxies[i], false, 0, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f));
+                tiros.erase(tiros.begin() + i);
+                shotrange.erase(shotrange.begin() + i);
+                shotpoints.erase(shotpoints.begin() + i);
+                shot_proxies.erase(shot_proxies.begin() + i);
                 last_i = -1;
+                i -= 1;
+                continue;
             }
             model = tiros[i].first;
             shotpoints[i] = model*glm::vec4(0.0f,0.0f,0.0f,1.0f);
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(object_id_uniform, SPHERE);
-            DrawVirtualObject("sphere");
+            SubmitVirtualObject(sphere_object, SPHERE, model);
 
-            //TESTES DE INTESEÇÃO BALAS
-            if(isPointCircle(shotpoints[i],vaca1_centro,vaca1_raio) && (texto == 4) && !vaca1_acertada)
-            {
-                 vaca1_acertada = 1;
-            }
-            if(isPointCircle(shotpoints[i],vaca2_centro,vaca2_raio) && (texto == 4) && !vaca2_acertada)
+            float tiro_raio = 0.0f;
+            if(Scene_Get(sphere_object))
             {
-                 vaca2_acertada = 1;
+                const SceneObject& tiro = *Scene_Get(sphere_object);
+                glm::vec3 tiro_min, tiro_max;
+                WorldBoundingBox(model, tiro.bbox_min, tiro.bbox_max, &tiro_min, &tiro_max);
+                UpdateSceneProxy(&shot_proxies[i], true, ENTITY_USER(ENTITY_SHOT, 0), tiro_min, tiro_max, glm::vec3(deslocamento));
+                tiro_raio = 0.5f * (tiro.bbox_max.x - tiro.bbox_min.x) * norm(model[0]);
             }
-            if(isPointCircle(shotpoints[i],esferacentro,raioesfera) && (texto == 3))
+
+            //TESTES DE INTESEÇÃO BALAS
+            // O tiro é testado em todo o caminho percorrido no quadro, e não
+            // só na posição final, para que não atravesse os alvos com taxas
+            // de quadros baixas. Só os alvos nas células vizinhas ao caminho
+            // são testados: a esfera do tiro em movimento contra as caixas
+            // das vacas e contra as esferas, cada conjunto de uma vez, e
+            // então contra os triângulos das vacas atingidas.
+            glm::vec3 caminho = glm::vec3(shotpoints[i] - tiro_anterior);
+            target_candidates.clear();
+            SpatialGrid_Query(target_grid, glm::vec3(tiro_anterior) + 0.5f*caminho, 0.5f*glm::length(caminho) + tiro_raio, &target_candidates);
+            bool testou_vacas = false, testou_esferas = false;
+            for(size_t j=0;j<target_candidates.size();j++)
             {
-                if(last_i != i)
+                int kind  = ENTITY_KIND(target_users[target_candidates[j]]);
+                int index = ENTITY_INDEX(target_users[target_candidates[j]]);
+                int slot  = target_slots[target_candidates[j]];
+                if(kind == ENTITY_TARGET_COW && !testou_vacas)
                 {
-                    sphere_size = sphere_size + 0.1;
-                    if(sphere_size >= 1.5)
-                        texto = 4;
-                    last_i = i;
+                    Sweep_SphereVsObbs(glm::vec3(tiro_anterior), glm::vec3(shotpoints[i]), tiro_raio, target_boxes, &box_toi[0]);
+                    testou_vacas = true;
+                }
+                if(kind == ENTITY_TARGET_SPHERE && !testou_esferas)
+                {
+                    Sweep_SphereVsSpheres(glm::vec3(tiro_anterior), glm::vec3(shotpoints[i]), tiro_raio, target_balls, &ball_toi[0]);
+                    testou_esferas = true;
+                }
+                if(kind == ENTITY_TARGET_COW && index == 1 && box_toi[slot] != SWEEP_NO_HIT && (texto == 4) && !vaca1_acertada &&
+                   ShotHitsMesh(cow_object, vaca1_model_anterior, vaca1_model, tiro_anterior, shotpoints[i], tiro_raio))
+                {
+                     vaca1_acertada = 1;
+                }
+                if(kind == ENTITY_TARGET_COW && index == 2 && box_toi[slot] != SWEEP_NO_HIT && (texto == 4) && !vaca2_acertada &&
+                   ShotHitsMesh(cow_object, vaca2_model_anterior, vaca2_model, tiro_anterior, shotpoints[i], tiro_raio))
+                {
+                     vaca2_acertada = 1;
+                }
+                if(kind == ENTITY_TARGET_SPHERE && ball_toi[slot] != SWEEP_NO_HIT && (texto == 3))
+                {
+                    if(last_i != i)
+                    {
+                        sphere_size = sphere_size + 0.1;
+                        if(sphere_size >= 1.5)
+                            texto = 4;
+                        last_i = i;
+                    }
                 }
             }
         }
 
-        //testa se tocou uma vaquinha
-        if(((boxintersect(nave_bbox_min,nave_bbox_max,cow1_bbox_min,cow1_bbox_max) && !vaca1_acertada) ||
-            boxintersect(nave_bbox_min,nave_bbox_max,cow2_bbox_min,cow2_bbox_max) && !vaca2_acertada) && !nave_bateu)
+        //testa se tocou uma vaquinha (as vacas adicionais são decorativas)
+        if(bbox_carregadas && !nave_bateu)
         {
-            nave_bateu = 1;
+            query_results.clear();
+            AabbTree_QueryOverlap(g_SceneTree, nave_world_min, nave_world_max, &query_results);
+            ObbSet_Clear(&collision_obbs);
+            for(size_t j=0;j<query_results.size();j++)
+            {
+                int kind  = ENTITY_KIND(query_results[j]);
+                int index = ENTITY_INDEX(query_results[j]);
+                if(kind == ENTITY_TARGET_COW && index == 1 && !vaca1_acertada)
+                    ObbSet_Add(&collision_obbs, vaca1_obb);
+                else if(kind == ENTITY_TARGET_COW && index == 2 && !vaca2_acertada)
+                    ObbSet_Add(&collision_obbs, vaca2_obb);
+            }
+            obb_overlap.resize(collision_obbs.count);
+            if(collision_obbs.count > 0 && Obb_TestSet(nave_obb, collision_obbs, &obb_overlap[0]) > 0)
+            {
+                nave_bateu = 1;
+            }
         }
 
         //testa se tocou o plano
-        if(isPlaneBox(nave_bbox_min,nave_bbox_max) && !nave_bateu)
+        if(bbox_carregadas && isPlaneBox(nave_obb) && !nave_bateu)
         {
             nave_bateu = 1;
         }
@@ -791,11 +1475,17 @@ int main(int argc, char* argv[])
         {
             model = Matrix_Translate(0.5f,1.0f,1.0f)*Matrix_Scale(sphere_size,sphere_size,sphere_size);
             esferacentro = model*glm::vec4(0.0f,0.0f,0.0f,1.0f);
-            glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-            glUniform1i(object_id_uniform, SPHERE);
-            DrawVirtualObject("sphere");
+            esfera_model = model;
+            SubmitVirtualObject(sphere_object, SPHERE, model);
             raioesfera = sphere_size;
         }
+        UpdateSceneProxy(&sphere_proxy, texto == 3, ENTITY_USER(ENTITY_TARGET_SPHERE, 0),
+                         glm::vec3(esferacentro) - glm::vec3(raioesfera), glm::vec3(esferacentro) + glm::vec3(raioesfera), glm::vec3(0.0f));
+
+        // Desenhamos os objetos submetidos neste quadro que estão dentro do
+        // frustum, agrupados por estado
+        SubmitVisibleObjects();
+        RenderQueue_Flush();
 
         // Mensagens da tela
         switch(texto)
@@ -805,6 +1495,12 @@ int main(int argc, char* argv[])
             TextRendering_PrintString(window, inicio2, -1.0, 0.90, 1.0);
             TextRendering_PrintString(window, inicio3, -1.0, 0.85, 1.0);
             TextRendering_PrintString(window, inicio4, -1.0, 0.80, 1.0);
+            if ( !AssetLoader_Idle() )
+            {
+                char buffer[64];
+                snprintf(buffer, 64, "Carregando... %d/%d", (int)AssetLoader_NumCompleted(), (int)AssetLoader_NumSubmitted());
+                TextRendering_PrintString(window, buffer, -1.0, 0.70, 1.0);
+            }
             break;
         case 1:
             TextRendering_PrintString(window, nave_parada, -1.0, 0.95, 1.0);
@@ -853,14 +1549,40 @@ int main(int argc, char* argv[])
         // por segundo (frames per second).
         TextRendering_ShowFramesPerSecond(window);
 
+        // E o número de triângulos desenhados neste quadro
+        TextRendering_ShowTriangleCount(window);
+
+        // E a memória utilizada na GPU e na memória principal
+        TextRendering_ShowMemoryUsage(window);
+
+        // E as chamadas de desenho e trocas de estado da fila de renderização
+        TextRendering_ShowRenderQueueStats(window);
+
+        // E quantos objetos foram descartados por estarem fora do frustum
+        TextRendering_ShowCullingStats(window);
+
         // o framebuffer onde OpenGL executa as operações de renderização não
         // é o mesmo que está sendo mostrado para o usuário, caso contrário
         // seria possível ver artefatos conhecidos como "screen tearing". A
         // chamada abaixo faz a troca dos buffers, mostrando para o usuário
         // tudo que foi renderizado pelas funções acima.
         // Veja o link: Veja o link: https://en.wikipedia.org/w/index.php?title=Multiple_buffering&oldid=793452829#Double_buffering_in_computer_graphics
+        FrameRing_EndFrame();
         glfwSwapBuffers(window);
 
+        if ( tempo_primeiro_quadro < 0.0 )
+        {
+            tempo_primeiro_quadro = glfwGetTime();
+            printf("Primeiro quadro mostrado em %.1f ms.\n", 1000.0*tempo_primeiro_quadro);
+        }
+        if ( tempo_recursos_carregados < 0.0 && AssetLoader_Idle() )
+        {
+            tempo_recursos_carregados = glfwGetTime();
+            printf("Recursos carregados em %.1f ms.\n", 1000.0*tempo_recursos_carregados);
+            if ( g_MemReport )
+                Resource_PrintReport(stdout);
+        }
+
         // Verificamos com o sistema operacional se houve alguma interação do
         // usuário (teclado, mouse, ...). Caso positivo, as funções de callback
         // definidas anteriormente usando glfwSet*Callback() serão chamadas
@@ -868,44 +1590,225 @@ int main(int argc, char* argv[])
         glfwPollEvents();
 
         if(end_of_program)
-        {
-            glfwTerminate();
-            return 0;
-        }
+            break;
     }
 
-    // Finalizamos o uso dos recursos do sistema operacional
+    // Finalizamos o uso dos recursos do sistema operacional. Os objetos da
+    // OpenGL são destruídos antes do contexto.
+    AssetLoader_Shutdown();
+    if ( g_MemReport )
+        Resource_PrintReport(stdout);
+    FrameRing_Shutdown();
+    Resource_ReleaseAll();
     glfwTerminate();
 
     // Fim do programa
     return 0;
 }
 
-// Função que carrega uma imagem para ser utilizada como textura
-void LoadTextureImage(const char* filename)
+// Verifica se a OpenGL suporta a extensão "name"
+bool HasExtension(const char* name)
 {
-    printf("Carregando imagem \"%s\"... ", filename);
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+    for (GLint i = 0; i < num_extensions; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if ( extension != NULL && strcmp(extension, name) == 0 )
+            return true;
+    }
+    return false;
+}
 
-    // Primeiro fazemos a leitura da imagem do disco
-    stbi_set_flip_vertically_on_load(true);
+// Opções de construção dos caches de texturas (veja "texturecache.h" e
+// "vtexture.h"): compressão em BC1/BC3 se g_CompressTextures e a GPU
+// suportar, com a qualidade g_TextureQuality.
+uint32_t TextureBuildFlags()
+{
+    if ( !g_CompressTextures || !g_SupportsS3TC )
+        return 0;
+    return TEXTURECACHE_FLAG_COMPRESSED | (g_TextureQuality << TEXTURECACHE_QUALITY_SHIFT);
+}
+
+// Lê a imagem "filename" com sua cadeia de mipmaps. Se existir um cache
+// binário válido da imagem (veja "texturecache.h"), ele é mapeado em memória;
+// caso contrário a imagem é decodificada pela stb_image, os mipmaps são
+// gerados e comprimidos em BC1/BC3 (se g_CompressTextures e a GPU suportar),
+// e o resultado é gravado no cache para as próximas execuções. A imagem é
+// invertida verticalmente conforme stbi_set_flip_vertically_on_load(), que
+// deve ter sido chamada antes. Esta função não utiliza a OpenGL, e pode ser
+// executada em uma thread de trabalho.
+bool LoadTexture(const char* filename, TextureData* texture)
+{
+    const uint32_t flags = TextureBuildFlags();
+    const bool compress = (flags & TEXTURECACHE_FLAG_COMPRESSED) != 0;
+
+    if ( TextureCache_Load(filename, flags, texture) )
+    {
+        printf("Carregando imagem \"%s\" do cache... OK (%dx%d).\n", filename, texture->width, texture->height);
+        return true;
+    }
+
+    // Imagens com alpha são lidas em RGBA (e comprimidas em BC3), as demais em RGB
     int width;
     int height;
     int channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 3);
+    if ( !stbi_info(filename, &width, &height, &channels) )
+        return false;
+    channels = (channels == 2 || channels == 4) ? 4 : 3;
+
+    unsigned char *data = stbi_load(filename, &width, &height, NULL, channels);
 
     if ( data == NULL )
+        return false;
+
+    printf("Carregando imagem \"%s\"... OK (%dx%d).\n", filename, width, height);
+
+    TextureCache_BuildMipmaps(data, width, height, channels, texture);
+    stbi_image_free(data);
+
+    if ( compress )
+    {
+        size_t size_before = 0, size_after = 0;
+        for (size_t level = 0; level < texture->levels.size(); ++level)
+            size_before += texture->levels[level].size;
+
+        // A GLFW pode não estar inicializada (veja "--bake-textures")
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        float psnr = TexCompress_CompressTexture(texture, g_TextureQuality);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t level = 0; level < texture->levels.size(); ++level)
+            size_after += texture->levels[level].size;
+
+        printf("  %s (qualidade %d): %d KB -> %d KB, PSNR %.2f dB, %.0f ms.\n",
+               texture->format == TEXTURE_FORMAT_BC3 ? "BC3" : "BC1", g_TextureQuality,
+               (int)(size_before / 1024), (int)(size_after / 1024), psnr, milliseconds);
+    }
+
+    TextureCache_Save(filename, flags, *texture);
+    return true;
+}
+
+// Função que carrega uma imagem para ser utilizada como textura, enviando
+// todos os níveis imediatamente.
+void LoadTextureImage(const char* filename)
+{
+    // Primeiro fazemos a leitura da imagem do disco
+    stbi_set_flip_vertically_on_load(true);
+    TextureData texture;
+    if ( !LoadTexture(filename, &texture) )
     {
         fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", filename);
         std::exit(EXIT_FAILURE);
     }
 
-    printf("OK (%dx%d).\n", width, height);
+    TextureUpload upload;
+    BeginTextureUpload(&upload, g_NumLoadedTextures, &texture, filename);
+    while ( !StepTextureUpload(&upload, (size_t)-1, 0) )
+        ;
+
+    g_NumLoadedTextures += 1;
+}
+
+// Versão assíncrona e progressiva de LoadTextureImage(): a imagem é lida por
+// uma thread de trabalho (veja "assetloader.h"), e os níveis de até
+// TEXTURE_STREAM_INITIAL_SIZE pixels são enviados para a GPU por
+// AssetLoader_Update(), o que já torna a textura utilizável. Os níveis maiores
+// são enviados depois por StreamTextures(). A unidade de textura é reservada
+// imediatamente, logo a ordem das chamadas define as unidades
+// (TextureImage0, 1, ...).
+void LoadTextureImageAsync(const char* filename)
+{
+    struct AsyncTexture
+    {
+        std::string    filename;
+        GLuint         textureunit;
+        bool           loaded;
+        std::shared_ptr<TextureData> texture;
+        TextureUpload  upload;
+        bool           upload_started;
+    };
+
+    std::shared_ptr<AsyncTexture> job(new AsyncTexture);
+    job->filename       = filename;
+    job->textureunit    = g_NumLoadedTextures;
+    job->loaded         = false;
+    job->texture.reset(new TextureData);
+    job->upload_started = false;
+
+    g_NumLoadedTextures += 1;
+
+    // stbi_set_flip_vertically_on_load() altera uma variável global da
+    // stb_image, por isso a chamamos aqui e não nas threads de trabalho.
+    stbi_set_flip_vertically_on_load(true);
+
+    AssetLoader_Submit(
+        [job]()
+        {
+            job->loaded = LoadTexture(job->filename.c_str(), job->texture.get());
+            if ( job->loaded )
+                Resource_AddCpuBytes(RESOURCE_TEXTURES, job->filename.c_str(), (ptrdiff_t)TextureCpuBytes(*job->texture));
+        },
+        [job]()
+        {
+            if ( !job->loaded )
+            {
+                fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", job->filename.c_str());
+                AssetLoader_Shutdown();
+                std::exit(EXIT_FAILURE);
+            }
+
+            if ( !job->upload_started )
+            {
+                BeginTextureUpload(&job->upload, job->textureunit, job->texture.get(), job->filename.c_str());
+                job->upload_started = true;
+                return false;
+            }
+
+            // Primeiro nível pequeno o suficiente para ser enviado imediatamente
+            const std::vector<TextureLevel>& levels = job->texture->levels;
+            size_t initial_level = 0;
+            while ( initial_level + 1 < levels.size()
+                    && std::max(levels[initial_level].width, levels[initial_level].height) > TEXTURE_STREAM_INITIAL_SIZE )
+                initial_level += 1;
+
+            if ( !StepTextureUpload(&job->upload, ASSET_UPLOAD_CHUNK_SIZE, initial_level) )
+                return false;
+
+            if ( job->upload.resident_level > 0 )
+            {
+                StreamedTexture streamed;
+                streamed.filename     = job->filename;
+                streamed.texture      = job->texture;
+                streamed.upload       = job->upload;
+                streamed.wanted_level = levels.size();
+                streamed.priority     = 0.0f;
+                g_StreamedTextures.push_back(streamed);
+            }
+            else
+            {
+                // Todos os níveis já estão na GPU
+                Resource_AddCpuBytes(RESOURCE_TEXTURES, job->filename.c_str(), -(ptrdiff_t)TextureCpuBytes(*job->texture));
+            }
+            return true;
+        });
+}
+
+// Cria a textura e o sampler de uma imagem na unidade "textureunit",
+// alocando todos os níveis de mipmap, sem enviar seus dados. Os dados são
+// enviados em faixas de linhas por StepTextureUpload(). A textura e o
+// sampler pertencem a "owner" (veja "resources.h").
+void BeginTextureUpload(TextureUpload* upload, GLuint textureunit, const TextureData* texture, const char* owner)
+{
+    upload->textureunit    = textureunit;
+    upload->texture        = texture;
+    upload->resident_level = texture->levels.size();
+    upload->next_row       = 0;
 
     // Agora criamos objetos na GPU com OpenGL para armazenar a textura
-    GLuint texture_id;
-    GLuint sampler_id;
-    glGenTextures(1, &texture_id);
-    glGenSamplers(1, &sampler_id);
+    upload->texture_id = Resource_Create(RESOURCE_TEXTURE, RESOURCE_TEXTURES, owner);
+    GLuint sampler_id = Resource_Create(RESOURCE_SAMPLER, RESOURCE_TEXTURES, owner);
 
     // Veja slide 100 do documento "Aula_20_e_21_Mapeamento_de_Texturas.pdf"
     glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -915,48 +1818,763 @@ void LoadTextureImage(const char* filename)
     glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Agora enviamos a imagem lida do disco para a GPU
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    GLenum internalformat = GL_SRGB8;
+    GLenum format = GL_RGB;
+    switch ( texture->format )
+    {
+    case TEXTURE_FORMAT_RGBA8: internalformat = GL_SRGB8_ALPHA8; format = GL_RGBA; break;
+    case TEXTURE_FORMAT_BC1:   internalformat = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT; break;
+    case TEXTURE_FORMAT_BC3:   internalformat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; format = GL_RGBA; break;
+    }
+
+    // Alocamos todos os níveis na GPU, com armazenamento imutável se
+    // disponível (veja g_TexStorage2D). Até o envio do menor nível a textura
+    // é incompleta, e é amostrada como preto; depois, GL_TEXTURE_BASE_LEVEL
+    // acompanha o nível mais detalhado já enviado.
+    const GLint num_levels = (GLint)texture->levels.size();
+    glActiveTexture(GL_TEXTURE0 + textureunit);
+    glBindTexture(GL_TEXTURE_2D, upload->texture_id);
+    if ( g_TexStorage2D != NULL )
+    {
+        g_TexStorage2D(GL_TEXTURE_2D, num_levels, internalformat, texture->width, texture->height);
+    }
+    else
+    {
+        for (GLint level = 0; level < num_levels; ++level)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, internalformat, texture->levels[level].width, texture->levels[level].height,
+                         0, format, GL_UNSIGNED_BYTE, NULL);
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, num_levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+    glBindSampler(textureunit, sampler_id);
+
+    size_t gpu_bytes = 0;
+    for (GLint level = 0; level < num_levels; ++level)
+        gpu_bytes += TextureCache_LevelSize(texture->format, texture->levels[level].width, texture->levels[level].height);
+    Resource_SetGpuBytes(RESOURCE_TEXTURE, upload->texture_id, gpu_bytes);
+}
+
+// Memória principal ocupada pelos níveis de uma textura: o vetor com os
+// níveis decodificados ou, se foi lida do cache, o arquivo mapeado.
+size_t TextureCpuBytes(const TextureData& texture)
+{
+    return texture.storage.capacity() + (texture.mapping.data != NULL ? texture.mapping.size : 0);
+}
+
+// Envia no máximo "max_bytes" bytes (arredondados para linhas inteiras, no
+// mínimo uma linha; nos formatos comprimidos, linhas de blocos de 4 pixels)
+// dos níveis de mipmap, do menor para o maior, até o nível "target_level".
+// Os mipmaps já vêm prontos (veja LoadTexture()), logo não utilizamos
+// glGenerateMipmap(). Retorna true quando "target_level" estiver residente.
+bool StepTextureUpload(TextureUpload* upload, size_t max_bytes, size_t target_level)
+{
+    // Agora enviamos a imagem lida do disco para a GPU
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+    glActiveTexture(GL_TEXTURE0 + upload->textureunit);
+    glBindTexture(GL_TEXTURE_2D, upload->texture_id);
+
+    const uint32_t format = upload->texture->format;
+    const bool compressed = (format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3);
+    const int  row_height = compressed ? 4 : 1;
+
+    while ( upload->resident_level > target_level )
+    {
+        const size_t level_index = upload->resident_level - 1;
+        const TextureLevel& level = upload->texture->levels[level_index];
+        const size_t row_size = TextureCache_LevelSize(format, level.width, row_height);
+        const int num_rows = (level.height + row_height - 1) / row_height;
+
+        int rows = (int)std::min((size_t)(num_rows - upload->next_row), std::max((size_t)1, max_bytes / row_size));
+
+        const int y      = upload->next_row * row_height;
+        const int height = std::min(rows * row_height, level.height - y);
+        const unsigned char* data = level.data + upload->next_row * row_size;
+
+        if ( format == TEXTURE_FORMAT_BC1 )
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level_index, 0, y, level.width, height,
+                                      GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, (GLsizei)(rows * row_size), data);
+        else if ( format == TEXTURE_FORMAT_BC3 )
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level_index, 0, y, level.width, height,
+                                      GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, (GLsizei)(rows * row_size), data);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint)level_index, 0, y, level.width, height,
+                            format == TEXTURE_FORMAT_RGBA8 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, data);
+
+        upload->next_row += rows;
+        if ( upload->next_row == num_rows )
+        {
+            // Nível completo: passa a ser amostrado
+            upload->resident_level = level_index;
+            upload->next_row = 0;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level_index);
+        }
+
+        // Os níveis pequenos cabem juntos em um mesmo envio
+        size_t sent = rows * row_size;
+        if ( sent >= max_bytes )
+            break;
+        max_bytes -= sent;
+    }
+
+    return upload->resident_level <= target_level;
+}
+
+// Envia, em ordem de prioridade, partes dos níveis que faltam às texturas
+// transmitidas progressivamente, até "budget_bytes" bytes. O nível desejado
+// de cada textura é o informado por RequestTextureResolution() no último
+// quadro; texturas que não foram utilizadas não recebem níveis novos. Quando
+// o nível 0 de uma textura chega, seus dados na memória principal são
+// liberados.
+void StreamTextures(size_t budget_bytes)
+{
+    while ( budget_bytes > 0 )
+    {
+        StreamedTexture* best = NULL;
+        for (size_t i = 0; i < g_StreamedTextures.size(); ++i)
+        {
+            StreamedTexture& streamed = g_StreamedTextures[i];
+            if ( streamed.upload.resident_level > streamed.wanted_level
+                 && (best == NULL || streamed.priority > best->priority) )
+                best = &streamed;
+        }
+        if ( best == NULL )
+            break;
+
+        // Enviamos um nível por vez, para que as prioridades sejam
+        // reavaliadas a cada nível.
+        const size_t target = best->upload.resident_level - 1;
+        const TextureLevel& level = best->texture->levels[target];
+        const size_t remaining = TextureCache_LevelSize(best->texture->format, level.width, level.height);
+        const size_t step = std::min(budget_bytes, remaining);
+
+        const int previous_width = best->texture->levels[target + 1].width;
+        if ( StepTextureUpload(&best->upload, step, target) )
+        {
+            // A prioridade diminui conforme a resolução residente aumenta
+            best->priority *= (float)previous_width / (float)level.width;
+        }
+        budget_bytes -= step;
+    }
+
+    for (size_t i = 0; i < g_StreamedTextures.size(); )
+    {
+        StreamedTexture& streamed = g_StreamedTextures[i];
+        if ( streamed.upload.resident_level == 0 )
+        {
+            Resource_AddCpuBytes(RESOURCE_TEXTURES, streamed.filename.c_str(), -(ptrdiff_t)TextureCpuBytes(*streamed.texture));
+            g_StreamedTextures.erase(g_StreamedTextures.begin() + i);
+            continue;
+        }
+
+        // Os pedidos são refeitos a cada quadro
+        streamed.wanted_level = streamed.texture->levels.size();
+        streamed.priority = 0.0f;
+        ++i;
+    }
+}
+
+// Informa que o objeto "object", desenhado com a matriz de modelagem
+// "model", utiliza a textura da unidade "textureunit". O nível necessário é
+// aquele com aproximadamente um texel por pixel ocupado pelo objeto na tela,
+// supondo que a textura cobre a maior dimensão do objeto.
+void RequestTextureResolution(GLuint textureunit, SceneHandle object, const glm::mat4& model)
+{
+    const SceneObject* theobject = Scene_Get(object);
+    if ( theobject == NULL )
+        return;
+
+    for (size_t i = 0; i < g_StreamedTextures.size(); ++i)
+    {
+        StreamedTexture& streamed = g_StreamedTextures[i];
+        if ( streamed.upload.textureunit != textureunit )
+            continue;
+
+        const glm::vec3 extent = theobject->bbox_max - theobject->bbox_min;
+        const float pixels = ProjectedPixelsPerUnit(*theobject, model) * std::max(extent.x, std::max(extent.y, extent.z));
+
+        const std::vector<TextureLevel>& levels = streamed.texture->levels;
+        size_t wanted = 0;
+        while ( wanted + 1 < levels.size() && std::max(levels[wanted + 1].width, levels[wanted + 1].height) >= pixels )
+            wanted += 1;
+
+        const TextureLevel& resident = levels[std::min(streamed.upload.resident_level, levels.size() - 1)];
+        streamed.wanted_level = std::min(streamed.wanted_level, wanted);
+        streamed.priority = std::max(streamed.priority, std::min(pixels, 1e6f) / (float)std::max(resident.width, resident.height));
+    }
+}
+
+// Carrega a imagem aérea "filename" como textura virtual do plano (veja
+// "vtexture.h"). Na primeira execução a imagem é decodificada e dividida em
+// páginas por uma thread de trabalho, e o arquivo de páginas é gravado; nas
+// seguintes ele é apenas mapeado em memória. Ao final do carregamento são
+// criados o cache físico de páginas e a tabela de indireção, e a página do
+// último nível (a imagem inteira em VTEX_PAGE_SIZE texels) é enviada, o que
+// já torna a textura utilizável. As demais páginas são enviadas por
+// UpdateVirtualTexture().
+void LoadVirtualTextureAsync(const char* filename)
+{
+    struct AsyncVirtualTexture
+    {
+        std::string filename;
+        uint32_t    flags;
+        bool        loaded;
+    };
+
+    std::shared_ptr<AsyncVirtualTexture> job(new AsyncVirtualTexture);
+    job->filename = filename;
+    job->flags    = TextureBuildFlags();
+    job->loaded   = false;
+
+    stbi_set_flip_vertically_on_load(true);
+
+    AssetLoader_Submit(
+        [job]()
+        {
+            const char* filename = job->filename.c_str();
+            if ( VirtualTexture_Load(filename, job->flags, &g_VirtualTexture) )
+            {
+                printf("Carregando textura virtual \"%s\"... OK (%dx%d, %d níveis).\n", filename,
+                       g_VirtualTexture.width, g_VirtualTexture.height, g_VirtualTexture.num_levels);
+                job->loaded = true;
+                return;
+            }
+
+            int width;
+            int height;
+            unsigned char *data = stbi_load(filename, &width, &height, NULL, 3);
+            if ( data == NULL )
+                return;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool built = VirtualTexture_Build(filename, job->flags, data, width, height);
+            stbi_image_free(data);
+            if ( !built )
+                return;
+
+            job->loaded = VirtualTexture_Load(filename, job->flags, &g_VirtualTexture);
+            if ( job->loaded )
+            {
+                double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                printf("Dividindo \"%s\" em páginas... OK (%dx%d, %d níveis, %.0f ms).\n", filename,
+                       width, height, g_VirtualTexture.num_levels, milliseconds);
+            }
+        },
+        [job]()
+        {
+            if ( !job->loaded )
+            {
+                fprintf(stderr, "WARNING: Cannot load virtual texture \"%s\"; the plane will not be textured.\n", job->filename.c_str());
+                return true;
+            }
+
+            const VirtualTexture& vt = g_VirtualTexture;
+            const bool compressed = (vt.format == TEXTURE_FORMAT_BC1);
+            const int  cache_size = VTEX_CACHE_SLOTS * VTEX_PAGE_STRIDE;
+
+            // Cache físico de páginas, sem mipmaps: cada página já está no
+            // nível adequado, e a filtragem é bilinear dentro da página.
+            const char* owner = job->filename.c_str();
+            g_VirtualPagesTexture = Resource_Create(RESOURCE_TEXTURE, RESOURCE_VIRTUAL_TEXTURE, owner);
+            GLuint sampler_id = Resource_Create(RESOURCE_SAMPLER, RESOURCE_VIRTUAL_TEXTURE, owner);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            glActiveTexture(GL_TEXTURE0 + VIRTUAL_TEXTURE_PAGES_UNIT);
+            glBindTexture(GL_TEXTURE_2D, g_VirtualPagesTexture);
+            if ( compressed )
+                glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, cache_size, cache_size, 0,
+                                       (GLsizei)TextureCache_LevelSize(TEXTURE_FORMAT_BC1, cache_size, cache_size), NULL);
+            else
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, cache_size, cache_size, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+            glBindSampler(VIRTUAL_TEXTURE_PAGES_UNIT, sampler_id);
+            Resource_SetGpuBytes(RESOURCE_TEXTURE, g_VirtualPagesTexture, TextureCache_LevelSize(vt.format, cache_size, cache_size));
+
+            // Tabela de indireção: um texel por página, um nível de mipmap
+            // por nível da textura virtual, sem interpolação.
+            g_VirtualIndirectionTexture = Resource_Create(RESOURCE_TEXTURE, RESOURCE_VIRTUAL_TEXTURE, owner);
+            sampler_id = Resource_Create(RESOURCE_SAMPLER, RESOURCE_VIRTUAL_TEXTURE, owner);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+            glSamplerParameteri(sampler_id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            glActiveTexture(GL_TEXTURE0 + VIRTUAL_TEXTURE_INDIRECTION_UNIT);
+            glBindTexture(GL_TEXTURE_2D, g_VirtualIndirectionTexture);
+            for (int level = 0; level < vt.num_levels; ++level)
+            {
+                const int pages = VirtualTexture_PagesAt(vt, level);
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, pages, pages, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            }
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, vt.num_levels - 1);
+            glBindSampler(VIRTUAL_TEXTURE_INDIRECTION_UNIT, sampler_id);
+            Resource_SetGpuBytes(RESOURCE_TEXTURE, g_VirtualIndirectionTexture, 4 * VirtualTexture_NumPages(vt));
+
+            // As páginas ficam mapeadas durante todo o programa; a tabela de
+            // indireção também é mantida na memória principal.
+            Resource_AddCpuBytes(RESOURCE_VIRTUAL_TEXTURE, owner, (ptrdiff_t)vt.mapping.size);
+
+            VirtualTexture_InitCache(vt, VTEX_CACHE_SLOTS, &g_VirtualTextureCache);
+            Resource_AddCpuBytes(RESOURCE_VIRTUAL_TEXTURE, owner, (ptrdiff_t)g_VirtualTextureCache.indirection.capacity());
+            g_VirtualTextureReady = true;
+
+            // A página do último nível nunca sai do cache
+            VirtualTexturePage root = { vt.num_levels - 1, 0, 0 };
+            g_VirtualTextureCache.requests.push_back(root);
+            UpdateVirtualTexture(0);
+            return true;
+        });
+}
+
+// Envia a página "page" para a posição "slot" do cache físico
+static void UploadVirtualTexturePage(const VirtualTexturePage& page, int slot)
+{
+    const VirtualTexture& vt = g_VirtualTexture;
+    const unsigned char* data = VirtualTexture_PageData(vt, page.level, page.x, page.y);
+    const int x = (slot % g_VirtualTextureCache.slots) * VTEX_PAGE_STRIDE;
+    const int y = (slot / g_VirtualTextureCache.slots) * VTEX_PAGE_STRIDE;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+    glActiveTexture(GL_TEXTURE0 + VIRTUAL_TEXTURE_PAGES_UNIT);
+    glBindTexture(GL_TEXTURE_2D, g_VirtualPagesTexture);
+    if ( vt.format == TEXTURE_FORMAT_BC1 )
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, VTEX_PAGE_STRIDE, VTEX_PAGE_STRIDE,
+                                  GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, (GLsizei)vt.page_size, data);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, VTEX_PAGE_STRIDE, VTEX_PAGE_STRIDE, GL_RGB, GL_UNSIGNED_BYTE, data);
+
+    g_VirtualPagesUploaded += 1;
+}
+
+// Lê o feedback copiado dois quadros antes (veja
+// RenderVirtualTextureFeedback()), envia até "max_pages" das páginas que
+// faltam, as menos detalhadas primeiro, e atualiza a tabela de indireção.
+// Com "max_pages" igual a zero apenas envia as páginas já agendadas.
+void UpdateVirtualTexture(int max_pages)
+{
+    if ( !g_VirtualTextureReady )
+        return;
+
+    VirtualTextureCache& cache = g_VirtualTextureCache;
+
+    if ( max_pages > 0 )
+    {
+        const int index = g_FeedbackIndex;
+        const unsigned char* pixels = NULL;
+        if ( g_FeedbackPixels[index] > 0 )
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, g_FeedbackBuffers[index]);
+            pixels = (const unsigned char*) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4*g_FeedbackPixels[index], GL_MAP_READ_BIT);
+        }
+
+        VirtualTexture_ProcessFeedback(g_VirtualTexture, &cache, pixels, pixels ? g_FeedbackPixels[index] : 0);
+
+        if ( g_FeedbackPixels[index] > 0 )
+        {
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            g_FeedbackPixels[index] = 0;
+        }
+    }
+
+    const size_t num_pages = max_pages > 0 ? std::min(cache.requests.size(), (size_t)max_pages) : cache.requests.size();
+    for (size_t i = 0; i < num_pages; ++i)
+    {
+        const VirtualTexturePage page = cache.requests[i];
+        int slot = VirtualTexture_AllocateSlot(g_VirtualTexture, &cache, page);
+        if ( slot < 0 )
+            break;
+        UploadVirtualTexturePage(page, slot);
+    }
+
+    if ( VirtualTexture_UpdateIndirection(g_VirtualTexture, &cache) )
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glActiveTexture(GL_TEXTURE0 + VIRTUAL_TEXTURE_INDIRECTION_UNIT);
+        glBindTexture(GL_TEXTURE_2D, g_VirtualIndirectionTexture);
+        for (int level = 0; level < g_VirtualTexture.num_levels; ++level)
+        {
+            const int pages = VirtualTexture_PagesAt(g_VirtualTexture, level);
+            const size_t first = VirtualTexture_PageIndex(g_VirtualTexture, level, 0, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, pages, pages, GL_RGBA, GL_UNSIGNED_BYTE, &cache.indirection[4*first]);
+        }
+    }
+}
+
+// Envia os parâmetros da textura virtual para o programa de GPU, que deve
+// estar em uso (veja "shader_fragment.glsl").
+void SetVirtualTextureUniforms()
+{
+    glUniform1i(virtual_texture_enabled_uniform, g_VirtualTextureReady ? 1 : 0);
+    glUniform1i(virtual_texture_feedback_uniform, 0);
+    if ( !g_VirtualTextureReady )
+        return;
+
+    const VirtualTexture& vt = g_VirtualTexture;
+    const float size = (float)(vt.pages * VTEX_PAGE_SIZE);
+    glUniform2f(virtual_texture_uv_scale_uniform, vt.width / size, vt.height / size);
+    glUniform1f(virtual_texture_pages_uniform, (float)vt.pages);
+    glUniform1f(virtual_texture_levels_uniform, (float)vt.num_levels);
+    glUniform1f(virtual_texture_cache_size_uniform, (float)(VTEX_CACHE_SLOTS * VTEX_PAGE_STRIDE));
+    glUniform1f(virtual_texture_lod_bias_uniform, 0.0f);
+}
+
+// Passada de feedback: desenha novamente o objeto "object" (o único com
+// textura virtual) em um framebuffer com 1/VIRTUAL_TEXTURE_FEEDBACK_SCALE da
+// resolução da janela ("width" x "height"), onde cada pixel recebe a página
+// necessária naquele ponto da tela. O resultado é copiado para um pixel
+// buffer object, lido em UpdateVirtualTexture() dois quadros depois.
+void RenderVirtualTextureFeedback(SceneHandle object, int material, const glm::mat4& model, int width, int height)
+{
+    if ( !g_VirtualTextureReady )
+        return;
+
+    const int feedback_width  = std::max(1, width / VIRTUAL_TEXTURE_FEEDBACK_SCALE);
+    const int feedback_height = std::max(1, height / VIRTUAL_TEXTURE_FEEDBACK_SCALE);
+
+    // (Re)criamos o framebuffer quando o tamanho da janela muda
+    if ( feedback_width != g_FeedbackWidth || feedback_height != g_FeedbackHeight )
+    {
+        const char* owner = "feedback da textura virtual";
+        if ( g_FeedbackFramebuffer == 0 )
+        {
+            g_FeedbackFramebuffer = Resource_Create(RESOURCE_FRAMEBUFFER, RESOURCE_RENDER_TARGETS, owner);
+            for (int i = 0; i < 2; ++i)
+            {
+                g_FeedbackRenderbuffers[i] = Resource_Create(RESOURCE_RENDERBUFFER, RESOURCE_RENDER_TARGETS, owner);
+                g_FeedbackBuffers[i] = Resource_Create(RESOURCE_BUFFER, RESOURCE_RENDER_TARGETS, owner);
+            }
+        }
+
+        // Cor RGBA8 e profundidade de 24 bits (em geral armazenada em 32)
+        const size_t feedback_bytes = 4 * (size_t)feedback_width * feedback_height;
+
+        glBindRenderbuffer(GL_RENDERBUFFER, g_FeedbackRenderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, feedback_width, feedback_height);
+        glBindRenderbuffer(GL_RENDERBUFFER, g_FeedbackRenderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, feedback_width, feedback_height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        Resource_SetGpuBytes(RESOURCE_RENDERBUFFER, g_FeedbackRenderbuffers[0], feedback_bytes);
+        Resource_SetGpuBytes(RESOURCE_RENDERBUFFER, g_FeedbackRenderbuffers[1], feedback_bytes);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, g_FeedbackFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, g_FeedbackRenderbuffers[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_FeedbackRenderbuffers[1]);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, g_FeedbackBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, feedback_bytes, NULL, GL_STREAM_READ);
+            Resource_SetGpuBytes(RESOURCE_BUFFER, g_FeedbackBuffers[i], feedback_bytes);
+            g_FeedbackPixels[i] = 0;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        g_FeedbackWidth  = feedback_width;
+        g_FeedbackHeight = feedback_height;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, g_FeedbackFramebuffer);
+    glViewport(0, 0, feedback_width, feedback_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // As derivadas das coordenadas de textura são VIRTUAL_TEXTURE_FEEDBACK_SCALE
+    // vezes maiores que na janela, o que compensamos no nível de mipmap.
+    glUniform1i(virtual_texture_feedback_uniform, 1);
+    glUniform1f(virtual_texture_lod_bias_uniform, -log2f((float)VIRTUAL_TEXTURE_FEEDBACK_SCALE));
+
+    // A passada de feedback não entra na contagem de triângulos do quadro
+    const size_t triangles_drawn = g_TrianglesDrawn;
+    const size_t triangles_full_detail = g_TrianglesFullDetail;
+    DrawVirtualObject(object, material, model);
+    g_TrianglesDrawn = triangles_drawn;
+    g_TrianglesFullDetail = triangles_full_detail;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, g_FeedbackBuffers[g_FeedbackIndex]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, feedback_width, feedback_height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    g_FeedbackPixels[g_FeedbackIndex] = (size_t)feedback_width * feedback_height;
+    g_FeedbackIndex = 1 - g_FeedbackIndex;
+
+    glUniform1i(virtual_texture_feedback_uniform, 0);
+    glUniform1f(virtual_texture_lod_bias_uniform, 0.0f);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+}
+
+// Número de pixels na tela ocupados por uma unidade de comprimento do espaço
+// do modelo, no ponto da esfera envolvente do objeto mais próximo da câmera,
+// quando desenhado com a matriz de modelagem "model". Retorna infinito se a
+// câmera estiver dentro da esfera.
+float ProjectedPixelsPerUnit(const SceneObject& theobject, const glm::mat4& model)
+{
+    // Maior fator de escala da matriz de modelagem
+    float scale = std::max(norm(model[0]), std::max(norm(model[1]), norm(model[2])));
+
+    glm::vec4 center = model * glm::vec4((theobject.bbox_min + theobject.bbox_max) * 0.5f, 1.0f);
+    float radius = 0.5f * scale * glm::length(theobject.bbox_max - theobject.bbox_min);
+
+    float pixels_per_unit = g_LodPixelsPerUnit * scale;
+    if ( g_LodPerspective )
+    {
+        float distance = norm(center - g_LodCameraPosition) - radius;
+        if ( distance <= 0.0f )
+            return std::numeric_limits<float>::infinity();
+        pixels_per_unit /= distance;
+    }
+    return pixels_per_unit;
+}
+
+// Escolhe o nível de detalhe de um objeto desenhado com a matriz de modelagem
+// "model": o menos detalhado cujo erro geométrico, projetado na tela a partir
+// do ponto mais próximo da esfera envolvente do objeto, seja no máximo
+// LOD_MAX_PIXEL_ERROR pixels. Retorna -1 para o objeto original.
+int SelectLod(const SceneObject& theobject, const glm::mat4& model)
+{
+    if ( !g_UseLods || theobject.num_lods == 0 )
+        return -1;
+
+    float pixels_per_unit = ProjectedPixelsPerUnit(theobject, model);
+
+    const SceneObjectLod* lods = Scene_Lods(theobject);
+
+    int selected = -1;
+    for (int lod = 0; lod < theobject.num_lods; ++lod)
+    {
+        if ( lods[lod].error * pixels_per_unit > LOD_MAX_PIXEL_ERROR )
+            break;
+        selected = lod;
+    }
+    return selected;
+}
+
+// Preenche o VAO, o modo de rasterização e os índices de "packet" com os do
+// objeto "object" da cena virtual. Se a matriz de modelagem "model" for dada,
+// o objeto pode ser desenhado com um de seus níveis de detalhe (veja
+// SelectLod()). Os triângulos são somados em g_TrianglesDrawn. Retorna false
+// se o objeto ainda não foi carregado.
+bool MakeRenderPacket(SceneHandle object, const glm::mat4* model, RenderPacket* packet)
+{
+    // Objetos que ainda estão sendo carregados (veja "assetloader.h") não
+    // estão na cena virtual, e simplesmente não são desenhados.
+    const SceneObject* loaded = Scene_Get(object);
+    if ( loaded == NULL )
+        return false;
+
+    const SceneObject& theobject = *loaded;
+
+    packet->vertex_array_object_id = theobject.vertex_array_object_id;
+    packet->rendering_mode = theobject.rendering_mode;
+    packet->index_type     = theobject.index_type;
+    packet->first_index    = theobject.first_index;
+    packet->num_indices    = theobject.num_indices;
+
+    int lod = model ? SelectLod(theobject, *model) : -1;
+    if ( lod >= 0 )
+    {
+        packet->first_index = Scene_Lods(theobject)[lod].first_index;
+        packet->num_indices = Scene_Lods(theobject)[lod].num_indices;
+    }
+
+    g_TrianglesDrawn      += packet->num_indices / 3;
+    g_TrianglesFullDetail += theobject.num_indices / 3;
+    return true;
+}
+
+// Submete o objeto "object", com o material "material" (o valor de
+// "object_id" em shader_fragment.glsl) e a matriz de modelagem "model", para
+// ser desenhado ao final do quadro. O objeto só é colocado na fila de
+// renderização por SubmitVisibleObjects(), se estiver dentro do frustum.
+void SubmitVirtualObject(SceneHandle object, int material, const glm::mat4& model)
+{
+    const SceneObject* theobject = Scene_Get(object);
+    if ( theobject == NULL )
+        return;
+
+    // Esfera envolvente da bounding box, no sistema de coordenadas global.
+    // O raio é multiplicado pela maior escala da matriz de modelagem.
+    glm::vec4 center = model * glm::vec4((theobject->bbox_min + theobject->bbox_max) * 0.5f, 1.0f);
+    float scale = std::max(norm(model[0]), std::max(norm(model[1]), norm(model[2])));
+    float radius = 0.5f * norm(glm::vec4(theobject->bbox_max - theobject->bbox_min, 0.0f)) * scale;
+
+    Culling_Add(glm::vec3(center), radius);
+
+    PendingObject pending;
+    pending.object   = object;
+    pending.material = material;
+    pending.model    = model;
+    g_PendingObjects.push_back(pending);
+}
+
+// Testa as esferas envolventes de todos os objetos submetidos no quadro
+// contra o frustum (veja "culling.h") e coloca os visíveis na fila de
+// renderização, ordenados por estado e distância até a câmera. Os níveis de
+// detalhe e a contagem de triângulos só consideram os objetos visíveis.
+void SubmitVisibleObjects()
+{
+    if ( g_UseCulling )
+        Culling_Run();
+
+    for (size_t i = 0; i < g_PendingObjects.size(); ++i)
+    {
+        if ( g_UseCulling && !Culling_Visible(i) )
+            continue;
+
+        const PendingObject& pending = g_PendingObjects[i];
+
+        RenderPacket packet;
+        if ( !MakeRenderPacket(pending.object, &pending.model, &packet) )
+            continue;
+
+        packet.program  = SCENE_PROGRAM;
+        packet.material = pending.material;
+        packet.model    = pending.model;
+
+        const SceneObject& theobject = *Scene_Get(pending.object);
+        glm::vec4 center = pending.model * glm::vec4((theobject.bbox_min + theobject.bbox_max) * 0.5f, 1.0f);
+        RenderQueue_Submit(packet, norm(center - g_LodCameraPosition));
+    }
+
+    g_PendingObjects.clear();
+    Culling_Clear();
+}
+
+// Função que desenha imediatamente um objeto da cena virtual (veja
+// "scene.h"), sem passar pela fila de renderização, com o programa de GPU
+// atualmente em uso. A matriz de modelagem e o material são enviados como
+// uma única instância (veja RenderQueue_Draw()).
+void DrawVirtualObject(SceneHandle object, int material, const glm::mat4& model)
+{
+    RenderPacket packet;
+    if ( !MakeRenderPacket(object, &model, &packet) )
+        return;
+
+    packet.material = material;
+    packet.model    = model;
+    RenderQueue_Draw(packet);
+}
+
+// Calcula a caixa alinhada aos eixos, no sistema global, que contém a bounding
+// box [bbox_min, bbox_max] do modelo transformada por "model". Cada eixo da
+// caixa resultante soma as contribuições das colunas da matriz, escolhendo o
+// extremo da bbox conforme o sinal de cada coeficiente.
+void WorldBoundingBox(const glm::mat4& model, const glm::vec3& bbox_min, const glm::vec3& bbox_max, glm::vec3* world_min, glm::vec3* world_max)
+{
+    glm::vec3 result_min(model[3]);
+    glm::vec3 result_max(model[3]);
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            float a = model[column][row] * bbox_min[column];
+            float b = model[column][row] * bbox_max[column];
+            result_min[row] += std::min(a, b);
+            result_max[row] += std::max(a, b);
+        }
+    }
+    *world_min = result_min;
+    *world_max = result_max;
+}
+
+const MeshBvh* GetSceneBvh(SceneHandle object)
+{
+    if ( object < 0 || (size_t)object >= g_SceneBvhs.size() || g_SceneBvhs[object].nodes.empty() )
+        return NULL;
+    return &g_SceneBvhs[object];
+}
 
-    GLuint textureunit = g_NumLoadedTextures;
-    glActiveTexture(GL_TEXTURE0 + textureunit);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindSampler(textureunit, sampler_id);
+// Teste exato (fase estreita) de um tiro contra a malha de um objeto, que
+// durante o quadro se move (sem girar nem mudar de escala, que deve ser
+// uniforme) de "start_model" a "end_model": a esfera de raio "radius" do
+// tiro, varrida ao longo do caminho relativo ao objeto de "from" a "to",
+// toca algum triângulo. Sem a hierarquia do objeto vale o teste feito antes,
+// com a caixa orientada.
+bool ShotHitsMesh(SceneHandle object, const glm::mat4& start_model, const glm::mat4& end_model, const glm::vec4& from, const glm::vec4& to, float radius)
+{
+    const MeshBvh* bvh = GetSceneBvh(object);
+    if ( bvh == NULL )
+        return true;
 
-    stbi_image_free(data);
+    const glm::vec3 model_from = glm::vec3(glm::inverse(start_model) * glm::vec4(glm::vec3(from), 1.0f));
+    const glm::vec3 model_to   = glm::vec3(glm::inverse(end_model) * glm::vec4(glm::vec3(to), 1.0f));
 
-    g_NumLoadedTextures += 1;
+    return MeshBvh_IntersectCapsule(*bvh, model_from, model_to, radius / norm(end_model[0]));
 }
 
-// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
-// dos objetos na função BuildTrianglesAndAddToVirtualScene().
-void DrawVirtualObject(const char* object_name)
+// Raio origin + t*direction, com t em [0, max_t], contra a malha de um objeto
+// transformada por "model"; o menor t é gravado em *t. O raio é levado para o
+// sistema de coordenadas do modelo sem normalizar a direção, logo t não muda.
+// Sem a hierarquia do objeto é testada a sua bounding box.
+bool RaycastMesh(SceneHandle object, const glm::mat4& model, const glm::vec3& origin, const glm::vec3& direction, float max_t, float* t)
 {
-    // "Ligamos" o VAO. Informamos que queremos utilizar os atributos de
-    // vértices apontados pelo VAO criado pela função BuildTrianglesAndAddToVirtualScene(). Veja
-    // comentários detalhados dentro da definição de BuildTrianglesAndAddToVirtualScene().
-    glBindVertexArray(g_VirtualScene[object_name].vertex_array_object_id);
+    const glm::mat4 inverse = glm::inverse(model);
+    const glm::vec3 model_origin    = glm::vec3(inverse * glm::vec4(origin, 1.0f));
+    const glm::vec3 model_direction = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+
+    const MeshBvh* bvh = GetSceneBvh(object);
+    if ( bvh != NULL )
+    {
+        MeshBvhHit hit;
+        if ( !MeshBvh_Raycast(*bvh, model_origin, model_direction, max_t, &hit) )
+            return false;
+        *t = hit.t;
+        return true;
+    }
 
-    // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
-    // apontados pelo VAO como linhas. Veja a definição de
-    // g_VirtualScene[""] dentro da função BuildTrianglesAndAddToVirtualScene(), e veja
-    // a documentação da função glDrawElements() em
-    // http://docs.gl/gl3/glDrawElements.
-    glDrawElements(
-        g_VirtualScene[object_name].rendering_mode,
-        g_VirtualScene[object_name].num_indices,
-        GL_UNSIGNED_INT,
-        (void*)g_VirtualScene[object_name].first_index
-    );
+    const SceneObject* theobject = Scene_Get(object);
+    if ( theobject == NULL )
+        return false;
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+    float t_enter = 0.0f;
+    float t_exit  = max_t;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float t0 = (theobject->bbox_min[axis] - model_origin[axis]) / model_direction[axis];
+        float t1 = (theobject->bbox_max[axis] - model_origin[axis]) / model_direction[axis];
+        if ( t0 > t1 )
+            std::swap(t0, t1);
+        t_enter = std::max(t_enter, t0);
+        t_exit  = std::min(t_exit, t1);
+    }
+    if ( t_enter > t_exit )
+        return false;
+    *t = t_enter;
+    return true;
+}
+
+// Insere o objeto com a caixa [min, max] em g_SceneTree, atualiza sua caixa se
+// já estiver na árvore, ou o remove se "present" for falso. "*proxy" é a folha
+// do objeto, ou AABBTREE_NULL se não estiver na árvore.
+void UpdateSceneProxy(int* proxy, bool present, int user, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement)
+{
+    if ( !present )
+    {
+        if ( *proxy != AABBTREE_NULL )
+            AabbTree_Remove(&g_SceneTree, *proxy);
+        *proxy = AABBTREE_NULL;
+    }
+    else if ( *proxy == AABBTREE_NULL )
+    {
+        *proxy = AabbTree_Insert(&g_SceneTree, min, max, user);
+    }
+    else
+    {
+        AabbTree_Update(&g_SceneTree, *proxy, min, max, displacement);
+    }
 }
 
 // Função que carrega os shaders de vértices e de fragmentos que serão
@@ -995,18 +2613,25 @@ void LoadShadersFromFiles()
     // Buscamos o endereço das variáveis definidas dentro do Vertex Shader.
     // Utilizaremos estas variáveis para enviar dados para a placa de vídeo
     // (GPU)! Veja arquivo "shader_vertex.glsl" e "shader_fragment.glsl".
-    model_uniform           = glGetUniformLocation(program_id, "model"); // Variável da matriz "model"
-    view_uniform            = glGetUniformLocation(program_id, "view"); // Variável da matriz "view" em shader_vertex.glsl
-    projection_uniform      = glGetUniformLocation(program_id, "projection"); // Variável da matriz "projection" em shader_vertex.glsl
-    object_id_uniform       = glGetUniformLocation(program_id, "object_id"); // Variável "object_id" em shader_fragment.glsl
+    glUniformBlockBinding(program_id, glGetUniformBlockIndex(program_id, "FrameUniforms"), FRAME_UNIFORMS_BINDING); // "view", "projection", etc. (veja "framering.h")
     bbox_min_uniform  = glGetUniformLocation(program_id, "bbox_min");
     bbox_max_uniform  = glGetUniformLocation(program_id, "bbox_max");
+    RenderQueue_SetProgram(SCENE_PROGRAM, program_id); // A matriz "model" e "object_id" são atributos por instância
+    virtual_texture_enabled_uniform    = glGetUniformLocation(program_id, "virtual_texture_enabled");
+    virtual_texture_feedback_uniform   = glGetUniformLocation(program_id, "virtual_texture_feedback");
+    virtual_texture_uv_scale_uniform   = glGetUniformLocation(program_id, "virtual_texture_uv_scale");
+    virtual_texture_pages_uniform      = glGetUniformLocation(program_id, "virtual_texture_pages");
+    virtual_texture_levels_uniform     = glGetUniformLocation(program_id, "virtual_texture_levels");
+    virtual_texture_cache_size_uniform = glGetUniformLocation(program_id, "virtual_texture_cache_size");
+    virtual_texture_lod_bias_uniform   = glGetUniformLocation(program_id, "virtual_texture_lod_bias");
 
     // Variáveis em "shader_fragment.glsl" para acesso das imagens de textura
     glUseProgram(program_id);
     glUniform1i(glGetUniformLocation(program_id, "TextureImage0"), 0);
     glUniform1i(glGetUniformLocation(program_id, "TextureImage1"), 1);
     glUniform1i(glGetUniformLocation(program_id, "TextureImage2"), 2);
+    glUniform1i(glGetUniformLocation(program_id, "VirtualPages"), VIRTUAL_TEXTURE_PAGES_UNIT);
+    glUniform1i(glGetUniformLocation(program_id, "VirtualIndirection"), VIRTUAL_TEXTURE_INDIRECTION_UNIT);
     glUseProgram(0);
 }
 
@@ -1029,146 +2654,314 @@ void PopMatrix(glm::mat4& M)
         g_MatrixStack.pop();
     }
 }
-void ComputeNormalsPhong(ObjModel* model)
+// Função que computa as normais de um ObjModel, caso elas não tenham sido
+// especificadas dentro do arquivo ".obj". A normal de cada vértice é a média
+// das normais dos triângulos que o compartilham (método de Gouraud), com peso
+// proporcional à área ou ao ângulo de cada triângulo no vértice (veja
+// "meshnormals.h").
+void ComputeNormals(ObjModel* model, int weighting)
 {
     if ( !model->attrib.normals.empty() )
         return;
 
-    // Primeiro computamos as normais para todos os TRIÂNGULOS.
-    // Segundo, computamos as normais dos VÉRTICES através do método proposto
-    // por Gourad, onde a normal de cada vértice vai ser a média das normais de
-    // todas as faces que compartilham este vértice.
-
     size_t num_vertices = model->attrib.vertices.size() / 3;
 
-    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
-    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f,0.0f,0.0f,0.0f));
-
+    // Índices das posições de todos os triângulos, de todos os shapes
+    std::vector<uint32_t> indices;
     for (size_t shape = 0; shape < model->shapes.size(); ++shape)
     {
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+        tinyobj::mesh_t& mesh = model->shapes[shape].mesh;
+        for (size_t i = 0; i < mesh.indices.size(); ++i)
+        {
+            assert(mesh.num_face_vertices[i / 3] == 3);
+            indices.push_back((uint32_t)mesh.indices[i].vertex_index);
+            mesh.indices[i].normal_index = mesh.indices[i].vertex_index;
+        }
+    }
 
-        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
+    MeshAdjacency adjacency;
+    MeshAdjacency_Build(indices.data(), indices.size(), num_vertices, &adjacency);
+
+    model->attrib.normals.resize( 3*num_vertices );
+    MeshNormals_Compute(model->attrib.vertices.data(), num_vertices, indices.data(), indices.size(),
+                        adjacency, weighting, model->attrib.normals.data());
+}
+
+// Constrói triângulos para futura renderização a partir de um ObjModel.
+void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
+{
+    MeshData mesh;
+    BuildTriangles(model, &mesh);
+    MeshOpt_PackVertices(&mesh);
+    MeshOpt_PackIndices(&mesh);
+    AddMeshToVirtualScene(mesh, model->filename.c_str());
+}
+
+// Carrega a malha do modelo "filename". Se existir um cache binário válido do
+// modelo (veja "meshcache.h"), ele é mapeado em memória; caso contrário o
+// arquivo ".obj" é lido, as normais são computadas (se "compute_normals"), e o
+// resultado é gravado no cache para as próximas execuções. Esta função não
+// utiliza a OpenGL, e pode ser executada em uma thread de trabalho.
+void LoadMesh(const char* filename, const char* basepath, bool compute_normals, MeshData* mesh)
+{
+    uint32_t flags = (compute_normals ? MESHCACHE_FLAG_COMPUTED_NORMALS : 0)
+                   | (g_OptimizeMeshes ? MESHCACHE_FLAG_OPTIMIZED : 0)
+                   | (g_UseLods ? MESHCACHE_FLAG_LODS : 0);
+
+    if ( MeshCache_Load(filename, flags, mesh) )
+    {
+        printf("Carregando modelo \"%s\" do cache... OK.\n", filename);
+    }
+    else
+    {
+        ObjModel model(filename, basepath);
+        if ( compute_normals )
+            ComputeNormals(&model);
+        BuildTriangles(&model, mesh);
+
+        if ( g_UseLods )
         {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+            // Níveis de detalhe simplificados, que compartilham os vértices
+            // da malha original.
+            MeshOpt_GenerateLods(mesh);
 
-            glm::vec4  vertices[3];
-            for (size_t vertex = 0; vertex < 3; ++vertex)
+            for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
             {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                vertices[vertex] = glm::vec4(vx,vy,vz,1.0);
+                const MeshShape& theshape = mesh->shapes[shape];
+                for (size_t lod = 0; lod < theshape.lods.size(); ++lod)
+                {
+                    printf("  Shape \"%s\": LOD %d com %d triângulos (erro %g).\n", theshape.name.c_str(),
+                           (int)lod + 1, (int)theshape.lods[lod].num_indices / 3, theshape.lods[lod].error);
+                }
             }
+        }
 
-            const glm::vec4  a = vertices[0];
-            const glm::vec4  b = vertices[1];
-            const glm::vec4  c = vertices[2];
+        if ( g_OptimizeMeshes )
+        {
+            // Reordenamos os triângulos para a cache de vértices
+            // pós-transformação, e então os vértices na ordem de uso.
+            std::vector<float> acmr_before(mesh->shapes.size());
+            for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
+                acmr_before[shape] = MeshOpt_ComputeACMR(*mesh, mesh->shapes[shape]);
 
-            // Cálculo da normal de um triângulo cujos vértices
-            // estão nos pontos "a", "b", e "c", definidos no sentido anti-horário.
-            const glm::vec4  n = crossproduct(b - a, c - a);
+            MeshOpt_OptimizeVertexCache(mesh);
+            MeshOpt_OptimizeVertexFetch(mesh);
 
-            for (size_t vertex = 0; vertex < 3; ++vertex)
+            for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
             {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                num_triangles_per_vertex[idx.vertex_index] += 1;
-                vertex_normals[idx.vertex_index] += n;
-                model->shapes[shape].mesh.indices[3*triangle + vertex].normal_index = idx.vertex_index;
+                printf("  Shape \"%s\": ACMR %.3f -> %.3f.\n", mesh->shapes[shape].name.c_str(),
+                       acmr_before[shape], MeshOpt_ComputeACMR(*mesh, mesh->shapes[shape]));
             }
         }
-    }
 
-    model->attrib.normals.resize( 3*num_vertices );
+        // Convertemos os vértices e índices para o formato compacto enviado à GPU
+        MeshOpt_PackVertices(mesh);
+        MeshOpt_PackIndices(mesh);
+
+        MeshCache_Save(filename, flags, *mesh);
+    }
 
-    for (size_t i = 0; i < vertex_normals.size(); ++i)
+    // Hierarquias dos triângulos de cada shape, para os testes de colisão
+    // (veja "meshbvh.h"). São construídas aqui, fora da thread principal, e
+    // não são gravadas no cache.
+    if ( mesh->packed_vertices == NULL || mesh->packed_indices == NULL )
+        return;
+    for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
     {
-        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
-        n /= norm(n);
-        model->attrib.normals[3*i + 0] = n.x;
-        model->attrib.normals[3*i + 1] = n.y;
-        model->attrib.normals[3*i + 2] = n.z;
+        MeshShape& theshape = mesh->shapes[shape];
+        MeshBvh_Build(&theshape.bvh, mesh->packed_vertices[0].position, sizeof(PackedVertex),
+                      (const char*)mesh->packed_indices + theshape.first_index * mesh->index_size,
+                      mesh->index_size, theshape.num_indices);
     }
 }
 
-// Função que computa as normais de um ObjModel, caso elas não tenham sido
-// especificadas dentro do arquivo ".obj"
-void ComputeNormals(ObjModel* model)
+// Carrega o modelo "filename" e adiciona seus objetos na cena virtual.
+// Veja LoadMesh().
+void LoadModelAndAddToVirtualScene(const char* filename, const char* basepath, bool compute_normals)
 {
-    if ( !model->attrib.normals.empty() )
-        return;
-
-    // Primeiro computamos as normais para todos os TRIÂNGULOS.
-    // Segundo, computamos as normais dos VÉRTICES através do método proposto
-    // por Gourad, onde a normal de cada vértice vai ser a média das normais de
-    // todas as faces que compartilham este vértice.
-
-    size_t num_vertices = model->attrib.vertices.size() / 3;
-
-    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
-    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f,0.0f,0.0f,0.0f));
+    MeshData mesh;
+    LoadMesh(filename, basepath, compute_normals, &mesh);
+    AddMeshToVirtualScene(mesh, filename);
+}
 
-    for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+// Versão assíncrona de LoadModelAndAddToVirtualScene(): o modelo é lido por
+// uma thread de trabalho (veja "assetloader.h") e enviado para a GPU em
+// partes por AssetLoader_Update(). Seus objetos aparecem na cena virtual
+// somente quando o envio termina. Com g_StreamModels o modelo é lido por
+// StreamModelToVirtualSceneAsync().
+void LoadModelAndAddToVirtualSceneAsync(const char* filename, const char* basepath, bool compute_normals)
+{
+    if ( g_StreamModels )
     {
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+        StreamModelToVirtualSceneAsync(filename, compute_normals);
+        return;
+    }
 
-        for (size_t triangle = 0; triangle < num_triangles; ++triangle)
+    struct AsyncModel
+    {
+        std::string filename;
+        std::string basepath;
+        bool        has_basepath;
+        bool        compute_normals;
+        std::string error;
+        MeshData    mesh;
+        size_t      cpu_bytes;
+        MeshUpload  upload;
+        bool        upload_started;
+    };
+
+    std::shared_ptr<AsyncModel> job(new AsyncModel);
+    job->filename        = filename;
+    job->basepath        = basepath ? basepath : "";
+    job->has_basepath    = (basepath != NULL);
+    job->compute_normals = compute_normals;
+    job->cpu_bytes       = 0;
+    job->upload_started  = false;
+
+    AssetLoader_Submit(
+        [job]()
         {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+            try
+            {
+                LoadMesh(job->filename.c_str(), job->has_basepath ? job->basepath.c_str() : NULL,
+                         job->compute_normals, &job->mesh);
+                job->cpu_bytes = MeshCpuBytes(job->mesh);
+                Resource_AddCpuBytes(RESOURCE_MESHES, job->filename.c_str(), (ptrdiff_t)job->cpu_bytes);
+            }
+            catch (const std::exception& e)
+            {
+                job->error = e.what();
+            }
+        },
+        [job]()
+        {
+            if ( !job->error.empty() )
+            {
+                fprintf(stderr, "ERROR: Cannot load model \"%s\": %s\n", job->filename.c_str(), job->error.c_str());
+                AssetLoader_Shutdown();
+                std::exit(EXIT_FAILURE);
+            }
 
-            glm::vec4  vertices[3];
-            for (size_t vertex = 0; vertex < 3; ++vertex)
+            if ( !job->upload_started )
             {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                vertices[vertex] = glm::vec4(vx,vy,vz,1.0);
+                BeginMeshUpload(job->mesh, &job->upload, job->filename.c_str());
+                job->upload_started = true;
+                return false;
             }
 
-            const glm::vec4  a = vertices[0];
-            const glm::vec4  b = vertices[1];
-            const glm::vec4  c = vertices[2];
+            if ( !StepMeshUpload(job->mesh, &job->upload, ASSET_UPLOAD_CHUNK_SIZE) )
+                return false;
 
-            // PREENCHA AQUI o cálculo da normal de um triângulo cujos vértices
-            // estão nos pontos "a", "b", e "c", definidos no sentido anti-horário.
-            const glm::vec4  n = crossproduct(b - a, c - a);
-            // preenchido
+            // A cópia na memória principal não é mais necessária
+            ReleaseMeshData(&job->mesh);
+            Resource_AddCpuBytes(RESOURCE_MESHES, job->filename.c_str(), -(ptrdiff_t)job->cpu_bytes);
+            return true;
+        });
+}
 
-            for (size_t vertex = 0; vertex < 3; ++vertex)
+// Lê o modelo "filename" diretamente para buffers da GPU (veja
+// "objstream.h"), em duas tarefas de AssetLoader_Submit():
+//
+//   1. uma thread de trabalho lê os atributos e conta os vértices; a thread
+//      principal então cria os buffers com o tamanho final e os mapeia;
+//
+//   2. uma thread de trabalho lê as faces novamente, gravando os vértices em
+//      lotes na memória mapeada; a thread principal desmapeia os buffers e
+//      adiciona os objetos na cena virtual.
+//
+// Com g_BufferStorage os buffers têm armazenamento imutável, mapeado de forma
+// persistente e coerente; caso contrário são mapeados por glMapBufferRange()
+// com GL_MAP_INVALIDATE_BUFFER_BIT, o que também é permitido enquanto a
+// thread principal renderiza, pois o VAO só é desenhado ao final.
+void StreamModelToVirtualSceneAsync(const char* filename, bool compute_normals)
+{
+    struct StreamedModel
+    {
+        ObjStream   stream;
+        bool        compute_normals;
+        size_t      cpu_bytes; // Atributos guardados entre as duas leituras
+        std::string error;
+        MeshUpload  upload;
+        void*       mapped[2];
+    };
+
+    std::shared_ptr<StreamedModel> job(new StreamedModel);
+    job->stream.filename = filename;
+    job->compute_normals = compute_normals;
+    job->cpu_bytes = 0;
+    job->mapped[0] = job->mapped[1] = NULL;
+
+    AssetLoader_Submit(
+        [job]()
+        {
+            ObjStream_Open(job->stream.filename.c_str(), job->compute_normals, &job->stream, &job->error);
+            job->cpu_bytes = sizeof(float) * (job->stream.positions.capacity() + job->stream.normals.capacity()
+                                              + job->stream.texcoords.capacity());
+            Resource_AddCpuBytes(RESOURCE_MESHES, job->stream.filename.c_str(), (ptrdiff_t)job->cpu_bytes);
+        },
+        [job]()
+        {
+            if ( job->error.empty() && job->stream.mesh.num_vertices == 0 )
+                job->error = "Model has no triangles.";
+
+            // Sem os buffers mapeados a segunda leitura não teria onde escrever
+            if ( job->error.empty() && !BeginMeshUpload(job->stream.mesh, &job->upload, job->stream.filename.c_str(), job->mapped) )
+                job->error = "Cannot map GPU buffers.";
+
+            if ( !job->error.empty() )
             {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                num_triangles_per_vertex[idx.vertex_index] += 1;
-                vertex_normals[idx.vertex_index] += n;
-                model->shapes[shape].mesh.indices[3*triangle + vertex].normal_index = idx.vertex_index;
+                fprintf(stderr, "ERROR: Cannot load model \"%s\": %s\n", job->stream.filename.c_str(), job->error.c_str());
+                AssetLoader_Shutdown();
+                std::exit(EXIT_FAILURE);
             }
-        }
-    }
 
-    model->attrib.normals.resize( 3*num_vertices );
+            AssetLoader_Submit(
+                [job]()
+                {
+                    ObjStream_Write(&job->stream, (PackedVertex*)job->mapped[0], job->mapped[1], &job->error);
+                    Resource_AddCpuBytes(RESOURCE_MESHES, job->stream.filename.c_str(), -(ptrdiff_t)job->cpu_bytes);
+                },
+                [job]()
+                {
+                    // Desmapeamos os buffers mesmo em caso de erro
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        glBindBuffer(GL_COPY_WRITE_BUFFER, job->upload.buffer_ids[i]);
+                        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                    }
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
-    for (size_t i = 0; i < vertex_normals.size(); ++i)
-    {
-        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
-        n /= norm(n);
-        model->attrib.normals[3*i + 0] = n.x;
-        model->attrib.normals[3*i + 1] = n.y;
-        model->attrib.normals[3*i + 2] = n.z;
-    }
+                    if ( !job->error.empty() )
+                    {
+                        fprintf(stderr, "ERROR: Cannot load model \"%s\": %s\n", job->stream.filename.c_str(), job->error.c_str());
+                        AssetLoader_Shutdown();
+                        std::exit(EXIT_FAILURE);
+                    }
+
+                    printf("Modelo \"%s\" enviado para a GPU: %d vértices em %d shapes.\n", job->stream.filename.c_str(),
+                           (int)job->stream.mesh.num_vertices, (int)job->stream.mesh.shapes.size());
+                    AddMeshShapesToVirtualScene(job->stream.mesh, job->upload.vertex_array_object_id);
+                    return true;
+                });
+
+            return true;
+        });
 }
 
-// Constrói triângulos para futura renderização a partir de um ObjModel.
-void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
+// Converte os shapes de um ObjModel para os vetores de atributos e índices que
+// são enviados para a GPU por AddMeshToVirtualScene().
+void BuildTriangles(ObjModel* model, MeshData* mesh)
 {
-    GLuint vertex_array_object_id;
-    glGenVertexArrays(1, &vertex_array_object_id);
-    glBindVertexArray(vertex_array_object_id);
+    std::vector<uint32_t>& indices              = mesh->index_storage;
+    std::vector<float>&    model_coefficients   = mesh->model_storage;
+    std::vector<float>&    normal_coefficients  = mesh->normal_storage;
+    std::vector<float>&    texture_coefficients = mesh->texture_storage;
 
-    std::vector<GLuint> indices;
-    std::vector<float>  model_coefficients;
-    std::vector<float>  normal_coefficients;
-    std::vector<float>  texture_coefficients;
+    indices.clear();
+    model_coefficients.clear();
+    normal_coefficients.clear();
+    texture_coefficients.clear();
+    mesh->shapes.clear();
 
     for (size_t shape = 0; shape < model->shapes.size(); ++shape)
     {
@@ -1235,71 +3028,262 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
 
         size_t last_index = indices.size() - 1;
 
-        SceneObject theobject;
-        theobject.name           = model->shapes[shape].name;
-        theobject.first_index    = (void*)first_index; // Primeiro índice
-        theobject.num_indices    = last_index - first_index + 1; // Número de indices
-        theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
-        theobject.vertex_array_object_id = vertex_array_object_id;
+        MeshShape theshape;
+        theshape.name        = model->shapes[shape].name;
+        theshape.first_index = first_index; // Primeiro índice
+        theshape.num_indices = last_index - first_index + 1; // Número de indices
+        theshape.bbox_min    = bbox_min;
+        theshape.bbox_max    = bbox_max;
+
+        mesh->shapes.push_back(theshape);
+    }
+
+    mesh->UseStorage();
+
+    // Até aqui cada triângulo tem seus próprios três vértices. Soldamos os
+    // vértices idênticos, para que sejam compartilhados entre triângulos
+    // através do vetor de índices (veja "meshopt.h").
+    size_t num_vertices_before = mesh->num_vertices;
+    MeshOpt_WeldVertices(mesh);
+
+    for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
+    {
+        printf("  Shape \"%s\": %d vértices -> %d vértices soldados.\n",
+               mesh->shapes[shape].name.c_str(), (int)mesh->shapes[shape].num_indices,
+               (int)MeshOpt_CountShapeVertices(*mesh, mesh->shapes[shape]));
+    }
+    printf("  Total: %d vértices -> %d vértices soldados.\n", (int)num_vertices_before, (int)mesh->num_vertices);
+}
+
+// Envia os atributos e índices de uma malha para a GPU, criando um VAO, e
+// adiciona cada um de seus shapes na cena virtual.
+void AddMeshToVirtualScene(const MeshData& mesh, const char* owner)
+{
+    MeshUpload upload;
+    BeginMeshUpload(mesh, &upload, owner);
+    while ( !StepMeshUpload(mesh, &upload, (size_t)-1) )
+        ;
+}
+
+// Memória principal ocupada por uma malha: seus vetores e, se foi lida do
+// cache, o arquivo mapeado.
+size_t MeshCpuBytes(const MeshData& mesh)
+{
+    size_t bvh_bytes = 0;
+    for (size_t shape = 0; shape < mesh.shapes.size(); ++shape)
+        bvh_bytes += MeshBvh_Bytes(mesh.shapes[shape].bvh);
+
+    return bvh_bytes
+         + mesh.model_storage.capacity() * sizeof(float)
+         + mesh.normal_storage.capacity() * sizeof(float)
+         + mesh.texture_storage.capacity() * sizeof(float)
+         + mesh.packed_storage.capacity() * sizeof(PackedVertex)
+         + mesh.index_storage.capacity() * sizeof(uint32_t)
+         + mesh.packed_index_storage.capacity() * sizeof(uint16_t)
+         + (mesh.mapping.data != NULL ? mesh.mapping.size : 0);
+}
+
+// Libera os vetores e o mapeamento de uma malha cujos dados já estão na GPU.
+// Somente os shapes (nomes, bounding boxes e LODs) continuam válidos; as
+// hierarquias dos triângulos já foram copiadas para g_SceneBvhs.
+void ReleaseMeshData(MeshData* mesh)
+{
+    for (size_t shape = 0; shape < mesh->shapes.size(); ++shape)
+        MeshBvh_Clear(&mesh->shapes[shape].bvh);
+
+    std::vector<float>().swap(mesh->model_storage);
+    std::vector<float>().swap(mesh->normal_storage);
+    std::vector<float>().swap(mesh->texture_storage);
+    std::vector<PackedVertex>().swap(mesh->packed_storage);
+    std::vector<uint32_t>().swap(mesh->index_storage);
+    std::vector<uint16_t>().swap(mesh->packed_index_storage);
+    MappedFile_Close(&mesh->mapping);
+
+    mesh->model_coefficients   = NULL;
+    mesh->normal_coefficients  = NULL;
+    mesh->texture_coefficients = NULL;
+    mesh->packed_vertices      = NULL;
+    mesh->indices              = NULL;
+    mesh->packed_indices       = NULL;
+}
+
+// Retorna o ponteiro e o tamanho (em bytes) de um dos fluxos de dados de uma
+// malha: 0 = vértices compactos (veja PackedVertex em "meshdata.h"), 1 = índices.
+static const void* MeshStream(const MeshData& mesh, size_t stream, size_t* size)
+{
+    switch (stream)
+    {
+    case 0: *size = mesh.num_vertices * sizeof(PackedVertex); return mesh.packed_vertices;
+    case 1: *size = mesh.num_indices * mesh.index_size;       return mesh.packed_indices;
+    }
+    *size = 0;
+    return NULL;
+}
+
+// Cria o buffer "buffer_id", ligado em "target", com "size" bytes. Se
+// "mapped" não for NULL o buffer é mapeado para escrita, e o ponteiro é
+// guardado em *mapped. Retorna false se o mapeamento falhar.
+static bool CreateMeshBuffer(GLenum target, GLuint buffer_id, size_t size, void** mapped)
+{
+    Resource_SetGpuBytes(RESOURCE_BUFFER, buffer_id, size);
+
+    if ( mapped == NULL )
+    {
+        glBufferData(target, size, NULL, GL_STATIC_DRAW);
+    }
+    else if ( g_BufferStorage != NULL )
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        g_BufferStorage(target, size, NULL, flags);
+        *mapped = glMapBufferRange(target, 0, size, flags);
+    }
+    else
+    {
+        glBufferData(target, size, NULL, GL_STATIC_DRAW);
+        *mapped = glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    return mapped == NULL || *mapped != NULL;
+}
+
+// Cria o VAO e os buffers de uma malha, sem enviar seus dados. Os dados são
+// enviados em partes por StepMeshUpload() ou, se "mapped" não for NULL,
+// escritos diretamente nos buffers mapeados mapped[0] (vértices) e mapped[1]
+// (índices), que devem ser desmapeados antes de a malha ser desenhada. Se
+// algum dos mapeamentos falhar (falta de memória, recusa do driver), nenhum
+// buffer fica mapeado, mapped[0] e mapped[1] são NULL e a função retorna
+// false.
+bool BeginMeshUpload(const MeshData& mesh, MeshUpload* upload, const char* owner, void** mapped)
+{
+    upload->stream = 0;
+    upload->offset = 0;
+
+    upload->vertex_array_object_id = Resource_Create(RESOURCE_VERTEX_ARRAY, RESOURCE_MESHES, owner);
+    glBindVertexArray(upload->vertex_array_object_id);
 
-        theobject.bbox_min = bbox_min;
-        theobject.bbox_max = bbox_max;
+    // Todos os atributos ficam intercalados em um único buffer, com um
+    // PackedVertex (20 bytes) por vértice.
+    upload->buffer_ids[0] = Resource_Create(RESOURCE_BUFFER, RESOURCE_MESHES, owner);
+    glBindBuffer(GL_ARRAY_BUFFER, upload->buffer_ids[0]);
+    bool ok = CreateMeshBuffer(GL_ARRAY_BUFFER, upload->buffer_ids[0], mesh.num_vertices * sizeof(PackedVertex), mapped ? &mapped[0] : NULL);
 
-        g_VirtualScene[model->shapes[shape].name] = theobject;
+    const GLsizei stride = sizeof(PackedVertex);
+
+    // Posição: 3 floats, "(location = 0)" em "shader_vertex.glsl"
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+
+    // Normal: X, Y, Z em 10 bits com sinal, normalizados para [-1,1], "(location = 1)"
+    if ( mesh.vertex_attributes & MESHDATA_HAS_NORMALS )
+    {
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+        glEnableVertexAttribArray(1);
+    }
+
+    // Coordenadas de textura: 2 half floats, "(location = 2)"
+    if ( mesh.vertex_attributes & MESHDATA_HAS_TEXCOORDS )
+    {
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texcoord));
+        glEnableVertexAttribArray(2);
     }
 
-    GLuint VBO_model_coefficients_id;
-    glGenBuffers(1, &VBO_model_coefficients_id);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_model_coefficients_id);
-    glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, model_coefficients.size() * sizeof(float), model_coefficients.data());
-    GLuint location = 0; // "(location = 0)" em "shader_vertex.glsl"
-    GLint  number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-    glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(location);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    if ( !normal_coefficients.empty() )
-    {
-        GLuint VBO_normal_coefficients_id;
-        glGenBuffers(1, &VBO_normal_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, normal_coefficients.size() * sizeof(float), normal_coefficients.data());
-        location = 1; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-
-    if ( !texture_coefficients.empty() )
-    {
-        GLuint VBO_texture_coefficients_id;
-        glGenBuffers(1, &VBO_texture_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_texture_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, texture_coefficients.size() * sizeof(float), texture_coefficients.data());
-        location = 2; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 2; // vec2 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-
-    GLuint indices_id;
-    glGenBuffers(1, &indices_id);
-
-    // "Ligamos" o buffer. Note que o tipo agora é GL_ELEMENT_ARRAY_BUFFER.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // XXX Errado!
-    //
+    // "Ligamos" o buffer de índices enquanto o VAO está ligado. Note que o
+    // tipo agora é GL_ELEMENT_ARRAY_BUFFER.
+    upload->buffer_ids[1] = Resource_Create(RESOURCE_BUFFER, RESOURCE_MESHES, owner);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, upload->buffer_ids[1]);
+    ok = CreateMeshBuffer(GL_ELEMENT_ARRAY_BUFFER, upload->buffer_ids[1], mesh.num_indices * mesh.index_size, mapped ? &mapped[1] : NULL) && ok;
 
     // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
+    // alterar o mesmo. Isso evita bugs. Note que o buffer de índices continua
+    // associado ao VAO.
     glBindVertexArray(0);
+
+    if ( !ok )
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            if ( mapped[i] != NULL )
+            {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, upload->buffer_ids[i]);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                mapped[i] = NULL;
+            }
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    return ok;
+}
+
+// Envia no máximo "max_bytes" bytes dos dados da malha para os buffers
+// criados por BeginMeshUpload(). Quando todos os dados foram enviados, os
+// shapes da malha são adicionados na cena virtual e a função retorna true.
+bool StepMeshUpload(const MeshData& mesh, MeshUpload* upload, size_t max_bytes)
+{
+    while ( upload->stream < 2 && max_bytes > 0 )
+    {
+        size_t size;
+        const unsigned char* data = (const unsigned char*)MeshStream(mesh, upload->stream, &size);
+
+        if ( data == NULL || upload->offset >= size )
+        {
+            upload->stream += 1;
+            upload->offset = 0;
+            continue;
+        }
+
+        // Utilizamos GL_COPY_WRITE_BUFFER para não alterar o estado do VAO.
+        size_t n = std::min(size - upload->offset, max_bytes);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, upload->buffer_ids[upload->stream]);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, upload->offset, n, data + upload->offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        upload->offset += n;
+        max_bytes -= n;
+    }
+
+    if ( upload->stream < 2 )
+        return false;
+
+    AddMeshShapesToVirtualScene(mesh, upload->vertex_array_object_id);
+    return true;
+}
+
+// Adiciona cada shape de uma malha, cujos dados estão no VAO
+// "vertex_array_object_id", na cena virtual.
+void AddMeshShapesToVirtualScene(const MeshData& mesh, GLuint vertex_array_object_id)
+{
+    for (size_t shape = 0; shape < mesh.shapes.size(); ++shape)
+    {
+        SceneObject theobject;
+        theobject.first_index    = (void*)(mesh.shapes[shape].first_index * mesh.index_size); // Primeiro índice (em bytes)
+        theobject.num_indices    = mesh.shapes[shape].num_indices; // Número de indices
+        theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
+        theobject.index_type     = (mesh.index_size == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        theobject.vertex_array_object_id = vertex_array_object_id;
+
+        theobject.bbox_min = mesh.shapes[shape].bbox_min;
+        theobject.bbox_max = mesh.shapes[shape].bbox_max;
+
+        std::vector<SceneObjectLod> lods;
+        for (size_t lod = 0; lod < mesh.shapes[shape].lods.size(); ++lod)
+        {
+            SceneObjectLod level;
+            level.first_index = (void*)(mesh.shapes[shape].lods[lod].first_index * mesh.index_size);
+            level.num_indices = mesh.shapes[shape].lods[lod].num_indices;
+            level.error       = mesh.shapes[shape].lods[lod].error;
+            lods.push_back(level);
+        }
+
+        const SceneHandle handle = Scene_Handle(mesh.shapes[shape].name.c_str());
+        Scene_Set(handle, theobject, lods);
+
+        if ( (size_t)handle >= g_SceneBvhs.size() )
+            g_SceneBvhs.resize(handle + 1);
+        g_SceneBvhs[handle] = mesh.shapes[shape].bvh;
+    }
 }
 
 // Carrega um Vertex Shader de um arquivo GLSL. Veja definição de LoadShader() abaixo.
@@ -1657,6 +3641,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
         g_ShowInfoText = !g_ShowInfoText;
     }
 
+    // Se o usuário apertar a tecla T, alternamos entre os projéteis e a arma instantânea.
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        g_HitscanWeapon = !g_HitscanWeapon;
+        fprintf(stdout,"Arma: %s\n", g_HitscanWeapon ? "instantanea" : "projeteis");
+        fflush(stdout);
+    }
+
     // Se o usuário apertar a tecla R, recarregamos os shaders dos arquivos "shader_fragment.glsl" e "shader_vertex.glsl".
     if (key == GLFW_KEY_R && action == GLFW_PRESS)
     {
@@ -1664,7 +3656,9 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
         fprintf(stdout,"Shaders recarregados!\n");
         fflush(stdout);
     }
-    if (key == GLFW_KEY_L && action == GLFW_PRESS&&Look_at)
+    // A nave somente pode ser controlada depois que todos os recursos foram
+    // carregados (veja "assetloader.h").
+    if (key == GLFW_KEY_L && action == GLFW_PRESS&&Look_at&&AssetLoader_Idle())
     {
         Look_at = false;
         if(texto == 0)
@@ -1798,6 +3792,82 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window)
     TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-lineheight, 1.0f);
 }
 
+// Escrevemos na tela o número de triângulos desenhados no quadro, e quantos
+// seriam desenhados sem os níveis de detalhe (veja SelectLod()).
+void TextRendering_ShowTriangleCount(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[64];
+    int numchars = snprintf(buffer, 64, "%d/%d tris", (int)g_TrianglesDrawn, (int)g_TrianglesFullDetail);
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-2*lineheight, 1.0f);
+}
+
+// Escrevemos na tela a memória utilizada na GPU e na memória principal (veja
+// "resources.h").
+void TextRendering_ShowMemoryUsage(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    char buffer[64];
+    int numchars = snprintf(buffer, 64, "GPU %.1f MB, CPU %.1f MB",
+                            Resource_GpuBytes(RESOURCE_NUM_CATEGORIES) / (1024.0 * 1024.0),
+                            Resource_CpuBytes(RESOURCE_NUM_CATEGORIES) / (1024.0 * 1024.0));
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-3*lineheight, 1.0f);
+}
+
+// Escrevemos na tela o número de objetos desenhados pela fila de
+// renderização no quadro, em quantas chamadas de desenho e com quantas trocas
+// de estado.
+void TextRendering_ShowRenderQueueStats(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    const RenderQueueStats& stats = RenderQueue_Stats();
+
+    char buffer[64];
+    int numchars = snprintf(buffer, 64, "%d objetos, %d draws, %d trocas de estado", (int)stats.packets,
+                            (int)stats.draw_calls, (int)(stats.program_changes + stats.vao_changes));
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-4*lineheight, 1.0f);
+}
+
+// Escrevemos na tela quantos dos objetos submetidos no quadro estavam dentro
+// do frustum, e quantos foram descartados.
+void TextRendering_ShowCullingStats(GLFWwindow* window)
+{
+    if ( !g_ShowInfoText )
+        return;
+
+    const CullingStats& stats = Culling_Stats();
+
+    char buffer[64];
+    int numchars;
+    if ( g_UseCulling )
+        numchars = snprintf(buffer, 64, "%d visiveis, %d descartados", (int)stats.visible, (int)stats.culled);
+    else
+        numchars = snprintf(buffer, 64, "Descarte desligado");
+
+    float lineheight = TextRendering_LineHeight(window);
+    float charwidth = TextRendering_CharWidth(window);
+
+    TextRendering_PrintString(window, buffer, 1.0f-(numchars + 1)*charwidth, 1.0f-5*lineheight, 1.0f);
+}
+
 // Função para debugging: imprime no terminal todas informações de um modelo
 // geométrico carregado de um arquivo ".obj".
 // Veja: https://github.com/syoyo/tinyobjloader/blob/22883def8db9ef1f3ffb9b404318e7dd25fdbb51/loader_example.cc#L98
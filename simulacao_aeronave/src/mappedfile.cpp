@@ -0,0 +1,173 @@
+// Mapeamento de arquivos em memória, utilizado pelos caches binários de
+// modelos e texturas. Veja "include/mappedfile.h".
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "mappedfile.h"
+
+MappedFile::MappedFile()
+    : data(NULL), size(0)
+#ifdef _WIN32
+    , file_handle(NULL), mapping_handle(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    MappedFile_Close(this);
+}
+
+bool MappedFile_Open(const char* filename, MappedFile* file)
+{
+    MappedFile_Close(file);
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return false;
+    }
+
+    file->file_handle    = handle;
+    file->mapping_handle = mapping;
+    file->data           = (const unsigned char*)view;
+    file->size           = (size_t)file_size.QuadPart;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // O mapeamento continua válido após o fechamento do descritor.
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return false;
+
+    file->data = (const unsigned char*)view;
+    file->size = (size_t)st.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile_Close(MappedFile* file)
+{
+    if (file->data == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile((LPCVOID)file->data);
+    CloseHandle((HANDLE)file->mapping_handle);
+    CloseHandle((HANDLE)file->file_handle);
+    file->file_handle    = NULL;
+    file->mapping_handle = NULL;
+#else
+    munmap((void*)file->data, file->size);
+#endif
+
+    file->data = NULL;
+    file->size = 0;
+}
+
+void MappedFile_Swap(MappedFile* a, MappedFile* b)
+{
+    std::swap(a->data, b->data);
+    std::swap(a->size, b->size);
+#ifdef _WIN32
+    std::swap(a->file_handle, b->file_handle);
+    std::swap(a->mapping_handle, b->mapping_handle);
+#endif
+}
+
+bool File_GetStamp(const char* filename, uint64_t* size, int64_t* mtime)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0)
+        return false;
+
+    *size  = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+bool File_WriteAtomic(const char* filename, const void* data, size_t size)
+{
+    std::string tmpname = std::string(filename) + ".tmp";
+
+    FILE* f = fopen(tmpname.c_str(), "wb");
+    if (f == NULL)
+        return false;
+
+    bool ok = fwrite(data, 1, size, f) == size;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok)
+    {
+        remove(tmpname.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    ok = MoveFileExA(tmpname.c_str(), filename, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    ok = rename(tmpname.c_str(), filename) == 0;
+#endif
+
+    if (!ok)
+        remove(tmpname.c_str());
+
+    return ok;
+}
+
+uint64_t File_AlignTo16(uint64_t offset)
+{
+    return (offset + 15) & ~(uint64_t)15;
+}
+
+bool File_SectionFits(uint64_t offset, uint64_t size, uint64_t file_size)
+{
+    return offset <= file_size && size <= file_size - offset;
+}
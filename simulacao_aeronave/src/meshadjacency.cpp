@@ -0,0 +1,31 @@
+// Adjacência vértice -> triângulos. Veja "include/meshadjacency.h".
+#include "meshadjacency.h"
+
+void MeshAdjacency_Build(const uint32_t* indices, size_t num_indices, size_t num_vertices, MeshAdjacency* adjacency)
+{
+    std::vector<uint32_t>& offsets = adjacency->offsets;
+    std::vector<uint32_t>& triangles = adjacency->triangles;
+
+    // Contagem dos triângulos de cada vértice, deslocada de uma posição, e
+    // soma de prefixos
+    offsets.assign(num_vertices + 1, 0);
+    for (size_t i = 0; i < num_indices; ++i)
+        offsets[indices[i] + 1] += 1;
+    for (size_t v = 0; v < num_vertices; ++v)
+        offsets[v + 1] += offsets[v];
+
+    // Distribuição: percorrendo os triângulos em ordem, cada lista fica
+    // ordenada. offsets[v] avança até o início da lista seguinte, e é então
+    // restaurado.
+    triangles.resize(num_indices);
+    for (size_t i = 0; i < num_indices; ++i)
+        triangles[offsets[indices[i]]++] = (uint32_t)(i / 3);
+    for (size_t v = num_vertices; v > 0; --v)
+        offsets[v] = offsets[v - 1];
+    offsets[0] = 0;
+}
+
+uint32_t MeshAdjacency_Degree(const MeshAdjacency& adjacency, uint32_t v)
+{
+    return adjacency.offsets[v + 1] - adjacency.offsets[v];
+}
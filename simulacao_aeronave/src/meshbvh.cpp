@@ -0,0 +1,484 @@
+// Hierarquia de volumes sobre os triângulos de uma malha. Veja "include/meshbvh.h".
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "meshbvh.h"
+
+// Custos relativos de visitar um nó e de testar um triângulo, para a SAH
+#define MESHBVH_TRAVERSAL_COST    1.0f
+#define MESHBVH_INTERSECTION_COST 1.0f
+
+// Dados temporários da construção
+struct BuildState
+{
+    std::vector<glm::vec3> tri_min;      // Caixa de cada triângulo
+    std::vector<glm::vec3> tri_max;
+    std::vector<glm::vec3> centroids;
+    std::vector<uint32_t>  order;        // Triângulos na ordem das folhas
+    MeshBvh*               bvh;
+};
+
+static float SurfaceArea(const glm::vec3& min, const glm::vec3& max)
+{
+    const glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Cria o nó dos triângulos order[begin, end) e, se compensar, seus filhos.
+static void Subdivide(BuildState* state, size_t begin, size_t end, int depth)
+{
+    std::vector<MeshBvhNode>& nodes = state->bvh->nodes;
+    const int index = (int)nodes.size();
+    nodes.push_back(MeshBvhNode());
+
+    glm::vec3 bbox_min(FLT_MAX), bbox_max(-FLT_MAX);
+    glm::vec3 centroid_min(FLT_MAX), centroid_max(-FLT_MAX);
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t triangle = state->order[i];
+        bbox_min = glm::min(bbox_min, state->tri_min[triangle]);
+        bbox_max = glm::max(bbox_max, state->tri_max[triangle]);
+        centroid_min = glm::min(centroid_min, state->centroids[triangle]);
+        centroid_max = glm::max(centroid_max, state->centroids[triangle]);
+    }
+    nodes[index].bbox_min = bbox_min;
+    nodes[index].bbox_max = bbox_max;
+    nodes[index].first    = (int32_t)begin;
+    nodes[index].count    = (int32_t)(end - begin);
+
+    const size_t count = end - begin;
+    if (count <= 1 || depth + 1 >= MESHBVH_MAX_DEPTH)
+        return;
+
+    // Melhor divisão entre os limites dos intervalos, nos três eixos
+    const float leaf_cost = MESHBVH_INTERSECTION_COST * count;
+    float best_cost = FLT_MAX;
+    int   best_axis = -1;
+    int   best_split = 0;
+    const float inverse_area = 1.0f / std::max(SurfaceArea(bbox_min, bbox_max), FLT_MIN);
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float extent = centroid_max[axis] - centroid_min[axis];
+        if (extent <= 0.0f)
+            continue;
+        const float bin_scale = MESHBVH_BINS / extent;
+
+        size_t    bin_count[MESHBVH_BINS] = { 0 };
+        glm::vec3 bin_min[MESHBVH_BINS], bin_max[MESHBVH_BINS];
+        for (int b = 0; b < MESHBVH_BINS; ++b)
+        {
+            bin_min[b] = glm::vec3(FLT_MAX);
+            bin_max[b] = glm::vec3(-FLT_MAX);
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            const uint32_t triangle = state->order[i];
+            int b = (int)((state->centroids[triangle][axis] - centroid_min[axis]) * bin_scale);
+            b = std::min(b, MESHBVH_BINS - 1);
+            bin_count[b] += 1;
+            bin_min[b] = glm::min(bin_min[b], state->tri_min[triangle]);
+            bin_max[b] = glm::max(bin_max[b], state->tri_max[triangle]);
+        }
+
+        // Áreas e contagens acumuladas da direita para a esquerda, e então
+        // o custo de cada divisão ao percorrer da esquerda para a direita.
+        float  right_area[MESHBVH_BINS];
+        size_t right_count[MESHBVH_BINS];
+        glm::vec3 box_min(FLT_MAX), box_max(-FLT_MAX);
+        size_t accumulated = 0;
+        for (int b = MESHBVH_BINS - 1; b > 0; --b)
+        {
+            box_min = glm::min(box_min, bin_min[b]);
+            box_max = glm::max(box_max, bin_max[b]);
+            accumulated += bin_count[b];
+            right_count[b] = accumulated;
+            right_area[b]  = accumulated ? SurfaceArea(box_min, box_max) : 0.0f;
+        }
+
+        box_min = glm::vec3(FLT_MAX);
+        box_max = glm::vec3(-FLT_MAX);
+        accumulated = 0;
+        for (int b = 0; b < MESHBVH_BINS - 1; ++b)
+        {
+            box_min = glm::min(box_min, bin_min[b]);
+            box_max = glm::max(box_max, bin_max[b]);
+            accumulated += bin_count[b];
+            if (accumulated == 0 || right_count[b + 1] == 0)
+                continue;
+
+            const float cost = MESHBVH_TRAVERSAL_COST + MESHBVH_INTERSECTION_COST * inverse_area *
+                               (SurfaceArea(box_min, box_max) * accumulated + right_area[b + 1] * right_count[b + 1]);
+            if (cost < best_cost)
+            {
+                best_cost  = cost;
+                best_axis  = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    // Folhas pequenas só são divididas se isso reduzir o custo; as grandes,
+    // sempre que os centróides permitirem.
+    if (best_axis < 0 || (best_cost >= leaf_cost && count <= MESHBVH_MAX_LEAF_SIZE))
+        return;
+
+    const float split_scale = MESHBVH_BINS / (centroid_max[best_axis] - centroid_min[best_axis]);
+    const float split_min = centroid_min[best_axis];
+    uint32_t* middle = std::partition(&state->order[begin], &state->order[0] + end,
+        [&](uint32_t triangle)
+        {
+            int b = (int)((state->centroids[triangle][best_axis] - split_min) * split_scale);
+            return std::min(b, MESHBVH_BINS - 1) <= best_split;
+        });
+    const size_t split = middle - &state->order[0];
+
+    nodes[index].count = 0;
+    Subdivide(state, begin, split, depth + 1);
+    nodes[index].first = (int32_t)nodes.size();
+    Subdivide(state, split, end, depth + 1);
+}
+
+static inline uint32_t ReadIndex(const void* indices, size_t index_size, size_t i)
+{
+    if (index_size == 2)
+        return ((const uint16_t*)indices)[i];
+    return ((const uint32_t*)indices)[i];
+}
+
+void MeshBvh_Build(MeshBvh* bvh, const float* positions, size_t stride, const void* indices, size_t index_size, size_t num_indices)
+{
+    MeshBvh_Clear(bvh);
+
+    const size_t num_triangles = num_indices / 3;
+    if (num_triangles == 0 || positions == NULL || indices == NULL)
+        return;
+
+    BuildState state;
+    state.bvh = bvh;
+    state.tri_min.resize(num_triangles);
+    state.tri_max.resize(num_triangles);
+    state.centroids.resize(num_triangles);
+    state.order.resize(num_triangles);
+
+    std::vector<glm::vec3> corners(3 * num_triangles);
+    for (size_t triangle = 0; triangle < num_triangles; ++triangle)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t vertex = ReadIndex(indices, index_size, 3*triangle + k);
+            const float* p = (const float*)((const char*)positions + vertex * stride);
+            corners[3*triangle + k] = glm::vec3(p[0], p[1], p[2]);
+        }
+        const glm::vec3* v = &corners[3*triangle];
+        state.tri_min[triangle]   = glm::min(v[0], glm::min(v[1], v[2]));
+        state.tri_max[triangle]   = glm::max(v[0], glm::max(v[1], v[2]));
+        state.centroids[triangle] = (v[0] + v[1] + v[2]) * (1.0f / 3.0f);
+        state.order[triangle]     = (uint32_t)triangle;
+    }
+
+    // Com folhas de um ou dois triângulos há cerca de um nó por triângulo
+    bvh->nodes.reserve(num_triangles);
+    Subdivide(&state, 0, num_triangles, 0);
+    std::vector<MeshBvhNode>(bvh->nodes).swap(bvh->nodes);
+
+    bvh->vertices.resize(3 * num_triangles);
+    for (size_t i = 0; i < num_triangles; ++i)
+        memcpy(&bvh->vertices[3*i], &corners[3*state.order[i]], 3 * sizeof(glm::vec3));
+}
+
+void MeshBvh_Clear(MeshBvh* bvh)
+{
+    std::vector<MeshBvhNode>().swap(bvh->nodes);
+    std::vector<glm::vec3>().swap(bvh->vertices);
+}
+
+size_t MeshBvh_Bytes(const MeshBvh& bvh)
+{
+    return bvh.nodes.capacity() * sizeof(MeshBvhNode) + bvh.vertices.capacity() * sizeof(glm::vec3);
+}
+
+// Parâmetro t em que o raio entra na caixa do nó, ou FLT_MAX se ele não a
+// intercepta com t em [0, max_t] (teste das "fatias", como em "aabbtree.cpp").
+static inline float RayNodeEntry(const MeshBvhNode& node, const glm::vec3& origin, const glm::vec3& inverse, float max_t)
+{
+    float t_enter = 0.0f;
+    float t_exit  = max_t;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float t0 = (node.bbox_min[axis] - origin[axis]) * inverse[axis];
+        float t1 = (node.bbox_max[axis] - origin[axis]) * inverse[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        // Com a componente da direção nula, t0 e t1 são +-infinito se a
+        // origem está entre os planos, e ambos do mesmo sinal se não está.
+        t_enter = (t0 > t_enter) ? t0 : t_enter;
+        t_exit  = (t1 < t_exit) ? t1 : t_exit;
+    }
+    return (t_enter <= t_exit) ? t_enter : FLT_MAX;
+}
+
+// Interseção raio-triângulo de Möller e Trumbore. Retorna o parâmetro t, ou
+// um valor negativo se não há interseção.
+static inline float RayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3* v)
+{
+    const glm::vec3 e1 = v[1] - v[0];
+    const glm::vec3 e2 = v[2] - v[0];
+    const glm::vec3 p  = glm::cross(direction, e2);
+    const float determinant = glm::dot(e1, p);
+    if (fabsf(determinant) < 1e-12f)
+        return -1.0f;
+
+    const float inverse_determinant = 1.0f / determinant;
+    const glm::vec3 s = origin - v[0];
+    const float u = glm::dot(s, p) * inverse_determinant;
+    if (u < 0.0f || u > 1.0f)
+        return -1.0f;
+
+    const glm::vec3 q = glm::cross(s, e1);
+    const float w = glm::dot(direction, q) * inverse_determinant;
+    if (w < 0.0f || u + w > 1.0f)
+        return -1.0f;
+
+    return glm::dot(e2, q) * inverse_determinant;
+}
+
+bool MeshBvh_Raycast(const MeshBvh& bvh, const glm::vec3& origin, const glm::vec3& direction, float max_t, MeshBvhHit* hit)
+{
+    if (bvh.nodes.empty())
+        return false;
+
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; ++axis)
+        inverse[axis] = 1.0f / direction[axis]; // +-infinito se a componente é nula
+
+    float best_t = max_t;
+    int   best_triangle = -1;
+
+    int stack[MESHBVH_MAX_DEPTH];
+    int top = 0;
+    int index = (RayNodeEntry(bvh.nodes[0], origin, inverse, best_t) != FLT_MAX) ? 0 : -1;
+    while (index >= 0)
+    {
+        const MeshBvhNode& node = bvh.nodes[index];
+        if (node.count > 0)
+        {
+            for (int32_t triangle = node.first; triangle < node.first + node.count; ++triangle)
+            {
+                const float t = RayTriangle(origin, direction, &bvh.vertices[3*triangle]);
+                if (t >= 0.0f && t <= best_t)
+                {
+                    best_t = t;
+                    best_triangle = triangle;
+                }
+            }
+            index = -1;
+        }
+        else
+        {
+            // Visitamos primeiro o filho mais próximo; o outro fica na pilha
+            int near_child = index + 1;
+            int far_child  = node.first;
+            float t_near = RayNodeEntry(bvh.nodes[near_child], origin, inverse, best_t);
+            float t_far  = RayNodeEntry(bvh.nodes[far_child], origin, inverse, best_t);
+            if (t_far < t_near)
+            {
+                std::swap(near_child, far_child);
+                std::swap(t_near, t_far);
+            }
+            if (t_far != FLT_MAX)
+                stack[top++] = far_child;
+            index = (t_near != FLT_MAX) ? near_child : -1;
+        }
+
+        // Ao sair da pilha, os nós são testados novamente com o melhor t
+        // atual, e os que ficaram além dele são descartados.
+        while (index < 0 && top > 0)
+        {
+            const int candidate = stack[--top];
+            if (RayNodeEntry(bvh.nodes[candidate], origin, inverse, best_t) != FLT_MAX)
+                index = candidate;
+        }
+    }
+
+    if (best_triangle < 0)
+        return false;
+    if (hit)
+    {
+        hit->t = best_t;
+        hit->triangle = (uint32_t)best_triangle;
+    }
+    return true;
+}
+
+// Ponto do triângulo "v" mais próximo de "p" (Ericson, "Real-Time Collision
+// Detection", seção 5.1.5).
+static glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3* v)
+{
+    const glm::vec3 ab = v[1] - v[0];
+    const glm::vec3 ac = v[2] - v[0];
+    const glm::vec3 ap = p - v[0];
+    const float d1 = glm::dot(ab, ap);
+    const float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return v[0];
+
+    const glm::vec3 bp = p - v[1];
+    const float d3 = glm::dot(ab, bp);
+    const float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return v[1];
+
+    const float vc = d1*d4 - d3*d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return v[0] + ab * (d1 / (d1 - d3));
+
+    const glm::vec3 cp = p - v[2];
+    const float d5 = glm::dot(ab, cp);
+    const float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return v[2];
+
+    const float vb = d5*d2 - d1*d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return v[0] + ac * (d2 / (d2 - d6));
+
+    const float va = d3*d6 - d5*d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return v[1] + (v[2] - v[1]) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const float denominator = 1.0f / (va + vb + vc);
+    return v[0] + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Distância ao quadrado entre os segmentos p1-q1 e p2-q2 (Ericson, seção
+// 5.1.9).
+static float SegmentSegmentDistance2(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2)
+{
+    const glm::vec3 d1 = q1 - p1;
+    const glm::vec3 d2 = q2 - p2;
+    const glm::vec3 r  = p1 - p2;
+    const float a = glm::dot(d1, d1);
+    const float e = glm::dot(d2, d2);
+    const float f = glm::dot(d2, r);
+
+    float s = 0.0f;
+    float t = 0.0f;
+    if (a <= 1e-12f && e <= 1e-12f)
+    {
+        // Os dois segmentos são pontos
+    }
+    else if (a <= 1e-12f)
+    {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    }
+    else
+    {
+        const float c = glm::dot(d1, r);
+        if (e <= 1e-12f)
+        {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else
+        {
+            const float b = glm::dot(d1, d2);
+            const float denominator = a*e - b*b; // Nulo com segmentos paralelos
+            if (denominator != 0.0f)
+                s = glm::clamp((b*f - c*e) / denominator, 0.0f, 1.0f);
+            t = (b*s + f) / e;
+            if (t < 0.0f)
+            {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if (t > 1.0f)
+            {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    const glm::vec3 offset = (p1 + d1 * s) - (p2 + d2 * t);
+    return glm::dot(offset, offset);
+}
+
+// Distância ao quadrado entre o segmento de "from" a "to" e o triângulo "v":
+// zero se o segmento atravessa o triângulo; senão a menor entre as dos
+// extremos do segmento ao triângulo e as do segmento às três arestas.
+static float SegmentTriangleDistance2(const glm::vec3& from, const glm::vec3& to, const glm::vec3* v)
+{
+    const float t = RayTriangle(from, to - from, v);
+    if (t >= 0.0f && t <= 1.0f)
+        return 0.0f;
+
+    const glm::vec3 a = ClosestPointOnTriangle(from, v) - from;
+    const glm::vec3 b = ClosestPointOnTriangle(to, v) - to;
+    float distance2 = std::min(glm::dot(a, a), glm::dot(b, b));
+    for (int k = 0; k < 3; ++k)
+        distance2 = std::min(distance2, SegmentSegmentDistance2(from, to, v[k], v[(k + 1) % 3]));
+    return distance2;
+}
+
+// Retorna true se o segmento de "from" a "to" (inverse = 1/(to - from)) passa
+// a uma distância de no máximo "radius" da caixa do nó. O teste das "fatias"
+// é feito com a caixa aumentada de "radius" em cada direção, o que é um pouco
+// conservador nos cantos.
+static inline bool CapsuleNodeOverlap(const MeshBvhNode& node, const glm::vec3& from, const glm::vec3& inverse, float radius)
+{
+    float t_enter = 0.0f;
+    float t_exit  = 1.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float t0 = (node.bbox_min[axis] - radius - from[axis]) * inverse[axis];
+        float t1 = (node.bbox_max[axis] + radius - from[axis]) * inverse[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        // Com a componente nula, 0 * infinito dá NaN se "from" está sobre
+        // um dos planos; as comparações com NaN são falsas e o eixo não
+        // restringe o intervalo.
+        t_enter = (t0 > t_enter) ? t0 : t_enter;
+        t_exit  = (t1 < t_exit) ? t1 : t_exit;
+    }
+    return t_enter <= t_exit;
+}
+
+bool MeshBvh_IntersectCapsule(const MeshBvh& bvh, const glm::vec3& from, const glm::vec3& to, float radius)
+{
+    if (bvh.nodes.empty())
+        return false;
+
+    const float radius2 = radius * radius;
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; ++axis)
+        inverse[axis] = 1.0f / (to[axis] - from[axis]); // +-infinito se a componente é nula
+
+    int stack[MESHBVH_MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const MeshBvhNode& node = bvh.nodes[stack[--top]];
+        if (!CapsuleNodeOverlap(node, from, inverse, radius))
+            continue;
+
+        if (node.count == 0)
+        {
+            stack[top++] = node.first;
+            stack[top++] = (int)(&node - &bvh.nodes[0]) + 1;
+            continue;
+        }
+
+        for (int32_t triangle = node.first; triangle < node.first + node.count; ++triangle)
+        {
+            if (SegmentTriangleDistance2(from, to, &bvh.vertices[3*triangle]) <= radius2)
+                return true;
+        }
+    }
+    return false;
+}
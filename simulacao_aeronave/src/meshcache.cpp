@@ -0,0 +1,244 @@
+// Cache binário de malhas. Veja "include/meshcache.h".
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "meshcache.h"
+
+static const char MESHCACHE_MAGIC[8] = { 'F','C','G','M','E','S','H','\0' };
+
+struct MeshCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t source_size;
+    int64_t  source_mtime;
+    uint32_t num_vertices;
+    uint32_t num_indices;
+    uint32_t num_shapes;
+    uint32_t vertex_attributes; // MESHDATA_HAS_NORMALS | MESHDATA_HAS_TEXCOORDS
+    uint32_t index_size;        // 2 ou 4 bytes
+    uint32_t num_lods;
+    uint64_t shapes_offset;
+    uint64_t lods_offset;
+    uint64_t names_offset;
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+    uint64_t file_size;
+};
+
+struct MeshCacheShape
+{
+    uint32_t first_index;
+    uint32_t num_indices;
+    uint32_t name_offset; // Relativo ao início da seção de nomes
+    uint32_t name_length;
+    float    bbox_min[3];
+    float    bbox_max[3];
+    uint32_t first_lod;   // Posição do primeiro nível de detalhe na seção de LODs
+    uint32_t num_lods;
+};
+
+struct MeshCacheLod
+{
+    uint32_t first_index;
+    uint32_t num_indices;
+    float    error;
+    uint32_t reserved;
+};
+
+std::string MeshCache_PathFor(const char* source_filename)
+{
+    return std::string(source_filename) + ".meshcache";
+}
+
+bool MeshCache_Load(const char* source_filename, uint32_t flags, MeshData* mesh)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if (!File_GetStamp(source_filename, &source_size, &source_mtime))
+        return false;
+
+    std::string path = MeshCache_PathFor(source_filename);
+
+    MappedFile file;
+    if (!MappedFile_Open(path.c_str(), &file))
+        return false;
+
+    if (file.size < sizeof(MeshCacheHeader))
+        return false;
+
+    MeshCacheHeader header;
+    memcpy(&header, file.data, sizeof(header));
+
+    if (memcmp(header.magic, MESHCACHE_MAGIC, sizeof(MESHCACHE_MAGIC)) != 0
+        || header.version != MESHCACHE_VERSION
+        || header.flags != flags
+        || header.source_size != source_size
+        || header.source_mtime != source_mtime
+        || header.file_size != file.size)
+    {
+        return false;
+    }
+
+    const uint64_t nv = header.num_vertices;
+
+    if ((header.index_size != 2 && header.index_size != 4)
+        || (header.index_size == 2 && nv > 65536)
+        || !File_SectionFits(header.shapes_offset, header.num_shapes*sizeof(MeshCacheShape), file.size)
+        || !File_SectionFits(header.lods_offset, header.num_lods*sizeof(MeshCacheLod), file.size)
+        || !File_SectionFits(header.vertex_offset, nv*sizeof(PackedVertex), file.size)
+        || !File_SectionFits(header.index_offset, header.num_indices*header.index_size, file.size))
+    {
+        return false;
+    }
+
+    std::vector<MeshShape> shapes(header.num_shapes);
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        MeshCacheShape record;
+        memcpy(&record, file.data + header.shapes_offset + i*sizeof(record), sizeof(record));
+
+        if (!File_SectionFits(header.names_offset + record.name_offset, record.name_length, file.size)
+            || (uint64_t)record.first_index + record.num_indices > header.num_indices
+            || (uint64_t)record.first_lod + record.num_lods > header.num_lods)
+        {
+            return false;
+        }
+
+        shapes[i].lods.resize(record.num_lods);
+        for (size_t l = 0; l < record.num_lods; ++l)
+        {
+            MeshCacheLod lod;
+            memcpy(&lod, file.data + header.lods_offset + (record.first_lod + l)*sizeof(lod), sizeof(lod));
+
+            if ((uint64_t)lod.first_index + lod.num_indices > header.num_indices)
+                return false;
+
+            shapes[i].lods[l].first_index = lod.first_index;
+            shapes[i].lods[l].num_indices = lod.num_indices;
+            shapes[i].lods[l].error       = lod.error;
+        }
+
+        const char* name = (const char*)file.data + header.names_offset + record.name_offset;
+        shapes[i].name        = std::string(name, record.name_length);
+        shapes[i].first_index = record.first_index;
+        shapes[i].num_indices = record.num_indices;
+        shapes[i].bbox_min    = glm::vec3(record.bbox_min[0], record.bbox_min[1], record.bbox_min[2]);
+        shapes[i].bbox_max    = glm::vec3(record.bbox_max[0], record.bbox_max[1], record.bbox_max[2]);
+    }
+
+    // A partir daqui o cache é válido: os ponteiros da malha passam a apontar
+    // para o arquivo mapeado, que fica sob posse de "mesh".
+    mesh->shapes.swap(shapes);
+    mesh->model_storage.clear();
+    mesh->normal_storage.clear();
+    mesh->texture_storage.clear();
+    mesh->packed_storage.clear();
+    mesh->index_storage.clear();
+    mesh->packed_index_storage.clear();
+
+    const unsigned char* base = file.data;
+    mesh->num_vertices         = header.num_vertices;
+    mesh->num_indices          = header.num_indices;
+    mesh->model_coefficients   = NULL;
+    mesh->normal_coefficients  = NULL;
+    mesh->texture_coefficients = NULL;
+    mesh->packed_vertices      = (const PackedVertex*)(base + header.vertex_offset);
+    mesh->vertex_attributes    = header.vertex_attributes;
+    mesh->indices              = NULL;
+    mesh->packed_indices       = base + header.index_offset;
+    mesh->index_size           = header.index_size;
+
+    // Transferimos o mapeamento para a malha sem desfazê-lo
+    MappedFile_Swap(&mesh->mapping, &file);
+
+    return true;
+}
+
+bool MeshCache_Save(const char* source_filename, uint32_t flags, const MeshData& mesh)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if (!File_GetStamp(source_filename, &source_size, &source_mtime))
+        return false;
+
+    std::string names;
+    std::vector<MeshCacheShape> records(mesh.shapes.size());
+    std::vector<MeshCacheLod> lods;
+    for (size_t i = 0; i < mesh.shapes.size(); ++i)
+    {
+        const MeshShape& shape = mesh.shapes[i];
+        records[i].first_index = (uint32_t)shape.first_index;
+        records[i].num_indices = (uint32_t)shape.num_indices;
+        records[i].name_offset = (uint32_t)names.size();
+        records[i].name_length = (uint32_t)shape.name.size();
+        for (int c = 0; c < 3; ++c)
+        {
+            records[i].bbox_min[c] = shape.bbox_min[c];
+            records[i].bbox_max[c] = shape.bbox_max[c];
+        }
+        names += shape.name;
+
+        records[i].first_lod = (uint32_t)lods.size();
+        records[i].num_lods  = (uint32_t)shape.lods.size();
+        for (size_t l = 0; l < shape.lods.size(); ++l)
+        {
+            MeshCacheLod lod;
+            lod.first_index = (uint32_t)shape.lods[l].first_index;
+            lod.num_indices = (uint32_t)shape.lods[l].num_indices;
+            lod.error       = shape.lods[l].error;
+            lod.reserved    = 0;
+            lods.push_back(lod);
+        }
+    }
+
+    const uint64_t nv = mesh.num_vertices;
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESHCACHE_MAGIC, sizeof(MESHCACHE_MAGIC));
+    header.version      = MESHCACHE_VERSION;
+    header.flags        = flags;
+    header.source_size  = source_size;
+    header.source_mtime = source_mtime;
+    header.num_vertices = (uint32_t)mesh.num_vertices;
+    header.num_indices  = (uint32_t)mesh.num_indices;
+    header.num_shapes   = (uint32_t)mesh.shapes.size();
+    header.vertex_attributes = mesh.vertex_attributes;
+    header.index_size   = (uint32_t)mesh.index_size;
+    header.num_lods     = (uint32_t)lods.size();
+
+    uint64_t offset = File_AlignTo16(sizeof(header));
+    header.shapes_offset = offset;  offset = File_AlignTo16(offset + records.size()*sizeof(MeshCacheShape));
+    header.lods_offset   = offset;  offset = File_AlignTo16(offset + lods.size()*sizeof(MeshCacheLod));
+    header.names_offset  = offset;  offset = File_AlignTo16(offset + names.size());
+    header.vertex_offset = offset;  offset = File_AlignTo16(offset + nv*sizeof(PackedVertex));
+    header.index_offset = offset;  offset = offset + mesh.num_indices*mesh.index_size;
+    header.file_size    = offset;
+
+    std::vector<unsigned char> buffer(header.file_size, 0);
+    unsigned char* out = buffer.data();
+
+    memcpy(out, &header, sizeof(header));
+    if (!records.empty())
+        memcpy(out + header.shapes_offset, records.data(), records.size()*sizeof(MeshCacheShape));
+    if (!lods.empty())
+        memcpy(out + header.lods_offset, lods.data(), lods.size()*sizeof(MeshCacheLod));
+    if (!names.empty())
+        memcpy(out + header.names_offset, names.data(), names.size());
+    if (nv > 0)
+        memcpy(out + header.vertex_offset, mesh.packed_vertices, nv*sizeof(PackedVertex));
+    if (mesh.num_indices > 0)
+        memcpy(out + header.index_offset, mesh.packed_indices, mesh.num_indices*mesh.index_size);
+
+    std::string path = MeshCache_PathFor(source_filename);
+    if (!File_WriteAtomic(path.c_str(), buffer.data(), buffer.size()))
+    {
+        fprintf(stderr, "WARNING: Cannot write mesh cache \"%s\".\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,284 @@
+// Cálculo paralelo das normais dos vértices. Veja "include/meshnormals.h".
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+#include "meshnormals.h"
+#include "objloader.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MESHNORMALS_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// Número mínimo de elementos (triângulos ou vértices) por thread; malhas
+// pequenas são processadas na thread atual.
+#define MESHNORMALS_MIN_PER_THREAD 8192
+
+// Executa "function(first, last)" dividindo [0, count) entre threads
+static void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& function)
+{
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::max((size_t)1, std::min(num_threads, count / MESHNORMALS_MIN_PER_THREAD));
+
+    if (num_threads == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; ++t)
+        workers.push_back(std::thread(function, count * t / num_threads, count * (t + 1) / num_threads));
+    for (size_t t = 0; t < workers.size(); ++t)
+        workers[t].join();
+}
+
+// Normais (não normalizadas, com comprimento igual ao dobro da área) dos
+// triângulos [first, last), com 4 floats por triângulo (x, y, z, 0), para que
+// a soma em cada vértice leia uma única linha de cache por triângulo.
+static void FaceNormals(const float* positions, const uint32_t* indices, size_t first, size_t last, float* normals)
+{
+    size_t t = first;
+
+#ifdef MESHNORMALS_SSE
+    for (; t + 4 <= last; t += 4)
+    {
+        const uint32_t* i = &indices[3*t];
+        const float* a0 = &positions[3*i[0]]; const float* b0 = &positions[3*i[1]];  const float* c0 = &positions[3*i[2]];
+        const float* a1 = &positions[3*i[3]]; const float* b1 = &positions[3*i[4]];  const float* c1 = &positions[3*i[5]];
+        const float* a2 = &positions[3*i[6]]; const float* b2 = &positions[3*i[7]];  const float* c2 = &positions[3*i[8]];
+        const float* a3 = &positions[3*i[9]]; const float* b3 = &positions[3*i[10]]; const float* c3 = &positions[3*i[11]];
+
+        const __m128 ax = _mm_setr_ps(a0[0], a1[0], a2[0], a3[0]);
+        const __m128 ay = _mm_setr_ps(a0[1], a1[1], a2[1], a3[1]);
+        const __m128 az = _mm_setr_ps(a0[2], a1[2], a2[2], a3[2]);
+
+        const __m128 ux = _mm_sub_ps(_mm_setr_ps(b0[0], b1[0], b2[0], b3[0]), ax);
+        const __m128 uy = _mm_sub_ps(_mm_setr_ps(b0[1], b1[1], b2[1], b3[1]), ay);
+        const __m128 uz = _mm_sub_ps(_mm_setr_ps(b0[2], b1[2], b2[2], b3[2]), az);
+
+        const __m128 vx = _mm_sub_ps(_mm_setr_ps(c0[0], c1[0], c2[0], c3[0]), ax);
+        const __m128 vy = _mm_sub_ps(_mm_setr_ps(c0[1], c1[1], c2[1], c3[1]), ay);
+        const __m128 vz = _mm_sub_ps(_mm_setr_ps(c0[2], c1[2], c2[2], c3[2]), az);
+
+        // n = u x v, para os quatro triângulos ao mesmo tempo, e então
+        // transposto para uma normal por triângulo
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+        __m128 nw = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+        _mm_storeu_ps(&normals[4*t + 0], nx);
+        _mm_storeu_ps(&normals[4*t + 4], ny);
+        _mm_storeu_ps(&normals[4*t + 8], nz);
+        _mm_storeu_ps(&normals[4*t + 12], nw);
+    }
+#endif
+
+    for (; t < last; ++t)
+    {
+        const float* a = &positions[3*indices[3*t + 0]];
+        const float* b = &positions[3*indices[3*t + 1]];
+        const float* c = &positions[3*indices[3*t + 2]];
+        const float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+        const float vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+        normals[4*t + 0] = uy*vz - uz*vy;
+        normals[4*t + 1] = uz*vx - ux*vz;
+        normals[4*t + 2] = ux*vy - uy*vx;
+        normals[4*t + 3] = 0.0f;
+    }
+}
+
+// Ângulo do triângulo "t" no seu vértice "v"
+static float CornerAngle(const float* positions, const uint32_t* indices, size_t t, uint32_t v)
+{
+    int k = 0;
+    while (k < 2 && indices[3*t + k] != v)
+        k += 1;
+
+    const float* p = &positions[3*v];
+    const float* q = &positions[3*indices[3*t + (k + 1) % 3]];
+    const float* r = &positions[3*indices[3*t + (k + 2) % 3]];
+    const float ux = q[0] - p[0], uy = q[1] - p[1], uz = q[2] - p[2];
+    const float vx = r[0] - p[0], vy = r[1] - p[1], vz = r[2] - p[2];
+
+    const float lengths = sqrtf((ux*ux + uy*uy + uz*uz) * (vx*vx + vy*vy + vz*vz));
+    if (lengths == 0.0f)
+        return 0.0f;
+    return acosf(std::max(-1.0f, std::min(1.0f, (ux*vx + uy*vy + uz*vz) / lengths)));
+}
+
+void MeshNormals_Compute(const float* positions, size_t num_vertices,
+                         const uint32_t* indices, size_t num_indices,
+                         const MeshAdjacency& adjacency, int weighting, float* normals)
+{
+    const size_t num_triangles = num_indices / 3;
+
+    std::vector<float> face_normals(4 * num_triangles);
+    float* fn = face_normals.data();
+
+    ParallelFor(num_triangles,
+        [&](size_t first, size_t last)
+        {
+            FaceNormals(positions, indices, first, last, fn);
+        });
+
+    ParallelFor(num_vertices,
+        [&](size_t first, size_t last)
+        {
+            for (size_t v = first; v < last; ++v)
+            {
+                const uint32_t begin = adjacency.offsets[v];
+                const uint32_t end = adjacency.offsets[v + 1];
+                float x = 0.0f, y = 0.0f, z = 0.0f;
+                if (weighting == MESHNORMALS_WEIGHT_ANGLE)
+                {
+                    for (uint32_t a = begin; a < end; ++a)
+                    {
+                        const float* n = &fn[4*adjacency.triangles[a]];
+                        const float length = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+                        if (length == 0.0f)
+                            continue;
+                        const float w = CornerAngle(positions, indices, adjacency.triangles[a], (uint32_t)v) / length;
+                        x += w * n[0]; y += w * n[1]; z += w * n[2];
+                    }
+                }
+                else
+                {
+#ifdef MESHNORMALS_SSE
+                    __m128 sum = _mm_setzero_ps();
+                    for (uint32_t a = begin; a < end; ++a)
+                        sum = _mm_add_ps(sum, _mm_loadu_ps(&fn[4*adjacency.triangles[a]]));
+                    float result[4];
+                    _mm_storeu_ps(result, sum);
+                    x = result[0]; y = result[1]; z = result[2];
+#else
+                    for (uint32_t a = begin; a < end; ++a)
+                    {
+                        const float* n = &fn[4*adjacency.triangles[a]];
+                        x += n[0]; y += n[1]; z += n[2];
+                    }
+#endif
+                }
+
+                const float length = sqrtf(x*x + y*y + z*z);
+                const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+                normals[3*v + 0] = x * scale;
+                normals[3*v + 1] = y * scale;
+                normals[3*v + 2] = z * scale;
+            }
+        });
+}
+
+// Cálculo anterior das normais, mantido para comparação: uma passada serial
+// pelos triângulos espalha a normal de cada um nos seus três vértices.
+static void ComputeNormalsSerial(const float* positions, size_t num_vertices,
+                                 const uint32_t* indices, size_t num_indices, float* normals)
+{
+    std::vector<int>   num_triangles_per_vertex(num_vertices, 0);
+    std::vector<float> sums(3 * num_vertices, 0.0f);
+
+    for (size_t i = 0; i + 3 <= num_indices; i += 3)
+    {
+        float n[4];
+        FaceNormals(positions, &indices[i], 0, 1, n);
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t v = indices[i + k];
+            num_triangles_per_vertex[v] += 1;
+            sums[3*v + 0] += n[0];
+            sums[3*v + 1] += n[1];
+            sums[3*v + 2] += n[2];
+        }
+    }
+
+    for (size_t v = 0; v < num_vertices; ++v)
+    {
+        float x = sums[3*v + 0] / num_triangles_per_vertex[v];
+        float y = sums[3*v + 1] / num_triangles_per_vertex[v];
+        float z = sums[3*v + 2] / num_triangles_per_vertex[v];
+        const float length = sqrtf(x*x + y*y + z*z);
+        normals[3*v + 0] = x / length;
+        normals[3*v + 1] = y / length;
+        normals[3*v + 2] = z / length;
+    }
+}
+
+void MeshNormals_Benchmark(const std::vector<std::string>& filenames, int repetitions)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    printf("Comparando cálculo de normais (%u threads, melhor de %d execuções)\n",
+           std::max(1u, std::thread::hardware_concurrency()), repetitions);
+    // "ganho" compara somente o cálculo das normais, pois a adjacência é
+    // construída uma vez e reaproveitada; "c/ adj." inclui a construção.
+    printf("%-28s %9s %10s %11s %11s %11s %8s %8s %10s\n",
+           "arquivo", "vértices", "serial(ms)", "adjac.(ms)", "área(ms)", "ângulo(ms)", "ganho", "c/ adj.", "dif.(graus)");
+
+    for (size_t f = 0; f < filenames.size(); ++f)
+    {
+        const char* filename = filenames[f].c_str();
+        std::string basepath = filenames[f].substr(0, filenames[f].find_last_of("/\\") + 1);
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string err;
+        if (!ObjLoader_LoadParallel(&attrib, &shapes, &materials, &err, filename, basepath.c_str()))
+        {
+            printf("%-28s falha na leitura\n", filename);
+            continue;
+        }
+
+        const size_t num_vertices = attrib.vertices.size() / 3;
+        std::vector<uint32_t> indices;
+        for (size_t s = 0; s < shapes.size(); ++s)
+            for (size_t i = 0; i < shapes[s].mesh.indices.size(); ++i)
+                indices.push_back((uint32_t)shapes[s].mesh.indices[i].vertex_index);
+
+        std::vector<float> serial(3 * num_vertices), area(3 * num_vertices), angle(3 * num_vertices);
+        MeshAdjacency adjacency;
+
+        double best_serial = INFINITY, best_adjacency = INFINITY, best_area = INFINITY, best_angle = INFINITY;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            Clock::time_point t0 = Clock::now();
+            ComputeNormalsSerial(attrib.vertices.data(), num_vertices, indices.data(), indices.size(), serial.data());
+            Clock::time_point t1 = Clock::now();
+            MeshAdjacency_Build(indices.data(), indices.size(), num_vertices, &adjacency);
+            Clock::time_point t2 = Clock::now();
+            MeshNormals_Compute(attrib.vertices.data(), num_vertices, indices.data(), indices.size(),
+                                adjacency, MESHNORMALS_WEIGHT_AREA, area.data());
+            Clock::time_point t3 = Clock::now();
+            MeshNormals_Compute(attrib.vertices.data(), num_vertices, indices.data(), indices.size(),
+                                adjacency, MESHNORMALS_WEIGHT_ANGLE, angle.data());
+            Clock::time_point t4 = Clock::now();
+
+            best_serial    = std::min(best_serial, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            best_adjacency = std::min(best_adjacency, std::chrono::duration<double, std::milli>(t2 - t1).count());
+            best_area      = std::min(best_area, std::chrono::duration<double, std::milli>(t3 - t2).count());
+            best_angle     = std::min(best_angle, std::chrono::duration<double, std::milli>(t4 - t3).count());
+        }
+
+        // Maior ângulo entre as normais do cálculo serial e as ponderadas por
+        // área (que devem ser iguais, a menos de arredondamento), ignorando
+        // vértices sem normal definida.
+        // (M_PI não é definido com -std=c++11 no MinGW)
+        const double pi = 3.14159265358979323846;
+        double max_angle = 0.0;
+        for (size_t v = 0; v < num_vertices; ++v)
+        {
+            const double dot = serial[3*v]*area[3*v] + serial[3*v + 1]*area[3*v + 1] + serial[3*v + 2]*area[3*v + 2];
+            if (std::isfinite(dot) && (area[3*v] != 0.0f || area[3*v + 1] != 0.0f || area[3*v + 2] != 0.0f))
+                max_angle = std::max(max_angle, acos(std::min(1.0, dot)) * 180.0 / pi);
+        }
+
+        printf("%-28s %9d %10.2f %11.2f %11.2f %11.2f %7.2fx %7.2fx %10.2g\n", filename, (int)num_vertices,
+               best_serial, best_adjacency, best_area, best_angle,
+               best_serial / best_area, best_serial / (best_adjacency + best_area), max_angle);
+    }
+}
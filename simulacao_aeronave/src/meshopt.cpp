@@ -0,0 +1,820 @@
+// Otimizações de malhas. Veja "include/meshopt.h".
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include <glm/geometric.hpp>
+
+#include "meshopt.h"
+#include "meshadjacency.h"
+
+// Número máximo de floats que identificam um vértice: posição (4), normal (4)
+// e coordenada de textura (2).
+#define MESHOPT_MAX_VERTEX_FLOATS 10
+
+// Copia os atributos do vértice "i" para "key". Somamos 0.0f para que -0.0f
+// e +0.0f tenham a mesma representação binária.
+static size_t GatherVertex(const MeshData& mesh, size_t i, float* key)
+{
+    size_t n = 0;
+    for (int c = 0; c < 4; ++c)
+        key[n++] = mesh.model_coefficients[4*i + c] + 0.0f;
+    if (mesh.normal_coefficients)
+        for (int c = 0; c < 4; ++c)
+            key[n++] = mesh.normal_coefficients[4*i + c] + 0.0f;
+    if (mesh.texture_coefficients)
+        for (int c = 0; c < 2; ++c)
+            key[n++] = mesh.texture_coefficients[2*i + c] + 0.0f;
+    return n;
+}
+
+static uint32_t HashVertex(const float* key, size_t n)
+{
+    // FNV-1a sobre a representação binária dos floats
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint32_t bits;
+        memcpy(&bits, &key[i], sizeof(bits));
+        for (int b = 0; b < 4; ++b)
+        {
+            hash ^= (bits >> (8*b)) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+size_t MeshOpt_WeldVertices(MeshData* mesh)
+{
+    const size_t num_vertices = mesh->num_vertices;
+    const bool has_normals   = mesh->normal_coefficients != NULL;
+    const bool has_texcoords = mesh->texture_coefficients != NULL;
+
+    std::vector<float>    model_coefficients;
+    std::vector<float>    normal_coefficients;
+    std::vector<float>    texture_coefficients;
+    std::vector<uint32_t> remap(num_vertices);
+
+    model_coefficients.reserve(4*num_vertices);
+    if (has_normals)
+        normal_coefficients.reserve(4*num_vertices);
+    if (has_texcoords)
+        texture_coefficients.reserve(2*num_vertices);
+
+    // Tabela hash com endereçamento aberto, guardando o índice do vértice
+    // soldado (ou ~0 para posições vazias). A capacidade é uma potência de
+    // dois de pelo menos o dobro do número de vértices.
+    size_t capacity = 16;
+    while (capacity < 2*num_vertices)
+        capacity *= 2;
+    std::vector<uint32_t> table(capacity, ~0u);
+
+    float key[MESHOPT_MAX_VERTEX_FLOATS];
+    float other[MESHOPT_MAX_VERTEX_FLOATS];
+    uint32_t num_welded = 0;
+
+    for (size_t i = 0; i < num_vertices; ++i)
+    {
+        const size_t n = GatherVertex(*mesh, i, key);
+        size_t slot = HashVertex(key, n) & (capacity - 1);
+
+        for (;;)
+        {
+            uint32_t candidate = table[slot];
+            if (candidate == ~0u)
+            {
+                // Vértice novo
+                table[slot] = num_welded;
+                remap[i] = num_welded;
+                num_welded += 1;
+
+                model_coefficients.insert(model_coefficients.end(), mesh->model_coefficients + 4*i, mesh->model_coefficients + 4*i + 4);
+                if (has_normals)
+                    normal_coefficients.insert(normal_coefficients.end(), mesh->normal_coefficients + 4*i, mesh->normal_coefficients + 4*i + 4);
+                if (has_texcoords)
+                    texture_coefficients.insert(texture_coefficients.end(), mesh->texture_coefficients + 2*i, mesh->texture_coefficients + 2*i + 2);
+                break;
+            }
+
+            // Comparamos com o vértice já soldado, cujos atributos estão nos
+            // novos vetores.
+            size_t m = 0;
+            for (int c = 0; c < 4; ++c)
+                other[m++] = model_coefficients[4*candidate + c] + 0.0f;
+            if (has_normals)
+                for (int c = 0; c < 4; ++c)
+                    other[m++] = normal_coefficients[4*candidate + c] + 0.0f;
+            if (has_texcoords)
+                for (int c = 0; c < 2; ++c)
+                    other[m++] = texture_coefficients[2*candidate + c] + 0.0f;
+
+            if (memcmp(key, other, n*sizeof(float)) == 0)
+            {
+                remap[i] = candidate;
+                break;
+            }
+
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+
+    std::vector<uint32_t> indices(mesh->num_indices);
+    for (size_t i = 0; i < mesh->num_indices; ++i)
+        indices[i] = remap[mesh->indices[i]];
+
+    mesh->model_storage.swap(model_coefficients);
+    mesh->normal_storage.swap(normal_coefficients);
+    mesh->texture_storage.swap(texture_coefficients);
+    mesh->index_storage.swap(indices);
+    mesh->packed_storage.clear();
+    mesh->UseStorage();
+
+    return num_welded;
+}
+
+size_t MeshOpt_CountShapeVertices(const MeshData& mesh, const MeshShape& shape)
+{
+    std::vector<bool> seen(mesh.num_vertices, false);
+    size_t count = 0;
+    for (size_t i = shape.first_index; i < shape.first_index + shape.num_indices; ++i)
+    {
+        if (!seen[mesh.indices[i]])
+        {
+            seen[mesh.indices[i]] = true;
+            count += 1;
+        }
+    }
+    return count;
+}
+
+// Retorna um vértice com triângulos ainda não emitidos, desempilhando os
+// vértices usados recentemente ou, se não houver nenhum, procurando em
+// ordem a partir de "*cursor".
+static int SkipDeadEnd(const std::vector<uint32_t>& live, std::vector<uint32_t>* dead_end, size_t* cursor)
+{
+    while (!dead_end->empty())
+    {
+        uint32_t d = dead_end->back();
+        dead_end->pop_back();
+        if (live[d] > 0)
+            return (int)d;
+    }
+
+    while (*cursor < live.size())
+    {
+        if (live[*cursor] > 0)
+            return (int)*cursor;
+        *cursor += 1;
+    }
+
+    return -1;
+}
+
+// Escolhe o próximo vértice em leque entre os candidatos: aquele que ainda
+// estará na cache depois de emitir seus triângulos e que está nela há mais
+// tempo. Veja a seção 4 do artigo do Tipsify.
+static int GetNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& live,
+                         const std::vector<uint32_t>& timestamps, uint32_t time, size_t cache_size,
+                         std::vector<uint32_t>* dead_end, size_t* cursor)
+{
+    int best = -1;
+    int best_priority = -1;
+
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        uint32_t v = candidates[i];
+        if (live[v] == 0)
+            continue;
+
+        int priority = 0;
+        if (time - timestamps[v] + 2*live[v] <= cache_size)
+            priority = (int)(time - timestamps[v]);
+
+        if (priority > best_priority)
+        {
+            best_priority = priority;
+            best = (int)v;
+        }
+    }
+
+    if (best == -1)
+        best = SkipDeadEnd(live, dead_end, cursor);
+
+    return best;
+}
+
+// Tipsify para os triângulos do intervalo [first, first+count) de índices
+static void TipsifyRange(uint32_t* indices, size_t count, size_t num_vertices, size_t cache_size)
+{
+    const size_t num_triangles = count / 3;
+    if (num_triangles == 0)
+        return;
+
+    // Adjacência vértice -> triângulos (veja "meshadjacency.h"), e número de
+    // triângulos ainda não emitidos de cada vértice
+    MeshAdjacency adjacency;
+    MeshAdjacency_Build(indices, 3*num_triangles, num_vertices, &adjacency);
+
+    std::vector<uint32_t> live(num_vertices);
+    for (size_t v = 0; v < num_vertices; ++v)
+        live[v] = MeshAdjacency_Degree(adjacency, (uint32_t)v);
+
+    std::vector<uint32_t> timestamps(num_vertices, 0);
+    std::vector<bool>     emitted(num_triangles, false);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(3*num_triangles);
+
+    uint32_t time = (uint32_t)cache_size + 1;
+    size_t cursor = 0;
+    int fanning = SkipDeadEnd(live, &dead_end, &cursor);
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+
+        for (uint32_t a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; ++a)
+        {
+            uint32_t t = adjacency.triangles[a];
+            if (emitted[t])
+                continue;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t v = indices[3*t + k];
+                output.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                live[v] -= 1;
+
+                if (time - timestamps[v] > cache_size)
+                {
+                    timestamps[v] = time;
+                    time += 1;
+                }
+            }
+
+            emitted[t] = true;
+        }
+
+        fanning = GetNextVertex(candidates, live, timestamps, time, cache_size, &dead_end, &cursor);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOpt_OptimizeVertexCache(MeshData* mesh, size_t cache_size)
+{
+    if (mesh->indices != mesh->index_storage.data())
+        mesh->index_storage.assign(mesh->indices, mesh->indices + mesh->num_indices);
+
+    for (size_t s = 0; s < mesh->shapes.size(); ++s)
+    {
+        const MeshShape& shape = mesh->shapes[s];
+        TipsifyRange(mesh->index_storage.data() + shape.first_index, shape.num_indices,
+                     mesh->num_vertices, cache_size);
+        for (size_t l = 0; l < shape.lods.size(); ++l)
+            TipsifyRange(mesh->index_storage.data() + shape.lods[l].first_index, shape.lods[l].num_indices,
+                         mesh->num_vertices, cache_size);
+    }
+
+    mesh->indices = mesh->index_storage.empty() ? NULL : mesh->index_storage.data();
+}
+
+void MeshOpt_OptimizeVertexFetch(MeshData* mesh)
+{
+    const size_t num_vertices = mesh->num_vertices;
+    const uint32_t unused = ~0u;
+
+    std::vector<uint32_t> remap(num_vertices, unused);
+    std::vector<uint32_t> indices(mesh->num_indices);
+    uint32_t next = 0;
+
+    for (size_t i = 0; i < mesh->num_indices; ++i)
+    {
+        uint32_t v = mesh->indices[i];
+        if (remap[v] == unused)
+            remap[v] = next++;
+        indices[i] = remap[v];
+    }
+    for (size_t v = 0; v < num_vertices; ++v)
+        if (remap[v] == unused)
+            remap[v] = next++;
+
+    std::vector<float> model_coefficients(4*num_vertices);
+    std::vector<float> normal_coefficients(mesh->normal_coefficients ? 4*num_vertices : 0);
+    std::vector<float> texture_coefficients(mesh->texture_coefficients ? 2*num_vertices : 0);
+
+    for (size_t v = 0; v < num_vertices; ++v)
+    {
+        const uint32_t r = remap[v];
+        memcpy(&model_coefficients[4*r], mesh->model_coefficients + 4*v, 4*sizeof(float));
+        if (mesh->normal_coefficients)
+            memcpy(&normal_coefficients[4*r], mesh->normal_coefficients + 4*v, 4*sizeof(float));
+        if (mesh->texture_coefficients)
+            memcpy(&texture_coefficients[2*r], mesh->texture_coefficients + 2*v, 2*sizeof(float));
+    }
+
+    mesh->model_storage.swap(model_coefficients);
+    mesh->normal_storage.swap(normal_coefficients);
+    mesh->texture_storage.swap(texture_coefficients);
+    mesh->index_storage.swap(indices);
+    mesh->packed_storage.clear();
+    mesh->UseStorage();
+}
+
+float MeshOpt_ComputeACMR(const MeshData& mesh, const MeshShape& shape, size_t cache_size)
+{
+    const size_t num_triangles = shape.num_indices / 3;
+    if (num_triangles == 0)
+        return 0.0f;
+
+    // Cache FIFO: um vértice está na cache se foi inserido há menos de
+    // "cache_size" inserções.
+    std::vector<size_t> inserted_at(mesh.num_vertices, (size_t)-1);
+    size_t insertions = 0;
+    size_t misses = 0;
+
+    for (size_t i = shape.first_index; i < shape.first_index + 3*num_triangles; ++i)
+    {
+        uint32_t v = mesh.indices[i];
+        if (inserted_at[v] == (size_t)-1 || insertions - inserted_at[v] > cache_size)
+        {
+            inserted_at[v] = insertions;
+            insertions += 1;
+            misses += 1;
+        }
+    }
+
+    return (float)misses / (float)num_triangles;
+}
+
+// Quádrica de erro: soma dos quadrados das distâncias de um ponto a um
+// conjunto de planos, representada pelos coeficientes da matriz simétrica
+// A (3x3), do vetor b e do escalar c, com erro(p) = p'Ap + 2b'p + c.
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+};
+
+static void Quadric_AddPlane(Quadric* q, double a, double b, double c, double d)
+{
+    q->a00 += a*a; q->a01 += a*b; q->a02 += a*c;
+    q->a11 += b*b; q->a12 += b*c; q->a22 += c*c;
+    q->b0  += a*d; q->b1  += b*d; q->b2  += c*d;
+    q->c   += d*d;
+}
+
+static void Quadric_Add(Quadric* q, const Quadric& other)
+{
+    q->a00 += other.a00; q->a01 += other.a01; q->a02 += other.a02;
+    q->a11 += other.a11; q->a12 += other.a12; q->a22 += other.a22;
+    q->b0  += other.b0;  q->b1  += other.b1;  q->b2  += other.b2;
+    q->c   += other.c;
+}
+
+static double Quadric_Error(const Quadric& q, const float* p)
+{
+    const double x = p[0], y = p[1], z = p[2];
+    double error = q.a00*x*x + q.a11*y*y + q.a22*z*z
+                 + 2.0*(q.a01*x*y + q.a02*x*z + q.a12*y*z)
+                 + 2.0*(q.b0*x + q.b1*y + q.b2*z)
+                 + q.c;
+    return error > 0.0 ? error : 0.0; // Erros de arredondamento
+}
+
+// Normal (não normalizada) do triângulo (p0, p1, p2)
+static void TriangleNormal(const float* p0, const float* p1, const float* p2, float* n)
+{
+    const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+    n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+    n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+}
+
+// Colapso de uma aresta: o vértice "from" passa a ser o vértice "to"
+struct EdgeCollapse
+{
+    uint32_t from;
+    uint32_t to;
+    double   error;
+
+    bool operator<(const EdgeCollapse& other) const { return error < other.error; }
+};
+
+float MeshOpt_SimplifyQuadric(const MeshData& mesh, const uint32_t* indices, size_t num_indices,
+                              size_t target_index_count, float max_error, std::vector<uint32_t>* destination)
+{
+    const size_t num_vertices = mesh.num_vertices;
+    const float* positions = mesh.model_coefficients;
+
+    std::vector<uint32_t> triangles(indices, indices + num_indices - num_indices % 3);
+
+    // Cada posição distinta é representada por um único vértice ("canonical"),
+    // que acumula as quádricas de todos os vértices com essa posição. Vértices
+    // que compartilham a posição com outros estão em costuras e ficam fixos.
+    std::vector<uint32_t>      canonical(num_vertices);
+    std::vector<unsigned char> locked(num_vertices, 0);
+    {
+        size_t capacity = 16;
+        while (capacity < 2*num_vertices)
+            capacity *= 2;
+        std::vector<uint32_t> table(capacity, ~0u);
+
+        for (size_t v = 0; v < num_vertices; ++v)
+        {
+            float key[3];
+            for (int c = 0; c < 3; ++c)
+                key[c] = positions[4*v + c] + 0.0f;
+            size_t slot = HashVertex(key, 3) & (capacity - 1);
+
+            for (;;)
+            {
+                uint32_t candidate = table[slot];
+                if (candidate == ~0u)
+                {
+                    table[slot] = (uint32_t)v;
+                    canonical[v] = (uint32_t)v;
+                    break;
+                }
+
+                float other[3];
+                for (int c = 0; c < 3; ++c)
+                    other[c] = positions[4*candidate + c] + 0.0f;
+                if (memcmp(key, other, sizeof(key)) == 0)
+                {
+                    canonical[v] = candidate;
+                    locked[v] = 1;
+                    locked[candidate] = 1;
+                    break;
+                }
+
+                slot = (slot + 1) & (capacity - 1);
+            }
+        }
+    }
+
+    // Arestas que não são compartilhadas por exatamente dois triângulos são
+    // bordas (ou não-manifold), e seus vértices também ficam fixos.
+    std::vector<uint64_t> edges;
+    edges.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t a = triangles[i + k];
+            uint32_t b = triangles[i + (k + 1) % 3];
+            if (a > b)
+                std::swap(a, b);
+            edges.push_back(((uint64_t)a << 32) | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); )
+    {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j] == edges[i])
+            j += 1;
+        if (j - i != 2)
+        {
+            locked[(uint32_t)(edges[i] >> 32)] = 1;
+            locked[(uint32_t)edges[i]] = 1;
+        }
+        i = j;
+    }
+
+    // Quádricas iniciais: planos dos triângulos incidentes em cada posição
+    std::vector<Quadric> quadrics(num_vertices);
+    memset(quadrics.data(), 0, quadrics.size()*sizeof(Quadric));
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        const float* p0 = &positions[4*triangles[i + 0]];
+        const float* p1 = &positions[4*triangles[i + 1]];
+        const float* p2 = &positions[4*triangles[i + 2]];
+
+        float n[3];
+        TriangleNormal(p0, p1, p2, n);
+        const double length = sqrt((double)n[0]*n[0] + (double)n[1]*n[1] + (double)n[2]*n[2]);
+        if (length == 0.0)
+            continue;
+
+        const double a = n[0]/length, b = n[1]/length, c = n[2]/length;
+        const double d = -(a*p0[0] + b*p0[1] + c*p0[2]);
+        for (int k = 0; k < 3; ++k)
+            Quadric_AddPlane(&quadrics[canonical[triangles[i + k]]], a, b, c, d);
+    }
+
+    const double max_error_squared = (double)max_error * max_error;
+    double result_error = 0.0;
+
+    std::vector<EdgeCollapse>  collapses;
+    MeshAdjacency              adjacency;
+    std::vector<uint32_t>      remap(num_vertices);
+    std::vector<unsigned char> touched(num_vertices);
+
+    for (size_t v = 0; v < num_vertices; ++v)
+        remap[v] = (uint32_t)v;
+
+    // Cada passada colapsa, em ordem de erro, um conjunto de arestas que não
+    // se tocam, e então reescreve os triângulos.
+    while (triangles.size() > target_index_count)
+    {
+        const size_t num_triangles = triangles.size() / 3;
+
+        edges.clear();
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = triangles[i + k];
+                uint32_t b = triangles[i + (k + 1) % 3];
+                if (a > b)
+                    std::swap(a, b);
+                edges.push_back(((uint64_t)a << 32) | b);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (size_t e = 0; e < edges.size(); ++e)
+        {
+            const uint32_t a = (uint32_t)(edges[e] >> 32);
+            const uint32_t b = (uint32_t)edges[e];
+
+            Quadric q = quadrics[canonical[a]];
+            Quadric_Add(&q, quadrics[canonical[b]]);
+
+            EdgeCollapse collapse;
+            collapse.error = -1.0;
+            if (!locked[a])
+            {
+                collapse.from = a; collapse.to = b;
+                collapse.error = Quadric_Error(q, &positions[4*b]);
+            }
+            if (!locked[b])
+            {
+                double error = Quadric_Error(q, &positions[4*a]);
+                if (collapse.error < 0.0 || error < collapse.error)
+                {
+                    collapse.from = b; collapse.to = a;
+                    collapse.error = error;
+                }
+            }
+            if (collapse.error >= 0.0)
+                collapses.push_back(collapse);
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        // Adjacência vértice -> triângulos (veja "meshadjacency.h")
+        MeshAdjacency_Build(triangles.data(), triangles.size(), num_vertices, &adjacency);
+
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t triangles_left = num_triangles;
+        size_t num_collapsed = 0;
+
+        for (size_t i = 0; i < collapses.size(); ++i)
+        {
+            if (3*triangles_left <= target_index_count || collapses[i].error > max_error_squared)
+                break;
+
+            const uint32_t from = collapses[i].from;
+            const uint32_t to   = collapses[i].to;
+            if (touched[from] || touched[to])
+                continue;
+
+            // O colapso é rejeitado se algum triângulo ao redor de "from"
+            // inverter de orientação, ou se a vizinhança já foi alterada
+            // nesta passada.
+            bool valid = true;
+            size_t removed = 0;
+            for (uint32_t a = adjacency.offsets[from]; a < adjacency.offsets[from + 1] && valid; ++a)
+            {
+                const uint32_t* t = &triangles[3*adjacency.triangles[a]];
+                if (t[0] == to || t[1] == to || t[2] == to)
+                {
+                    removed += 1;
+                    continue;
+                }
+
+                const float* before[3];
+                const float* after[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (t[k] != from && touched[t[k]])
+                        valid = false;
+                    before[k] = &positions[4*t[k]];
+                    after[k]  = &positions[4*(t[k] == from ? to : t[k])];
+                }
+
+                float n_before[3], n_after[3];
+                TriangleNormal(before[0], before[1], before[2], n_before);
+                TriangleNormal(after[0], after[1], after[2], n_after);
+                if (n_before[0]*n_after[0] + n_before[1]*n_after[1] + n_before[2]*n_after[2] <= 0.0f)
+                    valid = false;
+            }
+            if (!valid)
+                continue;
+
+            for (uint32_t a = adjacency.offsets[from]; a < adjacency.offsets[from + 1]; ++a)
+                for (int k = 0; k < 3; ++k)
+                    touched[triangles[3*adjacency.triangles[a] + k]] = 1;
+
+            remap[from] = to;
+            Quadric_Add(&quadrics[canonical[to]], quadrics[canonical[from]]);
+            result_error = std::max(result_error, collapses[i].error);
+            triangles_left -= std::min(removed, triangles_left);
+            num_collapsed += 1;
+        }
+
+        if (num_collapsed == 0)
+            break;
+
+        // Aplicamos os colapsos, removendo os triângulos degenerados
+        size_t write = 0;
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            const uint32_t a = remap[triangles[i + 0]];
+            const uint32_t b = remap[triangles[i + 1]];
+            const uint32_t c = remap[triangles[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            triangles[write++] = a;
+            triangles[write++] = b;
+            triangles[write++] = c;
+        }
+        triangles.resize(write);
+
+        for (size_t i = 0; i < collapses.size(); ++i)
+            remap[collapses[i].from] = collapses[i].from;
+    }
+
+    destination->swap(triangles);
+    return (float)sqrt(result_error);
+}
+
+void MeshOpt_GenerateLods(MeshData* mesh)
+{
+    if (mesh->indices != mesh->index_storage.data())
+        mesh->index_storage.assign(mesh->indices, mesh->indices + mesh->num_indices);
+
+    std::vector<uint32_t> lod;
+
+    for (size_t s = 0; s < mesh->shapes.size(); ++s)
+    {
+        MeshShape& shape = mesh->shapes[s];
+        shape.lods.clear();
+
+        const float diagonal = glm::length(shape.bbox_max - shape.bbox_min);
+        size_t previous_count = shape.num_indices;
+
+        // Cada nível é simplificado a partir do shape original, para que o
+        // erro de cada um seja medido em relação à malha original.
+        for (int level = 0; level < MESHOPT_LOD_MAX_LEVELS; ++level)
+        {
+            if (previous_count / 3 < 2*MESHOPT_LOD_MIN_TRIANGLES)
+                break;
+
+            const size_t target = (previous_count / 6) * 3;
+            const float error = MeshOpt_SimplifyQuadric(*mesh, mesh->index_storage.data() + shape.first_index,
+                                                        shape.num_indices, target, MESHOPT_LOD_MAX_ERROR*diagonal, &lod);
+
+            // Nível que não reduziu significativamente os triângulos (limite
+            // de erro, ou malha sem arestas colapsáveis): fim da cadeia.
+            if (lod.empty() || lod.size() > previous_count - previous_count / 4)
+                break;
+
+            MeshLod entry;
+            entry.first_index = mesh->index_storage.size();
+            entry.num_indices = lod.size();
+            entry.error       = error;
+            shape.lods.push_back(entry);
+
+            mesh->index_storage.insert(mesh->index_storage.end(), lod.begin(), lod.end());
+            previous_count = lod.size();
+        }
+    }
+
+    mesh->UseStorage();
+}
+
+// Converte um float para half float (IEEE 754 binary16), arredondando para o
+// mais próximo. Valores fora do intervalo viram infinito; NaN continua NaN.
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign     = (bits >> 16) & 0x8000;
+    const int32_t  exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t       mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF)
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0)); // Inf ou NaN
+
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7C00); // Grande demais: infinito
+
+    if (exponent <= 0)
+    {
+        // Subnormal (ou zero) em half float
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;
+        const uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half += 1;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        half += 1; // Pode propagar para o expoente, o que é o correto
+    return (uint16_t)(sign | half);
+}
+
+// Quantiza uma componente em [-1, 1] para inteiro de 10 bits com sinal
+static uint32_t PackSnorm10(float value)
+{
+    value = std::max(-1.0f, std::min(1.0f, value));
+    int32_t q = (int32_t)floorf(value * 511.0f + 0.5f);
+    return (uint32_t)q & 0x3FF;
+}
+
+void MeshOpt_PackVertex(const float* position, const float* normal, const float* texcoord, PackedVertex* vertex)
+{
+    vertex->position[0] = position[0];
+    vertex->position[1] = position[1];
+    vertex->position[2] = position[2];
+
+    vertex->normal = 0;
+    if (normal)
+    {
+        // Somente a direção da normal importa para os shaders
+        float nx = normal[0];
+        float ny = normal[1];
+        float nz = normal[2];
+        float length = sqrtf(nx*nx + ny*ny + nz*nz);
+        if (length > 0.0f)
+        {
+            nx /= length;
+            ny /= length;
+            nz /= length;
+        }
+        vertex->normal = PackSnorm10(nx) | (PackSnorm10(ny) << 10) | (PackSnorm10(nz) << 20);
+    }
+
+    vertex->texcoord[0] = 0;
+    vertex->texcoord[1] = 0;
+    if (texcoord)
+    {
+        vertex->texcoord[0] = FloatToHalf(texcoord[0]);
+        vertex->texcoord[1] = FloatToHalf(texcoord[1]);
+    }
+}
+
+void MeshOpt_PackVertices(MeshData* mesh)
+{
+    const size_t num_vertices = mesh->num_vertices;
+
+    std::vector<PackedVertex> packed(num_vertices);
+    for (size_t i = 0; i < num_vertices; ++i)
+    {
+        MeshOpt_PackVertex(&mesh->model_coefficients[4*i],
+                           mesh->normal_coefficients ? &mesh->normal_coefficients[4*i] : NULL,
+                           mesh->texture_coefficients ? &mesh->texture_coefficients[2*i] : NULL,
+                           &packed[i]);
+    }
+
+    mesh->packed_storage.swap(packed);
+    mesh->vertex_attributes = (mesh->normal_coefficients ? MESHDATA_HAS_NORMALS : 0)
+                            | (mesh->texture_coefficients ? MESHDATA_HAS_TEXCOORDS : 0);
+    mesh->UseStorage();
+}
+
+void MeshOpt_PackIndices(MeshData* mesh)
+{
+    if (mesh->num_vertices <= 65536)
+    {
+        mesh->packed_index_storage.assign(mesh->indices, mesh->indices + mesh->num_indices);
+        mesh->packed_indices = mesh->packed_index_storage.empty() ? NULL : mesh->packed_index_storage.data();
+        mesh->index_size     = sizeof(uint16_t);
+    }
+    else
+    {
+        mesh->packed_index_storage.clear();
+        mesh->packed_indices = mesh->indices;
+        mesh->index_size     = sizeof(uint32_t);
+    }
+}
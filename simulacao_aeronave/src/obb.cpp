@@ -0,0 +1,160 @@
+// Caixas orientadas e testes de colisão em lotes. Veja "include/obb.h".
+#include "simdlane.h"
+#include "obb.h"
+
+// As caixas são testadas em lotes de LANE_WIDTH (veja "simdlane.h")
+#define OBB_BATCH LANE_WIDTH
+
+// Centro das caixas que completam o último lote, longe de qualquer objeto
+#define OBB_PADDING_CENTER 1e30f
+
+// Folga somada aos cossenos entre eixos, para que eixos quase paralelos (cujo
+// produto vetorial é quase nulo) não indiquem separação por erro numérico.
+#define OBB_EPSILON 1e-6f
+
+void Obb_FromModel(const glm::mat4& model, const glm::vec3& bbox_min, const glm::vec3& bbox_max, Obb* obb)
+{
+    const glm::vec3 half = (bbox_max - bbox_min) * 0.5f;
+    const glm::vec4 center = model * glm::vec4((bbox_min + bbox_max) * 0.5f, 1.0f);
+    obb->center = glm::vec3(center);
+
+    for (int j = 0; j < 3; ++j)
+    {
+        glm::vec3 column(model[j]);
+        float length = sqrtf(column.x*column.x + column.y*column.y + column.z*column.z);
+        obb->axes[j] = (length > 0.0f) ? column / length : glm::vec3(j == 0, j == 1, j == 2);
+        obb->extents[j] = half[j] * length;
+    }
+}
+
+float Obb_LowestY(const Obb& obb)
+{
+    return obb.center.y - fabsf(obb.axes[0].y) * obb.extents[0]
+                        - fabsf(obb.axes[1].y) * obb.extents[1]
+                        - fabsf(obb.axes[2].y) * obb.extents[2];
+}
+
+void ObbSet_Clear(ObbSet* set)
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        set->c[k].clear();
+        set->e[k].clear();
+    }
+    for (int k = 0; k < 9; ++k)
+        set->u[k].clear();
+    set->count = 0;
+}
+
+size_t ObbSet_Add(ObbSet* set, const Obb& obb)
+{
+    // Abrimos espaço para um lote inteiro de caixas distantes e degeneradas
+    if (set->count % OBB_BATCH == 0)
+    {
+        const size_t size = set->count + OBB_BATCH;
+        for (int k = 0; k < 3; ++k)
+        {
+            set->c[k].resize(size, OBB_PADDING_CENTER);
+            set->e[k].resize(size, 0.0f);
+        }
+        for (int k = 0; k < 9; ++k)
+            set->u[k].resize(size, (k % 4 == 0) ? 1.0f : 0.0f);
+    }
+
+    const size_t index = set->count;
+    for (int k = 0; k < 3; ++k)
+    {
+        set->c[k][index] = obb.center[k];
+        set->e[k][index] = obb.extents[k];
+    }
+    for (int j = 0; j < 3; ++j)
+        for (int k = 0; k < 3; ++k)
+            set->u[3*j + k][index] = obb.axes[j][k];
+
+    set->count += 1;
+    return index;
+}
+
+// Grava os resultados de um lote (bits de "mask") em "overlap"
+static size_t StoreMask(int mask, size_t first, size_t count, unsigned char* overlap)
+{
+    size_t hits = 0;
+    for (size_t i = 0; i < OBB_BATCH && first + i < count; ++i)
+    {
+        overlap[first + i] = (unsigned char)((mask >> i) & 1);
+        hits += overlap[first + i];
+    }
+    return hits;
+}
+
+size_t Obb_TestSet(const Obb& a, const ObbSet& set, unsigned char* overlap)
+{
+    size_t hits = 0;
+    for (size_t first = 0; first < set.count; first += OBB_BATCH)
+    {
+        // Eixos e centro das caixas do lote
+        Lane bu[3][3], be[3], t[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            for (int k = 0; k < 3; ++k)
+                bu[j][k] = LaneLoad(&set.u[3*j + k][first]);
+            be[j] = LaneLoad(&set.e[j][first]);
+        }
+
+        // Vetor entre os centros, no sistema de coordenadas de "a"
+        Lane d[3];
+        for (int k = 0; k < 3; ++k)
+            d[k] = LaneSub(LaneLoad(&set.c[k][first]), LaneSet(a.center[k]));
+        for (int i = 0; i < 3; ++i)
+            t[i] = LaneAdd(LaneAdd(LaneMul(d[0], LaneSet(a.axes[i].x)), LaneMul(d[1], LaneSet(a.axes[i].y))),
+                           LaneMul(d[2], LaneSet(a.axes[i].z)));
+
+        // R[i][j]: cosseno entre o eixo i de "a" e o eixo j da caixa do lote
+        Lane R[3][3], AbsR[3][3];
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                R[i][j] = LaneAdd(LaneAdd(LaneMul(bu[j][0], LaneSet(a.axes[i].x)), LaneMul(bu[j][1], LaneSet(a.axes[i].y))),
+                                  LaneMul(bu[j][2], LaneSet(a.axes[i].z)));
+                AbsR[i][j] = LaneAdd(LaneAbs(R[i][j]), LaneSet(OBB_EPSILON));
+            }
+        }
+
+        Lane separated = LaneFalse();
+
+        // Eixos de "a"
+        for (int i = 0; i < 3; ++i)
+        {
+            Lane ra = LaneSet(a.extents[i]);
+            Lane rb = LaneAdd(LaneAdd(LaneMul(be[0], AbsR[i][0]), LaneMul(be[1], AbsR[i][1])), LaneMul(be[2], AbsR[i][2]));
+            separated = LaneOr(separated, LaneGreater(LaneAbs(t[i]), LaneAdd(ra, rb)));
+        }
+
+        // Eixos das caixas do lote
+        for (int j = 0; j < 3; ++j)
+        {
+            Lane ra = LaneAdd(LaneAdd(LaneMul(LaneSet(a.extents[0]), AbsR[0][j]), LaneMul(LaneSet(a.extents[1]), AbsR[1][j])),
+                              LaneMul(LaneSet(a.extents[2]), AbsR[2][j]));
+            Lane distance = LaneAdd(LaneAdd(LaneMul(t[0], R[0][j]), LaneMul(t[1], R[1][j])), LaneMul(t[2], R[2][j]));
+            separated = LaneOr(separated, LaneGreater(LaneAbs(distance), LaneAdd(ra, be[j])));
+        }
+
+        // Produtos vetoriais: eixo i de "a" por eixo j da caixa do lote
+        for (int i = 0; i < 3; ++i)
+        {
+            const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; ++j)
+            {
+                const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                Lane ra = LaneAdd(LaneMul(LaneSet(a.extents[i1]), AbsR[i2][j]), LaneMul(LaneSet(a.extents[i2]), AbsR[i1][j]));
+                Lane rb = LaneAdd(LaneMul(be[j1], AbsR[i][j2]), LaneMul(be[j2], AbsR[i][j1]));
+                Lane distance = LaneSub(LaneMul(t[i2], R[i1][j]), LaneMul(t[i1], R[i2][j]));
+                separated = LaneOr(separated, LaneGreater(LaneAbs(distance), LaneAdd(ra, rb)));
+            }
+        }
+
+        hits += StoreMask(~LaneMask(separated), first, set.count, overlap);
+    }
+    return hits;
+}
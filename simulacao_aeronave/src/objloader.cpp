@@ -0,0 +1,719 @@
+// Leitor paralelo de arquivos ".obj". Veja "include/objloader.h".
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include <map>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "objloader.h"
+#include "mappedfile.h"
+
+// Abaixo deste tamanho o arquivo é lido em um único bloco, pois o custo de
+// criar threads seria maior que o ganho.
+#define OBJLOADER_MIN_CHUNK_SIZE (256*1024)
+
+// Comando encontrado no meio das faces de um bloco, que altera o shape ou o
+// material corrente. Estes são aplicados em ordem durante a junção dos blocos.
+struct ObjMarker
+{
+    enum Type { GROUP, OBJECT, USEMTL, MTLLIB };
+
+    size_t      face; // Número de faces do bloco lidas antes deste comando
+    Type        type;
+    std::string name;
+};
+
+// Resultado da leitura de um bloco do arquivo
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    std::vector<float> v;
+    std::vector<float> vn;
+    std::vector<float> vt;
+
+    // Triplas (v, vt, vn) de cada vértice de cada face, já com base zero.
+    // Índices negativos (relativos) dependem do número de vértices lidos
+    // pelos blocos anteriores; suas posições ficam em "relative", e eles
+    // são corrigidos na junção.
+    std::vector<int>      face_indices;
+    std::vector<uint32_t> relative;
+    std::vector<unsigned char> face_sizes;
+
+    std::vector<ObjMarker> markers;
+
+    bool unsupported; // Encontrou algum comando que somente tinyobj sabe tratar
+};
+
+#define OBJ_IS_SPACE(x) (((x) == ' ') || ((x) == '\t'))
+#define OBJ_IS_DIGIT(x) (static_cast<unsigned int>((x) - '0') < 10u)
+
+static inline const char* SkipSpaces(const char* p, const char* e)
+{
+    while (p < e && OBJ_IS_SPACE(*p))
+        ++p;
+    return p;
+}
+
+// Avança até o fim do token atual (espaço, tab, ou '\r')
+static inline const char* SkipToken(const char* p, const char* e)
+{
+    while (p < e && !OBJ_IS_SPACE(*p) && *p != '\r')
+        ++p;
+    return p;
+}
+
+// Potências de 10 exatamente representáveis em double
+static const double g_Pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Interpreta um número em ponto flutuante com a mesma gramática aceita por
+// tryParseDouble() da tinyobjloader ("-0", "+3.1417e+2", "11e2", ...), mas
+// acumulando a mantissa como inteiro, sem chamar pow() a cada dígito.
+static bool ParseDouble(const char* s, const char* e, double* result)
+{
+    if (s >= e)
+        return false;
+
+    bool negative = false;
+    if (*s == '+' || *s == '-')
+    {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int scale = 0; // Expoente decimal implícito pelos dígitos após o ponto
+    int read = 0;
+
+    while (s < e && OBJ_IS_DIGIT(*s))
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa*10 + (uint64_t)(*s - '0');
+            if (mantissa != 0) ++digits;
+        }
+        else
+        {
+            ++scale;
+        }
+        ++s;
+        ++read;
+    }
+
+    if (read == 0)
+        return false;
+
+    if (s < e && *s == '.')
+    {
+        ++s;
+        while (s < e && OBJ_IS_DIGIT(*s))
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa*10 + (uint64_t)(*s - '0');
+                if (mantissa != 0) ++digits;
+                --scale;
+            }
+            ++s;
+        }
+    }
+
+    if (s < e && (*s == 'e' || *s == 'E'))
+    {
+        ++s;
+        bool exp_negative = false;
+        if (s < e && (*s == '+' || *s == '-'))
+        {
+            exp_negative = (*s == '-');
+            ++s;
+        }
+        else if (!(s < e && OBJ_IS_DIGIT(*s)))
+        {
+            return false; // "E" vazio não é permitido
+        }
+
+        int exponent = 0;
+        read = 0;
+        while (s < e && OBJ_IS_DIGIT(*s))
+        {
+            if (exponent < 10000)
+                exponent = exponent*10 + (*s - '0');
+            ++s;
+            ++read;
+        }
+        if (read == 0)
+            return false;
+
+        scale += exp_negative ? -exponent : exponent;
+    }
+
+    double value = (double)mantissa;
+    if (scale < 0)
+    {
+        if (scale >= -22)
+            value /= g_Pow10[-scale];
+        else
+            value *= pow(10.0, scale);
+    }
+    else if (scale > 0)
+    {
+        if (scale <= 22)
+            value *= g_Pow10[scale];
+        else
+            value *= pow(10.0, scale);
+    }
+
+    *result = negative ? -value : value;
+    return true;
+}
+
+static inline float ParseFloat(const char** token, const char* e, double default_value = 0.0)
+{
+    const char* s = SkipSpaces(*token, e);
+    const char* end = SkipToken(s, e);
+    double value = default_value;
+    ParseDouble(s, end, &value);
+    *token = end;
+    return (float)value;
+}
+
+// Equivalente a atoi(): aceita sinal e para no primeiro caractere inválido
+static inline int ParseInt(const char* s, const char* e)
+{
+    bool negative = false;
+    if (s < e && (*s == '+' || *s == '-'))
+    {
+        negative = (*s == '-');
+        ++s;
+    }
+    int value = 0;
+    while (s < e && OBJ_IS_DIGIT(*s))
+    {
+        value = value*10 + (*s - '0');
+        ++s;
+    }
+    return negative ? -value : value;
+}
+
+static inline const char* SkipIndex(const char* p, const char* e)
+{
+    while (p < e && *p != '/' && !OBJ_IS_SPACE(*p) && *p != '\r')
+        ++p;
+    return p;
+}
+
+// Converte um índice do arquivo para base zero, como fixIndex() da
+// tinyobjloader. Índices negativos são relativos ao número de elementos já
+// lidos; como este bloco não conhece os blocos anteriores, a posição do
+// índice é guardada para correção posterior.
+static inline int FixIndex(int idx, size_t local_count, ObjChunk* chunk)
+{
+    if (idx > 0) return idx - 1;
+    if (idx == 0) return 0;
+    chunk->relative.push_back((uint32_t)chunk->face_indices.size());
+    return (int)local_count + idx;
+}
+
+// Interpreta uma tripla "i", "i/j", "i//k" ou "i/j/k" e guarda (v, vt, vn)
+static inline const char* ParseTriple(const char* p, const char* e, ObjChunk* chunk)
+{
+    int v, vt, vn;
+
+    v = FixIndex(ParseInt(p, e), chunk->v.size() / 3, chunk);
+    chunk->face_indices.push_back(v);
+    p = SkipIndex(p, e);
+
+    if (p < e && *p == '/')
+    {
+        ++p;
+        if (p < e && *p == '/')
+        {
+            // i//k
+            ++p;
+            chunk->face_indices.push_back(-1);
+            vn = FixIndex(ParseInt(p, e), chunk->vn.size() / 3, chunk);
+            chunk->face_indices.push_back(vn);
+            return SkipIndex(p, e);
+        }
+
+        // i/j/k ou i/j
+        vt = FixIndex(ParseInt(p, e), chunk->vt.size() / 2, chunk);
+        chunk->face_indices.push_back(vt);
+        p = SkipIndex(p, e);
+
+        if (p < e && *p == '/')
+        {
+            ++p;
+            vn = FixIndex(ParseInt(p, e), chunk->vn.size() / 3, chunk);
+            chunk->face_indices.push_back(vn);
+            return SkipIndex(p, e);
+        }
+
+        chunk->face_indices.push_back(-1);
+        return p;
+    }
+
+    chunk->face_indices.push_back(-1);
+    chunk->face_indices.push_back(-1);
+    return p;
+}
+
+static std::string ParseName(const char* p, const char* e)
+{
+    p = SkipSpaces(p, e);
+    const char* end = SkipToken(p, e);
+    return std::string(p, end);
+}
+
+static void ParseLine(const char* p, const char* e, ObjChunk* chunk)
+{
+    p = SkipSpaces(p, e);
+    if (p >= e || *p == '#')
+        return;
+
+    const size_t n = (size_t)(e - p);
+
+    if (p[0] == 'v' && n > 1 && OBJ_IS_SPACE(p[1]))
+    {
+        p += 2;
+        chunk->v.push_back(ParseFloat(&p, e));
+        chunk->v.push_back(ParseFloat(&p, e));
+        chunk->v.push_back(ParseFloat(&p, e));
+        return;
+    }
+
+    if (p[0] == 'v' && n > 2 && p[1] == 'n' && OBJ_IS_SPACE(p[2]))
+    {
+        p += 3;
+        chunk->vn.push_back(ParseFloat(&p, e));
+        chunk->vn.push_back(ParseFloat(&p, e));
+        chunk->vn.push_back(ParseFloat(&p, e));
+        return;
+    }
+
+    if (p[0] == 'v' && n > 2 && p[1] == 't' && OBJ_IS_SPACE(p[2]))
+    {
+        p += 3;
+        chunk->vt.push_back(ParseFloat(&p, e));
+        chunk->vt.push_back(ParseFloat(&p, e));
+        return;
+    }
+
+    if (p[0] == 'f' && n > 1 && OBJ_IS_SPACE(p[1]))
+    {
+        p = SkipSpaces(p + 2, e);
+
+        size_t num_vertices = 0;
+        while (p < e && *p != '\r')
+        {
+            p = ParseTriple(p, e, chunk);
+            while (p < e && (OBJ_IS_SPACE(*p) || *p == '\r'))
+                ++p;
+            ++num_vertices;
+        }
+
+        chunk->face_sizes.push_back((unsigned char)num_vertices);
+        return;
+    }
+
+    ObjMarker marker;
+    marker.face = chunk->face_sizes.size();
+
+    if (n > 6 && strncmp(p, "usemtl", 6) == 0 && OBJ_IS_SPACE(p[6]))
+    {
+        marker.type = ObjMarker::USEMTL;
+        marker.name = ParseName(p + 7, e);
+        chunk->markers.push_back(marker);
+        return;
+    }
+
+    if (n > 6 && strncmp(p, "mtllib", 6) == 0 && OBJ_IS_SPACE(p[6]))
+    {
+        marker.type = ObjMarker::MTLLIB;
+        marker.name = ParseName(p + 7, e);
+        chunk->markers.push_back(marker);
+        return;
+    }
+
+    if (p[0] == 'g' && n > 1 && OBJ_IS_SPACE(p[1]))
+    {
+        // Assim como tinyobj, utilizamos somente o primeiro nome do grupo
+        marker.type = ObjMarker::GROUP;
+        marker.name = ParseName(p + 2, e);
+        chunk->markers.push_back(marker);
+        return;
+    }
+
+    if (p[0] == 'o' && n > 1 && OBJ_IS_SPACE(p[1]))
+    {
+        marker.type = ObjMarker::OBJECT;
+        marker.name = ParseName(p + 2, e);
+        chunk->markers.push_back(marker);
+        return;
+    }
+
+    if (p[0] == 't' && n > 1 && OBJ_IS_SPACE(p[1]))
+    {
+        chunk->unsupported = true;
+        return;
+    }
+
+    // Comandos desconhecidos são ignorados, como na tinyobjloader
+}
+
+static void ParseChunk(ObjChunk* chunk)
+{
+    const char* p = chunk->begin;
+    const char* end = chunk->end;
+
+    // Estimativa grosseira para evitar realocações: ~30 bytes por linha
+    size_t estimated_lines = (size_t)(end - p) / 30;
+    chunk->v.reserve(estimated_lines * 3 / 2);
+    chunk->face_indices.reserve(estimated_lines * 6);
+    chunk->face_sizes.reserve(estimated_lines);
+
+    while (p < end)
+    {
+        const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+        if (eol == NULL)
+            eol = end;
+
+        const char* line_end = eol;
+        if (line_end > p && line_end[-1] == '\r')
+            --line_end;
+
+        ParseLine(p, line_end, chunk);
+        p = eol + 1;
+    }
+}
+
+// Estado da junção dos blocos, que reproduz as regras de LoadObj() para
+// divisão das faces em shapes.
+struct ObjMergeState
+{
+    tinyobj::shape_t shape;
+    std::string      name;
+    int              material;
+    size_t           pending_faces; // Faces ainda não "exportadas" para o shape corrente
+
+    std::map<std::string, int> material_map;
+};
+
+static void AppendFace(ObjMergeState* state, const tinyobj::index_t* face, size_t num_vertices, bool triangulate)
+{
+    tinyobj::mesh_t& mesh = state->shape.mesh;
+
+    if (triangulate)
+    {
+        // Polígono -> leque de triângulos
+        for (size_t k = 2; k < num_vertices; ++k)
+        {
+            mesh.indices.push_back(face[0]);
+            mesh.indices.push_back(face[k-1]);
+            mesh.indices.push_back(face[k]);
+            mesh.num_face_vertices.push_back(3);
+            mesh.material_ids.push_back(state->material);
+        }
+    }
+    else
+    {
+        for (size_t k = 0; k < num_vertices; ++k)
+            mesh.indices.push_back(face[k]);
+        mesh.num_face_vertices.push_back((unsigned char)num_vertices);
+        mesh.material_ids.push_back(state->material);
+    }
+
+    state->pending_faces += 1;
+}
+
+static bool ApplyMarker(ObjMergeState* state, const ObjMarker& marker,
+                        std::vector<tinyobj::shape_t>* shapes,
+                        std::vector<tinyobj::material_t>* materials,
+                        tinyobj::MaterialReader* reader, std::string* err)
+{
+    switch (marker.type)
+    {
+    case ObjMarker::USEMTL:
+    {
+        int new_material = -1;
+        std::map<std::string, int>::const_iterator it = state->material_map.find(marker.name);
+        if (it != state->material_map.end())
+            new_material = it->second;
+
+        if (new_material != state->material)
+        {
+            if (state->pending_faces > 0)
+            {
+                state->shape.name = state->name;
+                state->pending_faces = 0;
+            }
+            state->material = new_material;
+        }
+        break;
+    }
+    case ObjMarker::MTLLIB:
+    {
+        std::string err_mtl;
+        bool ok = (*reader)(marker.name, materials, &state->material_map, &err_mtl);
+        if (err)
+            (*err) += err_mtl;
+        if (!ok)
+            return false;
+        break;
+    }
+    case ObjMarker::GROUP:
+    case ObjMarker::OBJECT:
+        if (state->pending_faces > 0)
+        {
+            state->shape.name = state->name;
+            shapes->push_back(state->shape);
+        }
+        state->shape = tinyobj::shape_t();
+        state->pending_faces = 0;
+        state->name = marker.name;
+        break;
+    }
+    return true;
+}
+
+bool ObjLoader_LoadParallel(tinyobj::attrib_t* attrib,
+                            std::vector<tinyobj::shape_t>* shapes,
+                            std::vector<tinyobj::material_t>* materials,
+                            std::string* err,
+                            const char* filename,
+                            const char* mtl_basepath,
+                            bool triangulate)
+{
+    MappedFile file;
+    if (!MappedFile_Open(filename, &file))
+        return tinyobj::LoadObj(attrib, shapes, materials, err, filename, mtl_basepath, triangulate);
+
+    const char* data = (const char*)file.data;
+    const size_t size = file.size;
+
+    // Divisão do arquivo em blocos terminados em '\n'
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t num_chunks = std::min(num_threads, std::max((size_t)1, size / OBJLOADER_MIN_CHUNK_SIZE));
+
+    std::vector<ObjChunk> chunks(num_chunks);
+    const char* begin = data;
+    for (size_t i = 0; i < num_chunks; ++i)
+    {
+        const char* end = (i + 1 == num_chunks) ? data + size : data + (size * (i + 1)) / num_chunks;
+        if (end < begin)
+            end = begin;
+        if (end < data + size)
+        {
+            const char* eol = (const char*)memchr(end, '\n', (size_t)(data + size - end));
+            end = eol ? eol + 1 : data + size;
+        }
+
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        chunks[i].unsupported = false;
+        begin = end;
+    }
+
+    // Cada bloco é lido por uma thread; a thread atual lê o primeiro.
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < num_chunks; ++i)
+        workers.push_back(std::thread(ParseChunk, &chunks[i]));
+    ParseChunk(&chunks[0]);
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+
+    for (size_t i = 0; i < num_chunks; ++i)
+    {
+        if (chunks[i].unsupported)
+        {
+            MappedFile_Close(&file);
+            return tinyobj::LoadObj(attrib, shapes, materials, err, filename, mtl_basepath, triangulate);
+        }
+    }
+
+    // Junção dos atributos de vértices, na ordem do arquivo
+    size_t total_v = 0, total_vn = 0, total_vt = 0;
+    for (size_t i = 0; i < num_chunks; ++i)
+    {
+        total_v  += chunks[i].v.size();
+        total_vn += chunks[i].vn.size();
+        total_vt += chunks[i].vt.size();
+    }
+
+    attrib->vertices.clear();
+    attrib->normals.clear();
+    attrib->texcoords.clear();
+    attrib->vertices.reserve(total_v);
+    attrib->normals.reserve(total_vn);
+    attrib->texcoords.reserve(total_vt);
+    shapes->clear();
+
+    std::string basepath = mtl_basepath ? mtl_basepath : "";
+    tinyobj::MaterialFileReader reader(basepath);
+
+    ObjMergeState state;
+    state.material = -1;
+    state.pending_faces = 0;
+
+    std::vector<tinyobj::index_t> face;
+
+    for (size_t c = 0; c < num_chunks; ++c)
+    {
+        ObjChunk& chunk = chunks[c];
+
+        // Correção dos índices relativos (negativos) com o número de
+        // elementos lidos pelos blocos anteriores.
+        const int base[3] = {
+            (int)(attrib->vertices.size() / 3),
+            (int)(attrib->texcoords.size() / 2),
+            (int)(attrib->normals.size() / 3)
+        };
+        for (size_t i = 0; i < chunk.relative.size(); ++i)
+            chunk.face_indices[chunk.relative[i]] += base[chunk.relative[i] % 3];
+
+        attrib->vertices.insert(attrib->vertices.end(), chunk.v.begin(), chunk.v.end());
+        attrib->normals.insert(attrib->normals.end(), chunk.vn.begin(), chunk.vn.end());
+        attrib->texcoords.insert(attrib->texcoords.end(), chunk.vt.begin(), chunk.vt.end());
+
+        size_t next_marker = 0;
+        size_t position = 0;
+        for (size_t f = 0; f <= chunk.face_sizes.size(); ++f)
+        {
+            while (next_marker < chunk.markers.size() && chunk.markers[next_marker].face == f)
+            {
+                if (!ApplyMarker(&state, chunk.markers[next_marker], shapes, materials, &reader, err))
+                    return false;
+                ++next_marker;
+            }
+
+            if (f == chunk.face_sizes.size())
+                break;
+
+            size_t num_vertices = chunk.face_sizes[f];
+            face.resize(num_vertices);
+            for (size_t k = 0; k < num_vertices; ++k, position += 3)
+            {
+                face[k].vertex_index   = chunk.face_indices[position + 0];
+                face[k].texcoord_index = chunk.face_indices[position + 1];
+                face[k].normal_index   = chunk.face_indices[position + 2];
+            }
+
+            if (num_vertices > 0)
+                AppendFace(&state, face.data(), num_vertices, triangulate);
+        }
+
+        // Liberamos a memória do bloco assim que ele é consumido
+        std::vector<float>().swap(chunk.v);
+        std::vector<float>().swap(chunk.vn);
+        std::vector<float>().swap(chunk.vt);
+        std::vector<int>().swap(chunk.face_indices);
+    }
+
+    if (state.pending_faces > 0)
+    {
+        state.shape.name = state.name;
+        shapes->push_back(state.shape);
+    }
+
+    return true;
+}
+
+// Compara dois resultados de leitura. Retorna a maior diferença absoluta
+// entre atributos, ou infinito se a estrutura dos resultados for diferente.
+static double CompareResults(const tinyobj::attrib_t& a, const std::vector<tinyobj::shape_t>& sa,
+                             const tinyobj::attrib_t& b, const std::vector<tinyobj::shape_t>& sb)
+{
+    const double mismatch = INFINITY;
+
+    if (a.vertices.size() != b.vertices.size() || a.normals.size() != b.normals.size()
+        || a.texcoords.size() != b.texcoords.size() || sa.size() != sb.size())
+        return mismatch;
+
+    for (size_t i = 0; i < sa.size(); ++i)
+    {
+        const tinyobj::mesh_t& ma = sa[i].mesh;
+        const tinyobj::mesh_t& mb = sb[i].mesh;
+        if (sa[i].name != sb[i].name || ma.indices.size() != mb.indices.size()
+            || ma.num_face_vertices != mb.num_face_vertices || ma.material_ids != mb.material_ids)
+            return mismatch;
+
+        for (size_t k = 0; k < ma.indices.size(); ++k)
+        {
+            if (ma.indices[k].vertex_index != mb.indices[k].vertex_index
+                || ma.indices[k].normal_index != mb.indices[k].normal_index
+                || ma.indices[k].texcoord_index != mb.indices[k].texcoord_index)
+                return mismatch;
+        }
+    }
+
+    double max_diff = 0.0;
+    for (size_t i = 0; i < a.vertices.size(); ++i)
+        max_diff = std::max(max_diff, (double)fabs(a.vertices[i] - b.vertices[i]));
+    for (size_t i = 0; i < a.normals.size(); ++i)
+        max_diff = std::max(max_diff, (double)fabs(a.normals[i] - b.normals[i]));
+    for (size_t i = 0; i < a.texcoords.size(); ++i)
+        max_diff = std::max(max_diff, (double)fabs(a.texcoords[i] - b.texcoords[i]));
+    return max_diff;
+}
+
+void ObjLoader_Benchmark(const std::vector<std::string>& filenames, int repetitions)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    printf("Comparando leitores de OBJ (%u threads, melhor de %d execuções)\n",
+           std::max(1u, std::thread::hardware_concurrency()), repetitions);
+    printf("%-32s %12s %12s %9s %12s\n", "arquivo", "tinyobj(ms)", "paralelo(ms)", "ganho", "dif. max");
+
+    for (size_t f = 0; f < filenames.size(); ++f)
+    {
+        const char* filename = filenames[f].c_str();
+
+        // O caminho base para arquivos ".mtl" é o diretório do arquivo
+        std::string basepath = filenames[f].substr(0, filenames[f].find_last_of("/\\") + 1);
+
+        double best_serial = INFINITY;
+        double best_parallel = INFINITY;
+
+        tinyobj::attrib_t attrib_serial, attrib_parallel;
+        std::vector<tinyobj::shape_t> shapes_serial, shapes_parallel;
+        bool ok = true;
+
+        for (int r = 0; r < repetitions && ok; ++r)
+        {
+            std::vector<tinyobj::material_t> materials;
+            std::string err;
+
+            Clock::time_point t0 = Clock::now();
+            ok = tinyobj::LoadObj(&attrib_serial, &shapes_serial, &materials, &err, filename, basepath.c_str());
+            Clock::time_point t1 = Clock::now();
+
+            materials.clear();
+            ok = ObjLoader_LoadParallel(&attrib_parallel, &shapes_parallel, &materials, &err, filename, basepath.c_str()) && ok;
+            Clock::time_point t2 = Clock::now();
+
+            best_serial   = std::min(best_serial, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            best_parallel = std::min(best_parallel, std::chrono::duration<double, std::milli>(t2 - t1).count());
+        }
+
+        if (!ok)
+        {
+            printf("%-32s falha na leitura\n", filename);
+            continue;
+        }
+
+        double diff = CompareResults(attrib_serial, shapes_serial, attrib_parallel, shapes_parallel);
+        if (std::isinf(diff))
+            printf("%-32s %12.2f %12.2f %8.2fx %12s\n", filename, best_serial, best_parallel, best_serial / best_parallel, "DIFERENTE");
+        else
+            printf("%-32s %12.2f %12.2f %8.2fx %12.2g\n", filename, best_serial, best_parallel, best_serial / best_parallel, diff);
+    }
+}
@@ -0,0 +1,395 @@
+// Importação de arquivos ".obj" direto para a GPU. Veja "include/objstream.h".
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include <limits>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+
+#include <glm/common.hpp>
+
+#include <tiny_obj_loader.h>
+
+#include "objstream.h"
+#include "meshopt.h"
+
+// Converte um índice do arquivo (a partir de 1, negativo se relativo ao
+// final, 0 se ausente) para um índice a partir de 0, ou -1. "count" é o
+// número de elementos lidos até a face.
+static int ResolveIndex(int index, size_t count)
+{
+    if (index > 0)
+        return index - 1;
+    if (index < 0)
+        return (int)count + index;
+    return -1;
+}
+
+// Estado da primeira leitura (ObjStream_Open())
+struct ObjStreamOpenState
+{
+    ObjStream*         stream;
+    bool               accumulate_normals; // Normais calculadas por posição, em "accumulated"
+    std::vector<float> accumulated;
+    bool               all_normals;        // Todos os vértices das faces têm "vn"
+    bool               all_texcoords;      // Todos os vértices das faces têm "vt"
+    size_t             num_vertices;       // Vértices dos triângulos lidos até aqui
+    size_t             first_vertex;       // Primeiro vértice do shape corrente
+    std::string        name;               // Nome do shape corrente
+};
+
+static void OpenVertex(void* user_data, float x, float y, float z, float /*w*/)
+{
+    ObjStreamOpenState* state = (ObjStreamOpenState*)user_data;
+    state->stream->positions.push_back(x);
+    state->stream->positions.push_back(y);
+    state->stream->positions.push_back(z);
+}
+
+static void OpenNormal(void* user_data, float x, float y, float z)
+{
+    ObjStreamOpenState* state = (ObjStreamOpenState*)user_data;
+
+    // Como em ComputeNormals(), as normais só são calculadas se o arquivo não
+    // tiver nenhuma linha "vn".
+    if (state->accumulate_normals)
+    {
+        state->accumulate_normals = false;
+        std::vector<float>().swap(state->accumulated);
+    }
+
+    state->stream->normals.push_back(x);
+    state->stream->normals.push_back(y);
+    state->stream->normals.push_back(z);
+}
+
+static void OpenTexcoord(void* user_data, float x, float y, float /*z*/)
+{
+    ObjStreamOpenState* state = (ObjStreamOpenState*)user_data;
+    state->stream->texcoords.push_back(x);
+    state->stream->texcoords.push_back(y);
+}
+
+static void OpenFace(void* user_data, tinyobj::index_t* indices, int num_indices)
+{
+    ObjStreamOpenState* state = (ObjStreamOpenState*)user_data;
+    if (num_indices < 3)
+        return;
+
+    for (int k = 0; k < num_indices; ++k)
+    {
+        state->all_normals   = state->all_normals && indices[k].normal_index != 0;
+        state->all_texcoords = state->all_texcoords && indices[k].texcoord_index != 0;
+    }
+
+    // Polígono -> leque de triângulos, como em LoadObj()
+    state->num_vertices += 3 * (size_t)(num_indices - 2);
+
+    if (!state->accumulate_normals)
+        return;
+
+    // Soma a normal (com peso proporcional à área) de cada triângulo nas suas
+    // três posições. Faces que referenciam posições ainda não lidas (o que
+    // nenhum exportador usual produz) são ignoradas.
+    std::vector<float>& positions = state->stream->positions;
+    std::vector<float>& normals   = state->accumulated;
+    const size_t num_positions = positions.size() / 3;
+    normals.resize(3 * num_positions, 0.0f);
+
+    const int a = ResolveIndex(indices[0].vertex_index, num_positions);
+    for (int k = 2; k < num_indices; ++k)
+    {
+        const int b = ResolveIndex(indices[k-1].vertex_index, num_positions);
+        const int c = ResolveIndex(indices[k].vertex_index, num_positions);
+        if (a < 0 || b < 0 || c < 0 || (size_t)a >= num_positions || (size_t)b >= num_positions || (size_t)c >= num_positions)
+            continue;
+
+        const float* pa = &positions[3*a];
+        const float* pb = &positions[3*b];
+        const float* pc = &positions[3*c];
+        const float u[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+        const float v[3] = { pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2] };
+        const float n[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            normals[3*a + i] += n[i];
+            normals[3*b + i] += n[i];
+            normals[3*c + i] += n[i];
+        }
+    }
+}
+
+// Fecha o shape corrente, se tiver faces, e inicia um novo com "name"
+static void OpenShape(ObjStreamOpenState* state, const char* name)
+{
+    if (state->num_vertices > state->first_vertex)
+    {
+        MeshShape shape;
+        shape.name        = state->name;
+        shape.first_index = state->first_vertex;
+        shape.num_indices = state->num_vertices - state->first_vertex;
+        state->stream->mesh.shapes.push_back(shape);
+    }
+
+    state->first_vertex = state->num_vertices;
+    state->name = name;
+}
+
+static void OpenGroup(void* user_data, const char** names, int num_names)
+{
+    OpenShape((ObjStreamOpenState*)user_data, num_names > 0 ? names[0] : "");
+}
+
+static void OpenObject(void* user_data, const char* name)
+{
+    OpenShape((ObjStreamOpenState*)user_data, name);
+}
+
+bool ObjStream_Open(const char* filename, bool compute_normals, ObjStream* stream, std::string* err)
+{
+    printf("Carregando modelo \"%s\" diretamente para a GPU... ", filename);
+
+    std::ifstream file(filename);
+    if (!file)
+    {
+        if (err)
+            *err = "Cannot open file \"" + std::string(filename) + "\".";
+        return false;
+    }
+
+    stream->filename = filename;
+    stream->positions.clear();
+    stream->normals.clear();
+    stream->texcoords.clear();
+    stream->mesh.shapes.clear();
+
+    ObjStreamOpenState state;
+    state.stream             = stream;
+    state.accumulate_normals = compute_normals;
+    state.all_normals        = true;
+    state.all_texcoords      = true;
+    state.num_vertices       = 0;
+    state.first_vertex       = 0;
+
+    tinyobj::callback_t callbacks;
+    callbacks.vertex_cb   = OpenVertex;
+    callbacks.normal_cb   = OpenNormal;
+    callbacks.texcoord_cb = OpenTexcoord;
+    callbacks.index_cb    = OpenFace;
+    callbacks.group_cb    = OpenGroup;
+    callbacks.object_cb   = OpenObject;
+
+    if (!tinyobj::LoadObjWithCallback(file, callbacks, &state, NULL, err))
+        return false;
+    OpenShape(&state, "");
+
+    MeshData& mesh = stream->mesh;
+    stream->computed_normals = state.accumulate_normals;
+    if (stream->computed_normals)
+    {
+        state.accumulated.resize(stream->positions.size(), 0.0f);
+        stream->normals.swap(state.accumulated);
+        state.all_normals = true;
+    }
+
+    mesh.num_vertices      = state.num_vertices;
+    mesh.num_indices       = state.num_vertices;
+    mesh.index_size        = mesh.num_vertices <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+    mesh.vertex_attributes = (state.all_normals && !stream->normals.empty() ? MESHDATA_HAS_NORMALS : 0)
+                           | (state.all_texcoords && !stream->texcoords.empty() ? MESHDATA_HAS_TEXCOORDS : 0);
+
+    printf("OK.\n");
+    return true;
+}
+
+// Estado da segunda leitura (ObjStream_Write()). Os vértices e índices são
+// montados em lotes na memória comum e copiados em sequência para o destino,
+// que pode ser memória da GPU "write-combined", lenta para escritas esparsas
+// e para leituras.
+struct ObjStreamWriteState
+{
+    ObjStream*     stream;
+    PackedVertex*  vertices;      // Destino
+    unsigned char* indices;
+    size_t         num_positions; // Linhas "v", "vn" e "vt" lidas até aqui
+    size_t         num_normals;
+    size_t         num_texcoords;
+    size_t         written;       // Vértices já copiados para o destino
+    size_t         shape;         // Shape do próximo vértice
+    bool           invalid_index;
+
+    PackedVertex   batch[OBJSTREAM_BATCH_VERTICES];
+    uint32_t       batch_indices[OBJSTREAM_BATCH_VERTICES];
+    size_t         batch_size;
+};
+
+static void FlushBatch(ObjStreamWriteState* state)
+{
+    const size_t n = std::min(state->batch_size, state->stream->mesh.num_vertices - state->written);
+
+    memcpy(state->vertices + state->written, state->batch, n * sizeof(PackedVertex));
+
+    if (state->stream->mesh.index_size == sizeof(uint16_t))
+    {
+        uint16_t indices16[OBJSTREAM_BATCH_VERTICES];
+        for (size_t i = 0; i < n; ++i)
+            indices16[i] = (uint16_t)state->batch_indices[i];
+        memcpy(state->indices + state->written * sizeof(uint16_t), indices16, n * sizeof(uint16_t));
+    }
+    else
+    {
+        memcpy(state->indices + state->written * sizeof(uint32_t), state->batch_indices, n * sizeof(uint32_t));
+    }
+
+    state->written += n;
+    state->batch_size = 0;
+}
+
+static void WriteVertex(void* user_data, float, float, float, float)
+{
+    ((ObjStreamWriteState*)user_data)->num_positions += 1;
+}
+
+static void WriteNormal(void* user_data, float, float, float)
+{
+    ((ObjStreamWriteState*)user_data)->num_normals += 1;
+}
+
+static void WriteTexcoord(void* user_data, float, float, float)
+{
+    ((ObjStreamWriteState*)user_data)->num_texcoords += 1;
+}
+
+// Adiciona ao lote o vértice "corner" de um triângulo
+static void WriteCorner(ObjStreamWriteState* state, const tinyobj::index_t& corner)
+{
+    const ObjStream* stream = state->stream;
+    const size_t total_positions = stream->positions.size() / 3;
+    const size_t total_normals   = stream->normals.size() / 3;
+    const size_t total_texcoords = stream->texcoords.size() / 2;
+
+    static const float origin[3] = { 0.0f, 0.0f, 0.0f };
+    const float* position = origin;
+    const float* normal   = NULL;
+    const float* texcoord = NULL;
+
+    const int v = ResolveIndex(corner.vertex_index, state->num_positions);
+    if (v >= 0 && (size_t)v < total_positions)
+        position = &stream->positions[3*v];
+    else
+        state->invalid_index = true;
+
+    if (stream->mesh.vertex_attributes & MESHDATA_HAS_NORMALS)
+    {
+        const int n = stream->computed_normals ? v : ResolveIndex(corner.normal_index, state->num_normals);
+        if (n >= 0 && (size_t)n < total_normals)
+            normal = &stream->normals[3*n];
+        else
+            state->invalid_index = true;
+    }
+
+    if (stream->mesh.vertex_attributes & MESHDATA_HAS_TEXCOORDS)
+    {
+        const int t = ResolveIndex(corner.texcoord_index, state->num_texcoords);
+        if (t >= 0 && (size_t)t < total_texcoords)
+            texcoord = &stream->texcoords[2*t];
+        else
+            state->invalid_index = true;
+    }
+
+    // Bounding box do shape a que o vértice pertence
+    const size_t vertex = state->written + state->batch_size;
+    std::vector<MeshShape>& shapes = state->stream->mesh.shapes;
+    while (state->shape + 1 < shapes.size() && vertex >= shapes[state->shape + 1].first_index)
+        state->shape += 1;
+    if (state->shape < shapes.size())
+    {
+        MeshShape& shape = shapes[state->shape];
+        shape.bbox_min = glm::min(shape.bbox_min, glm::vec3(position[0], position[1], position[2]));
+        shape.bbox_max = glm::max(shape.bbox_max, glm::vec3(position[0], position[1], position[2]));
+    }
+
+    MeshOpt_PackVertex(position, normal, texcoord, &state->batch[state->batch_size]);
+    state->batch_indices[state->batch_size] = (uint32_t)vertex;
+    state->batch_size += 1;
+
+    if (state->batch_size == OBJSTREAM_BATCH_VERTICES)
+        FlushBatch(state);
+}
+
+static void WriteFace(void* user_data, tinyobj::index_t* indices, int num_indices)
+{
+    ObjStreamWriteState* state = (ObjStreamWriteState*)user_data;
+
+    // Mesma triangulação de ObjStream_Open(). Vértices além dos contados na
+    // primeira leitura (se o arquivo mudou entre as leituras) são descartados.
+    for (int k = 2; k < num_indices; ++k)
+    {
+        if (state->written + state->batch_size + 3 > state->stream->mesh.num_vertices)
+        {
+            state->invalid_index = true;
+            return;
+        }
+
+        WriteCorner(state, indices[0]);
+        WriteCorner(state, indices[k-1]);
+        WriteCorner(state, indices[k]);
+    }
+}
+
+bool ObjStream_Write(ObjStream* stream, PackedVertex* vertices, void* indices, std::string* err)
+{
+    std::ifstream file(stream->filename.c_str());
+    if (!file)
+    {
+        if (err)
+            *err = "Cannot open file \"" + stream->filename + "\".";
+        return false;
+    }
+
+    const float maxval = std::numeric_limits<float>::max();
+    for (size_t shape = 0; shape < stream->mesh.shapes.size(); ++shape)
+    {
+        stream->mesh.shapes[shape].bbox_min = glm::vec3(maxval, maxval, maxval);
+        stream->mesh.shapes[shape].bbox_max = glm::vec3(-maxval, -maxval, -maxval);
+    }
+
+    // O estado tem os lotes (cerca de 100 KB), logo não fica na pilha
+    std::unique_ptr<ObjStreamWriteState> state(new ObjStreamWriteState);
+    state->stream        = stream;
+    state->vertices      = vertices;
+    state->indices       = (unsigned char*)indices;
+    state->num_positions = 0;
+    state->num_normals   = 0;
+    state->num_texcoords = 0;
+    state->written       = 0;
+    state->shape         = 0;
+    state->invalid_index = false;
+    state->batch_size    = 0;
+
+    tinyobj::callback_t callbacks;
+    callbacks.vertex_cb   = WriteVertex;
+    callbacks.normal_cb   = WriteNormal;
+    callbacks.texcoord_cb = WriteTexcoord;
+    callbacks.index_cb    = WriteFace;
+
+    bool ok = tinyobj::LoadObjWithCallback(file, callbacks, state.get(), NULL, err);
+    FlushBatch(state.get());
+
+    // Os atributos não são mais necessários: os vértices estão no destino
+    std::vector<float>().swap(stream->positions);
+    std::vector<float>().swap(stream->normals);
+    std::vector<float>().swap(stream->texcoords);
+
+    if (ok && (state->invalid_index || state->written != stream->mesh.num_vertices))
+    {
+        if (err)
+            *err = "Invalid face indices in \"" + stream->filename + "\".";
+        ok = false;
+    }
+
+    return ok;
+}
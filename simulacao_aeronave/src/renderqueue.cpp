@@ -0,0 +1,254 @@
+// Fila de renderização ordenada por estado, com instanciação. Veja
+// "include/renderqueue.h".
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "renderqueue.h"
+#include "framering.h"
+#include "resources.h"
+
+// Dados de uma instância no buffer lido pelo vertex shader
+struct RenderInstance
+{
+    float   model[16]; // Matriz de modelagem, por colunas
+    int32_t material;
+    int32_t padding[3];
+};
+
+// Chave de ordenação e posição do pacote em g_RenderPackets. Ordenamos estes
+// pares, de 16 bytes, em vez dos pacotes.
+struct RenderQueueEntry
+{
+    uint64_t key;
+    uint32_t packet;
+
+    bool operator<(const RenderQueueEntry& other) const
+    {
+        return key < other.key || (key == other.key && packet < other.packet);
+    }
+};
+
+static GLuint                        g_RenderPrograms[RENDERQUEUE_MAX_PROGRAMS];
+static std::vector<RenderPacket>     g_RenderPackets;
+static std::vector<RenderQueueEntry> g_RenderEntries;
+static std::vector<RenderInstance>   g_RenderInstances;
+static RenderQueueStats              g_RenderQueueStats;
+
+// As instâncias são escritas no buffer circular do quadro (veja
+// "framering.h"). Se não houver espaço, ou se o buffer circular não tiver
+// sido criado, utilizamos estes: o buffer das instâncias de
+// RenderQueue_Flush(), que cresce conforme necessário, e o buffer da única
+// instância de RenderQueue_Draw().
+static GLuint g_InstanceBuffer = 0;
+static size_t g_InstanceBufferSize = 0;
+static GLuint g_ImmediateInstanceBuffer = 0;
+
+// Para floats não negativos, a ordem dos bits como inteiro é a mesma dos
+// valores; os 24 bits mais significativos bastam para ordenar por distância.
+static uint64_t DepthBits(float depth)
+{
+    if (!(depth > 0.0f))
+        return 0;
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits >> 8;
+}
+
+// Resumo de 16 bits da faixa de índices. Colisões apenas separam grupos que
+// poderiam ser desenhados juntos, pois RenderQueue_Flush() compara os
+// valores completos.
+static uint64_t RangeBits(const RenderPacket& packet)
+{
+    uint32_t hash = (uint32_t)(uintptr_t)packet.first_index * 2654435761u;
+    hash ^= (uint32_t)packet.num_indices * 40503u;
+    return hash >> 16;
+}
+
+static uint64_t RenderKey(const RenderPacket& packet, float depth)
+{
+    return ((uint64_t)(packet.program & 0xFF) << 56)
+         | ((uint64_t)(packet.vertex_array_object_id & 0xFFFF) << 40)
+         | (RangeBits(packet) << 24)
+         | DepthBits(depth);
+}
+
+static bool SameBatch(const RenderPacket& a, const RenderPacket& b)
+{
+    return a.program == b.program
+        && a.vertex_array_object_id == b.vertex_array_object_id
+        && a.rendering_mode == b.rendering_mode
+        && a.index_type == b.index_type
+        && a.first_index == b.first_index
+        && a.num_indices == b.num_indices;
+}
+
+static void MakeInstance(const RenderPacket& packet, RenderInstance* instance)
+{
+    memcpy(instance->model, &packet.model[0][0], sizeof(instance->model));
+    instance->material = packet.material;
+    instance->padding[0] = instance->padding[1] = instance->padding[2] = 0;
+}
+
+// Aponta os atributos por instância do VAO ligado para o buffer ligado em
+// GL_ARRAY_BUFFER, a partir da posição "base" (em bytes) mais a instância
+// "first".
+static void SetInstanceAttributes(size_t base, size_t first)
+{
+    const GLsizei stride = sizeof(RenderInstance);
+    const size_t  offset = base + first * sizeof(RenderInstance);
+
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        const GLuint location = RENDERQUEUE_INSTANCE_MODEL_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + column * 4 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glEnableVertexAttribArray(RENDERQUEUE_INSTANCE_MATERIAL_LOCATION);
+    glVertexAttribIPointer(RENDERQUEUE_INSTANCE_MATERIAL_LOCATION, 1, GL_INT, stride, (void*)(offset + 16 * sizeof(float)));
+    glVertexAttribDivisor(RENDERQUEUE_INSTANCE_MATERIAL_LOCATION, 1);
+}
+
+void RenderQueue_SetProgram(int program, GLuint program_id)
+{
+    if (program < 0 || program >= RENDERQUEUE_MAX_PROGRAMS)
+        return;
+    g_RenderPrograms[program] = program_id;
+}
+
+void RenderQueue_Submit(const RenderPacket& packet, float depth)
+{
+    RenderQueueEntry entry;
+    entry.key    = RenderKey(packet, depth);
+    entry.packet = (uint32_t)g_RenderPackets.size();
+    g_RenderEntries.push_back(entry);
+    g_RenderPackets.push_back(packet);
+}
+
+void RenderQueue_Flush()
+{
+    RenderQueueStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.packets = g_RenderEntries.size();
+
+    if (g_RenderEntries.empty())
+    {
+        g_RenderQueueStats = stats;
+        return;
+    }
+
+    std::sort(g_RenderEntries.begin(), g_RenderEntries.end());
+
+    // As instâncias são gravadas na ordem final, de modo que cada grupo
+    // ocupa uma faixa contígua do buffer.
+    const size_t bytes = g_RenderEntries.size() * sizeof(RenderInstance);
+    GLintptr base = 0;
+    RenderInstance* instances = (RenderInstance*)FrameRing_Allocate(bytes, 16, &base);
+    if (instances != NULL)
+    {
+        for (size_t i = 0; i < g_RenderEntries.size(); ++i)
+            MakeInstance(g_RenderPackets[g_RenderEntries[i].packet], &instances[i]);
+        FrameRing_Commit();
+        glBindBuffer(GL_ARRAY_BUFFER, FrameRing_Buffer());
+    }
+    else
+    {
+        g_RenderInstances.resize(g_RenderEntries.size());
+        for (size_t i = 0; i < g_RenderEntries.size(); ++i)
+            MakeInstance(g_RenderPackets[g_RenderEntries[i].packet], &g_RenderInstances[i]);
+
+        if (g_InstanceBuffer == 0)
+            g_InstanceBuffer = Resource_Create(RESOURCE_BUFFER, RESOURCE_STREAMING, "instâncias");
+
+        // O buffer é descartado (orphaning), para que a escrita não espere
+        // pelos desenhos do quadro anterior.
+        if (bytes > g_InstanceBufferSize)
+        {
+            g_InstanceBufferSize = std::max(bytes, 2 * g_InstanceBufferSize);
+            Resource_SetGpuBytes(RESOURCE_BUFFER, g_InstanceBuffer, g_InstanceBufferSize);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, g_InstanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, g_InstanceBufferSize, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &g_RenderInstances[0]);
+    }
+
+    // Os campos da chave são truncados, logo comparamos os valores completos
+    // para decidir se o estado precisa mudar.
+    int    program = -1;
+    GLuint vertex_array_object_id = 0;
+
+    size_t first = 0;
+    while (first < g_RenderEntries.size())
+    {
+        const RenderPacket& packet = g_RenderPackets[g_RenderEntries[first].packet];
+
+        size_t last = first + 1;
+        while (last < g_RenderEntries.size() && SameBatch(packet, g_RenderPackets[g_RenderEntries[last].packet]))
+            last += 1;
+
+        if (packet.program != program)
+        {
+            program = packet.program;
+            glUseProgram(g_RenderPrograms[program & 0xFF]);
+            stats.program_changes += 1;
+        }
+
+        if (packet.vertex_array_object_id != vertex_array_object_id)
+        {
+            vertex_array_object_id = packet.vertex_array_object_id;
+            glBindVertexArray(vertex_array_object_id);
+            stats.vao_changes += 1;
+        }
+
+        SetInstanceAttributes(base, first);
+        glDrawElementsInstanced(packet.rendering_mode, packet.num_indices, packet.index_type, packet.first_index, (GLsizei)(last - first));
+        stats.draw_calls += 1;
+
+        first = last;
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    g_RenderPackets.clear();
+    g_RenderEntries.clear();
+    g_RenderQueueStats = stats;
+}
+
+void RenderQueue_Draw(const RenderPacket& packet)
+{
+    GLintptr base = 0;
+    RenderInstance* instance = (RenderInstance*)FrameRing_Allocate(sizeof(RenderInstance), 16, &base);
+    if (instance != NULL)
+    {
+        MakeInstance(packet, instance);
+        FrameRing_Commit();
+        glBindBuffer(GL_ARRAY_BUFFER, FrameRing_Buffer());
+    }
+    else
+    {
+        if (g_ImmediateInstanceBuffer == 0)
+        {
+            g_ImmediateInstanceBuffer = Resource_Create(RESOURCE_BUFFER, RESOURCE_STREAMING, "instâncias");
+            Resource_SetGpuBytes(RESOURCE_BUFFER, g_ImmediateInstanceBuffer, sizeof(RenderInstance));
+        }
+
+        RenderInstance data;
+        MakeInstance(packet, &data);
+        glBindBuffer(GL_ARRAY_BUFFER, g_ImmediateInstanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(data), &data, GL_STREAM_DRAW);
+    }
+
+    glBindVertexArray(packet.vertex_array_object_id);
+    SetInstanceAttributes(base, 0);
+    glDrawElementsInstanced(packet.rendering_mode, packet.num_indices, packet.index_type, packet.first_index, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+const RenderQueueStats& RenderQueue_Stats()
+{
+    return g_RenderQueueStats;
+}
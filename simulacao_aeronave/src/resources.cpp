@@ -0,0 +1,317 @@
+// Gerenciador de recursos da OpenGL e contabilidade de memória. Veja
+// "include/resources.h".
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "resources.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+struct ResourceObject
+{
+    ResourceCategory category;
+    std::string      owner;
+    size_t           gpu_bytes;
+};
+
+struct ResourceTotals
+{
+    size_t gpu_bytes;
+    size_t cpu_bytes;
+    size_t peak_gpu_bytes;
+    size_t peak_cpu_bytes;
+    size_t objects;
+};
+
+struct ResourceOwner
+{
+    size_t gpu_bytes;
+    size_t cpu_bytes;
+    size_t objects;
+};
+
+static const char* const g_ResourceCategoryNames[RESOURCE_NUM_CATEGORIES] =
+{
+    "malhas", "texturas", "textura virtual", "alvos de renderização", "texto", "dados por quadro"
+};
+
+// Objetos indexados por (tipo << 32) | identificador, totais por categoria
+// (a última posição é a soma de todas) e por dono. A memória principal pode
+// ser informada pelas threads de trabalho, logo tudo é protegido por um mutex.
+static std::mutex                           g_ResourceMutex;
+static std::map<uint64_t, ResourceObject>   g_ResourceObjects;
+static ResourceTotals                       g_ResourceTotals[RESOURCE_NUM_CATEGORIES + 1];
+static std::map<std::string, ResourceOwner> g_ResourceOwners;
+
+static uint64_t ResourceKey(ResourceType type, GLuint id)
+{
+    return ((uint64_t)type << 32) | id;
+}
+
+// Soma "delta" bytes à memória da GPU ("gpu" = true) ou principal de uma
+// categoria e do total, atualizando os máximos.
+static void AddBytes(ResourceCategory category, bool gpu, ptrdiff_t delta)
+{
+    ResourceTotals* totals[2] = { &g_ResourceTotals[category], &g_ResourceTotals[RESOURCE_NUM_CATEGORIES] };
+    for (int i = 0; i < 2; ++i)
+    {
+        size_t& bytes = gpu ? totals[i]->gpu_bytes : totals[i]->cpu_bytes;
+        size_t& peak  = gpu ? totals[i]->peak_gpu_bytes : totals[i]->peak_cpu_bytes;
+        bytes = (delta < 0 && (size_t)(-delta) > bytes) ? 0 : bytes + delta;
+        peak  = std::max(peak, bytes);
+    }
+}
+
+static void DeleteObject(ResourceType type, GLuint id)
+{
+    switch (type)
+    {
+    case RESOURCE_BUFFER:       glDeleteBuffers(1, &id);       break;
+    case RESOURCE_TEXTURE:      glDeleteTextures(1, &id);      break;
+    case RESOURCE_VERTEX_ARRAY: glDeleteVertexArrays(1, &id);  break;
+    case RESOURCE_SAMPLER:      glDeleteSamplers(1, &id);      break;
+    case RESOURCE_FRAMEBUFFER:  glDeleteFramebuffers(1, &id);  break;
+    case RESOURCE_RENDERBUFFER: glDeleteRenderbuffers(1, &id); break;
+    default: break;
+    }
+}
+
+// Remove o objeto "it" do registro e da contabilidade. Deve ser chamada com o
+// mutex travado.
+static void UnregisterObject(std::map<uint64_t, ResourceObject>::iterator it)
+{
+    const ResourceObject& object = it->second;
+    AddBytes(object.category, true, -(ptrdiff_t)object.gpu_bytes);
+    g_ResourceTotals[object.category].objects -= 1;
+    g_ResourceTotals[RESOURCE_NUM_CATEGORIES].objects -= 1;
+
+    ResourceOwner& owner = g_ResourceOwners[object.owner];
+    owner.gpu_bytes -= object.gpu_bytes;
+    owner.objects   -= 1;
+
+    g_ResourceObjects.erase(it);
+}
+
+GLuint Resource_Create(ResourceType type, ResourceCategory category, const char* owner)
+{
+    GLuint id = 0;
+    switch (type)
+    {
+    case RESOURCE_BUFFER:       glGenBuffers(1, &id);       break;
+    case RESOURCE_TEXTURE:      glGenTextures(1, &id);      break;
+    case RESOURCE_VERTEX_ARRAY: glGenVertexArrays(1, &id);  break;
+    case RESOURCE_SAMPLER:      glGenSamplers(1, &id);      break;
+    case RESOURCE_FRAMEBUFFER:  glGenFramebuffers(1, &id);  break;
+    case RESOURCE_RENDERBUFFER: glGenRenderbuffers(1, &id); break;
+    default: return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+
+    ResourceObject object;
+    object.category  = category;
+    object.owner     = owner;
+    object.gpu_bytes = 0;
+    g_ResourceObjects[ResourceKey(type, id)] = object;
+
+    g_ResourceTotals[category].objects += 1;
+    g_ResourceTotals[RESOURCE_NUM_CATEGORIES].objects += 1;
+    g_ResourceOwners[owner].objects += 1;
+
+    return id;
+}
+
+void Resource_SetGpuBytes(ResourceType type, GLuint id, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+
+    std::map<uint64_t, ResourceObject>::iterator it = g_ResourceObjects.find(ResourceKey(type, id));
+    if (it == g_ResourceObjects.end())
+        return;
+
+    ResourceObject& object = it->second;
+    AddBytes(object.category, true, (ptrdiff_t)bytes - (ptrdiff_t)object.gpu_bytes);
+
+    ResourceOwner& owner = g_ResourceOwners[object.owner];
+    owner.gpu_bytes = owner.gpu_bytes - object.gpu_bytes + bytes;
+
+    object.gpu_bytes = bytes;
+}
+
+void Resource_Release(ResourceType type, GLuint id)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_ResourceMutex);
+        std::map<uint64_t, ResourceObject>::iterator it = g_ResourceObjects.find(ResourceKey(type, id));
+        if (it == g_ResourceObjects.end())
+            return;
+        UnregisterObject(it);
+    }
+
+    DeleteObject(type, id);
+}
+
+void Resource_ReleaseOwner(const char* owner)
+{
+    std::vector<uint64_t> keys;
+    {
+        std::lock_guard<std::mutex> lock(g_ResourceMutex);
+        std::map<uint64_t, ResourceObject>::iterator it = g_ResourceObjects.begin();
+        while (it != g_ResourceObjects.end())
+        {
+            std::map<uint64_t, ResourceObject>::iterator current = it++;
+            if (owner == NULL || current->second.owner == owner)
+            {
+                keys.push_back(current->first);
+                UnregisterObject(current);
+            }
+        }
+    }
+
+    // Os VAOs são destruídos antes dos buffers que referenciam
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            const ResourceType type = (ResourceType)(keys[i] >> 32);
+            if ((type == RESOURCE_VERTEX_ARRAY) == (pass == 0))
+                DeleteObject(type, (GLuint)(keys[i] & 0xFFFFFFFFu));
+        }
+    }
+}
+
+void Resource_ReleaseAll()
+{
+    Resource_ReleaseOwner(NULL);
+}
+
+void Resource_AddCpuBytes(ResourceCategory category, const char* owner, ptrdiff_t bytes)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+
+    AddBytes(category, false, bytes);
+
+    ResourceOwner& theowner = g_ResourceOwners[owner];
+    theowner.cpu_bytes = (bytes < 0 && (size_t)(-bytes) > theowner.cpu_bytes) ? 0 : theowner.cpu_bytes + bytes;
+}
+
+size_t Resource_GpuBytes(ResourceCategory category)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+    return g_ResourceTotals[category].gpu_bytes;
+}
+
+size_t Resource_CpuBytes(ResourceCategory category)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+    return g_ResourceTotals[category].cpu_bytes;
+}
+
+size_t Resource_PeakGpuBytes(ResourceCategory category)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+    return g_ResourceTotals[category].peak_gpu_bytes;
+}
+
+size_t Resource_PeakCpuBytes(ResourceCategory category)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+    return g_ResourceTotals[category].peak_cpu_bytes;
+}
+
+size_t Resource_NumObjects(ResourceCategory category)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+    return g_ResourceTotals[category].objects;
+}
+
+bool Resource_ProcessMemory(size_t* resident, size_t* peak_resident)
+{
+#if defined(_WIN32)
+    (void)resident;
+    (void)peak_resident;
+    return false;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return false;
+
+#if defined(__APPLE__)
+    *peak_resident = (size_t)usage.ru_maxrss; // Em bytes
+
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return false;
+    *resident = (size_t)info.resident_size;
+#else
+    *peak_resident = (size_t)usage.ru_maxrss * 1024; // Em kilobytes
+
+    // Segundo campo de /proc/self/statm: páginas residentes
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+        return false;
+    unsigned long size_pages = 0;
+    unsigned long resident_pages = 0;
+    int n = fscanf(statm, "%lu %lu", &size_pages, &resident_pages);
+    fclose(statm);
+    if (n != 2)
+        return false;
+    *resident = (size_t)resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    // ru_maxrss pode estar um pouco atrasado em relação à leitura atual
+    *peak_resident = std::max(*peak_resident, *resident);
+    return true;
+#endif
+}
+
+static double Megabytes(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+void Resource_PrintReport(FILE* out)
+{
+    std::lock_guard<std::mutex> lock(g_ResourceMutex);
+
+    fprintf(out, "Memória utilizada (MB):\n");
+    fprintf(out, "  %-24s %8s %10s %10s %10s %10s\n", "categoria", "objetos", "GPU", "GPU máx.", "CPU", "CPU máx.");
+    for (int category = 0; category <= RESOURCE_NUM_CATEGORIES; ++category)
+    {
+        const ResourceTotals& totals = g_ResourceTotals[category];
+        fprintf(out, "  %-24s %8d %10.2f %10.2f %10.2f %10.2f\n",
+                category < RESOURCE_NUM_CATEGORIES ? g_ResourceCategoryNames[category] : "total", (int)totals.objects,
+                Megabytes(totals.gpu_bytes), Megabytes(totals.peak_gpu_bytes),
+                Megabytes(totals.cpu_bytes), Megabytes(totals.peak_cpu_bytes));
+    }
+
+    // Donos em ordem decrescente de memória
+    std::vector< std::pair<size_t, std::string> > owners;
+    for (std::map<std::string, ResourceOwner>::const_iterator it = g_ResourceOwners.begin(); it != g_ResourceOwners.end(); ++it)
+    {
+        if (it->second.objects > 0 || it->second.cpu_bytes > 0)
+            owners.push_back(std::make_pair(it->second.gpu_bytes + it->second.cpu_bytes, it->first));
+    }
+    std::sort(owners.rbegin(), owners.rend());
+
+    fprintf(out, "  %-40s %8s %10s %10s\n", "dono", "objetos", "GPU", "CPU");
+    for (size_t i = 0; i < owners.size(); ++i)
+    {
+        const ResourceOwner& owner = g_ResourceOwners[owners[i].second];
+        fprintf(out, "  %-40s %8d %10.2f %10.2f\n", owners[i].second.c_str(), (int)owner.objects,
+                Megabytes(owner.gpu_bytes), Megabytes(owner.cpu_bytes));
+    }
+
+    size_t resident, peak_resident;
+    if (Resource_ProcessMemory(&resident, &peak_resident))
+        fprintf(out, "  Memória residente do processo: %.2f MB (máximo %.2f MB).\n", Megabytes(resident), Megabytes(peak_resident));
+}
@@ -0,0 +1,91 @@
+// Registro dos objetos da cena virtual. Veja "include/scene.h".
+#include <map>
+#include <string>
+
+#include "scene.h"
+
+// Dados quentes, frios e o dicionário de nomes, utilizado somente para obter
+// os identificadores.
+static std::vector<SceneObject>           g_SceneObjects;
+static std::vector<SceneObjectLod>        g_SceneLods;
+static std::vector<std::string>           g_SceneNames;
+static std::map<std::string, SceneHandle> g_SceneHandles;
+
+SceneHandle Scene_Handle(const char* name)
+{
+    std::map<std::string, SceneHandle>::iterator it = g_SceneHandles.find(name);
+    if (it != g_SceneHandles.end())
+        return it->second;
+
+    SceneObject object;
+    object.vertex_array_object_id = 0;
+    object.rendering_mode = GL_TRIANGLES;
+    object.index_type     = GL_UNSIGNED_INT;
+    object.num_indices    = 0;
+    object.first_index    = NULL;
+    object.first_lod      = 0;
+    object.num_lods       = 0;
+    object.bbox_min       = glm::vec3(0.0f);
+    object.bbox_max       = glm::vec3(0.0f);
+
+    const SceneHandle handle = (SceneHandle)g_SceneObjects.size();
+    g_SceneObjects.push_back(object);
+    g_SceneNames.push_back(name);
+    g_SceneHandles[name] = handle;
+    return handle;
+}
+
+SceneHandle Scene_Find(const char* name)
+{
+    std::map<std::string, SceneHandle>::iterator it = g_SceneHandles.find(name);
+    return (it != g_SceneHandles.end()) ? it->second : SCENE_INVALID_HANDLE;
+}
+
+void Scene_Set(SceneHandle handle, const SceneObject& object, const std::vector<SceneObjectLod>& lods)
+{
+    if (handle < 0 || handle >= (SceneHandle)g_SceneObjects.size())
+        return;
+
+    SceneObject& theobject = g_SceneObjects[handle];
+
+    // Reaproveitamos os níveis anteriores do objeto se couberem; caso
+    // contrário os novos são acrescentados ao final do vetor.
+    int first_lod = theobject.first_lod;
+    if ((int)lods.size() > theobject.num_lods)
+    {
+        first_lod = (int)g_SceneLods.size();
+        g_SceneLods.resize(g_SceneLods.size() + lods.size());
+    }
+    for (size_t lod = 0; lod < lods.size(); ++lod)
+        g_SceneLods[first_lod + lod] = lods[lod];
+
+    theobject = object;
+    theobject.first_lod = first_lod;
+    theobject.num_lods  = (int)lods.size();
+}
+
+const SceneObject* Scene_Get(SceneHandle handle)
+{
+    if (handle < 0 || handle >= (SceneHandle)g_SceneObjects.size())
+        return NULL;
+
+    const SceneObject& theobject = g_SceneObjects[handle];
+    return (theobject.vertex_array_object_id != 0) ? &theobject : NULL;
+}
+
+const SceneObjectLod* Scene_Lods(const SceneObject& object)
+{
+    return g_SceneLods.empty() ? NULL : &g_SceneLods[object.first_lod];
+}
+
+const char* Scene_Name(SceneHandle handle)
+{
+    if (handle < 0 || handle >= (SceneHandle)g_SceneNames.size())
+        return "";
+    return g_SceneNames[handle].c_str();
+}
+
+size_t Scene_NumObjects()
+{
+    return g_SceneObjects.size();
+}
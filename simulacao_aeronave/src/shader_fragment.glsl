@@ -14,10 +14,14 @@ in vec4 position_model;
 // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
 in vec2 texcoords;
 
-// Matrizes computadas no código C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Dados do quadro, comuns a todos os objetos (veja FrameUniforms
+// em "framering.h"), em um uniform buffer object com layout std140.
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position; // Posição da câmera no sistema global
+};
 
 // Identificador que define qual objeto está sendo desenhado no momento
 #define SPHERE 0
@@ -25,7 +29,7 @@ uniform mat4 projection;
 #define PLANE  2
 #define COW 3
 #define COWTWO 4
-uniform int object_id;
+flat in int object_id; // Por instância; veja "shader_vertex.glsl"
 
 // Parâmetros da axis-aligned bounding box (AABB) do modelo
 uniform vec4 bbox_min;
@@ -36,6 +40,23 @@ uniform sampler2D TextureImage0;
 uniform sampler2D TextureImage1;
 uniform sampler2D TextureImage2;
 
+// Textura virtual do plano (veja "vtexture.h" e UpdateVirtualTexture() em
+// "main.cpp"): cache físico de páginas e tabela de indireção, com a posição
+// no cache (R, G) e o nível (B) da página residente que cobre cada página.
+uniform sampler2D VirtualPages;
+uniform sampler2D VirtualIndirection;
+uniform bool  virtual_texture_enabled;
+uniform bool  virtual_texture_feedback;   // Passada de feedback: escreve a página necessária
+uniform vec2  virtual_texture_uv_scale;   // Fração do nível 0 ocupada pela imagem
+uniform float virtual_texture_pages;      // Páginas por lado no nível 0
+uniform float virtual_texture_levels;
+uniform float virtual_texture_cache_size; // Lado do cache físico, em texels
+uniform float virtual_texture_lod_bias;
+
+#define VTEX_PAGE_SIZE   128.0
+#define VTEX_PAGE_BORDER 4.0
+#define VTEX_PAGE_STRIDE 136.0
+
 // O valor de saída ("out") de um Fragment Shader é a cor final do fragmento.
 out vec3 color;
 
@@ -43,12 +64,44 @@ out vec3 color;
 #define M_PI   3.14159265358979323846
 #define M_PI_2 1.57079632679489661923
 
+// Nível da textura virtual necessário no ponto "vuv" (coordenadas no nível
+// 0), a partir das derivadas em relação à tela.
+float VirtualTextureLevel(vec2 vuv)
+{
+    vec2 texels = vuv * virtual_texture_pages * VTEX_PAGE_SIZE;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(dot(dx,dx), dot(dy,dy))) + virtual_texture_lod_bias;
+    return clamp(floor(lod), 0.0, virtual_texture_levels - 1.0);
+}
+
+// Amostra a textura virtual nas coordenadas de textura "uv" da imagem,
+// através da tabela de indireção.
+vec3 VirtualTextureSample(vec2 uv)
+{
+    vec2 vuv = clamp(uv, 0.0, 1.0) * virtual_texture_uv_scale;
+    vec4 entry = floor(textureLod(VirtualIndirection, vuv, VirtualTextureLevel(vuv)) * 255.0 + 0.5);
+    vec2 in_page = fract(vuv * virtual_texture_pages / exp2(entry.b));
+    vec2 texel = entry.rg * VTEX_PAGE_STRIDE + VTEX_PAGE_BORDER + in_page * VTEX_PAGE_SIZE;
+    return textureLod(VirtualPages, texel / virtual_texture_cache_size, 0.0).rgb;
+}
+
 void main()
 {
-    // Obtemos a posição da câmera utilizando a inversa da matriz que define o
-    // sistema de coordenadas da câmera.
-    vec4 origin = vec4(0.0, 0.0, 0.0, 1.0);
-    vec4 camera_position = inverse(view) * origin;
+    // Na passada de feedback escrevemos apenas a página (x, y, nível + 1)
+    // necessária neste fragmento. Veja RenderVirtualTextureFeedback().
+    if ( virtual_texture_feedback )
+    {
+        vec2 vuv = clamp(texcoords, 0.0, 1.0) * virtual_texture_uv_scale;
+        float level = VirtualTextureLevel(vuv);
+        float pages = virtual_texture_pages / exp2(level);
+        vec2 page = min(floor(vuv * pages), vec2(pages - 1.0));
+        color = vec3(page, level + 1.0) / 255.0;
+        return;
+    }
+
+    // A posição da câmera (camera_position) vem do bloco FrameUniforms,
+    // calculada uma única vez por quadro na CPU.
 
     // O fragmento atual é coberto por um ponto que percente à superfície de um
     // dos objetos virtuais da cena. Este ponto, p, possui uma posição no
@@ -156,7 +209,12 @@ void main()
     // preenchido
 
     // Obtemos a refletância difusa a partir da leitura da imagem TextureImage0
-    vec3 Kd0 = texture(TextureImage0, vec2(U,V)).rgb;
+    // (ou da textura virtual, no caso do plano)
+    vec3 Kd0;
+    if ( object_id == PLANE && virtual_texture_enabled )
+        Kd0 = VirtualTextureSample(vec2(U,V));
+    else
+        Kd0 = texture(TextureImage0, vec2(U,V)).rgb;
 
     // Obtemos a refletância difusa a partir da leitura da imagem TextureImage1
     vec3 Kd1 = texture(TextureImage1, vec2(U,V)).rgb;
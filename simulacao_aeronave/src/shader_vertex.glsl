@@ -1,15 +1,28 @@
 #version 330 core
 
 // Atributos de vrtice recebidos como entrada ("in") pelo Vertex Shader.
-// Veja a funo BuildTrianglesAndAddToVirtualScene() em "main.cpp".
-layout (location = 0) in vec4 model_coefficients;
+// Veja a funo BeginMeshUpload() em "main.cpp" e PackedVertex em
+// "meshdata.h": os atributos vm intercalados em um nico buffer, com a
+// posio em 3 floats, a normal em GL_INT_2_10_10_10_REV normalizado (j
+// convertida para [-1,1] pela GPU) e as coordenadas de textura em half floats.
+layout (location = 0) in vec3 position_coefficients;
 layout (location = 1) in vec4 normal_coefficients;
 layout (location = 2) in vec2 texture_coefficients;
 
-// Matrizes computadas no cdigo C++ e enviadas para a GPU
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Atributos de cada instncia do objeto (veja "renderqueue.h"): a matriz de
+// modelagem, uma coluna em cada localizao de 3 a 6, e o identificador do
+// objeto, repassado para o Fragment Shader.
+layout (location = 3) in mat4 instance_model;
+layout (location = 7) in int  instance_object_id;
+
+// Dados do quadro, comuns a todos os objetos (veja FrameUniforms
+// em "framering.h"), em um uniform buffer object com layout std140.
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec4 camera_position; // Posio da cmera no sistema global
+};
 
 // Identificador que define qual objeto est sendo desenhado no momento
 #define SPHERE 0
@@ -17,7 +30,7 @@ uniform mat4 projection;
 #define PLANE  2
 #define COW 3
 #define COWTWO 4
-uniform int object_id;
+flat out int object_id;
 
 // Atributos de vrtice que sero gerados como sada ("out") pelo Vertex Shader.
 // ** Estes sero interpolados pelo rasterizador! ** gerando, assim, valores
@@ -37,6 +50,12 @@ uniform sampler2D TextureImage2;
 
 void main()
 {
+    mat4 model = instance_model;
+    object_id = instance_object_id;
+
+    // Posio do vrtice em coordenadas homogneas (W = 1 para pontos)
+    vec4 model_coefficients = vec4(position_coefficients, 1.0);
+
     // A varivel gl_Position define a posio final de cada vrtice
     // OBRIGATORIAMENTE em "normalized device coordinates" (NDC), onde cada
     // coeficiente estar entre -1 e 1 aps diviso por w.
@@ -73,16 +92,14 @@ void main()
 
     // Normal do vrtice atual no sistema de coordenadas global (World).
     // Veja slide 107 do documento "Aula_07_Transformacoes_Geometricas_3D.pdf".
-    normal = inverse(transpose(model)) * normal_coefficients;
+    normal = inverse(transpose(model)) * vec4(normal_coefficients.xyz, 0.0);
     normal.w = 0.0;
 
     // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
     texcoords = texture_coefficients;
 
-        // Obtemos a posio da cmera utilizando a inversa da matriz que define o
-    // sistema de coordenadas da cmera.
-    vec4 origin = vec4(0.0, 0.0, 0.0, 1.0);
-    vec4 camera_position = inverse(view) * origin;
+    // A posio da cmera (camera_position) vem do bloco FrameUniforms,
+    // calculada uma nica vez por quadro na CPU.
 
     // O fragmento atual  coberto por um ponto que percente  superfcie de um
     // dos objetos virtuais da cena. Este ponto, p, possui uma posio no
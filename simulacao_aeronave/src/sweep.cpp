@@ -0,0 +1,164 @@
+// Detecção contínua de colisões dos tiros. Veja "include/sweep.h".
+#include "simdlane.h"
+#include "sweep.h"
+
+// Centro das esferas que completam o último lote. Não é tão grande quanto o
+// das caixas em "obb.cpp" para que os quadrados das distâncias não estourem.
+#define SWEEP_PADDING_CENTER 1e15f
+
+void MovingSphereSet_Clear(MovingSphereSet* set)
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        set->c[k].clear();
+        set->d[k].clear();
+    }
+    set->r.clear();
+    set->count = 0;
+}
+
+size_t MovingSphereSet_Add(MovingSphereSet* set, const glm::vec3& start, const glm::vec3& end, float radius)
+{
+    // Abrimos espaço para um lote inteiro de esferas distantes e paradas
+    if (set->count % LANE_WIDTH == 0)
+    {
+        const size_t size = set->count + LANE_WIDTH;
+        for (int k = 0; k < 3; ++k)
+        {
+            set->c[k].resize(size, SWEEP_PADDING_CENTER);
+            set->d[k].resize(size, 0.0f);
+        }
+        set->r.resize(size, 0.0f);
+    }
+
+    const size_t index = set->count;
+    for (int k = 0; k < 3; ++k)
+    {
+        set->c[k][index] = start[k];
+        set->d[k][index] = end[k] - start[k];
+    }
+    set->r[index] = radius;
+
+    set->count += 1;
+    return index;
+}
+
+void MovingObbSet_Clear(MovingObbSet* set)
+{
+    ObbSet_Clear(&set->boxes);
+    for (int k = 0; k < 3; ++k)
+        set->d[k].clear();
+}
+
+size_t MovingObbSet_Add(MovingObbSet* set, const Obb& start, const glm::vec3& end_center)
+{
+    const size_t index = ObbSet_Add(&set->boxes, start);
+
+    // Os deslocamentos acompanham o tamanho (já completado) das caixas
+    for (int k = 0; k < 3; ++k)
+    {
+        set->d[k].resize(set->boxes.c[k].size(), 0.0f);
+        set->d[k][index] = end_center[k] - start.center[k];
+    }
+    return index;
+}
+
+// Grava os instantes de impacto de um lote em "toi" e retorna quantos alvos
+// foram atingidos.
+static size_t StoreToi(Lane toi_batch, size_t first, size_t count, float* toi)
+{
+    float values[LANE_WIDTH];
+    LaneStore(values, toi_batch);
+
+    size_t hits = 0;
+    for (size_t i = 0; i < LANE_WIDTH && first + i < count; ++i)
+    {
+        toi[first + i] = values[i];
+        hits += (values[i] != SWEEP_NO_HIT);
+    }
+    return hits;
+}
+
+size_t Sweep_SphereVsSpheres(const glm::vec3& from, const glm::vec3& to, float radius, const MovingSphereSet& set, float* toi)
+{
+    const glm::vec3 motion = to - from;
+    const Lane zero   = LaneFalse();
+    const Lane one    = LaneSet(1.0f);
+    const Lane no_hit = LaneSet(SWEEP_NO_HIT);
+
+    size_t hits = 0;
+    for (size_t first = 0; first < set.count; first += LANE_WIDTH)
+    {
+        // Posição inicial "s" e deslocamento "v" do tiro relativos ao alvo:
+        // a distância entre os centros é |s + t*v|, e os dois se tocam
+        // quando |s + t*v| = R, ou a*t^2 + 2*b*t + c = 0.
+        Lane s[3], v[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            s[k] = LaneSub(LaneSet(from[k]), LaneLoad(&set.c[k][first]));
+            v[k] = LaneSub(LaneSet(motion[k]), LaneLoad(&set.d[k][first]));
+        }
+        const Lane R = LaneAdd(LaneSet(radius), LaneLoad(&set.r[first]));
+
+        const Lane a = LaneAdd(LaneAdd(LaneMul(v[0], v[0]), LaneMul(v[1], v[1])), LaneMul(v[2], v[2]));
+        const Lane b = LaneAdd(LaneAdd(LaneMul(s[0], v[0]), LaneMul(s[1], v[1])), LaneMul(s[2], v[2]));
+        const Lane c = LaneSub(LaneAdd(LaneAdd(LaneMul(s[0], s[0]), LaneMul(s[1], s[1])), LaneMul(s[2], s[2])), LaneMul(R, R));
+        const Lane discriminant = LaneSub(LaneMul(b, b), LaneMul(a, c));
+
+        // Primeira raiz; só vale se as esferas se aproximam (b < 0), o que
+        // também garante a > 0. As comparações com NaN são falsas.
+        const Lane t = LaneDiv(LaneSub(zero, LaneAdd(b, LaneSqrt(LaneMax(discriminant, zero)))), LaneMax(a, LaneSet(1e-30f)));
+        const Lane hit = LaneAnd(LaneAnd(LaneGreater(zero, b), LaneLessEqual(zero, discriminant)), LaneLessEqual(t, one));
+
+        Lane result = LaneSelect(hit, t, no_hit);
+        result = LaneSelect(LaneLessEqual(c, zero), zero, result); // Já se tocam
+        hits += StoreToi(result, first, set.count, toi);
+    }
+    return hits;
+}
+
+size_t Sweep_SphereVsObbs(const glm::vec3& from, const glm::vec3& to, float radius, const MovingObbSet& set, float* toi)
+{
+    const ObbSet& boxes = set.boxes;
+    const glm::vec3 motion = to - from;
+    const Lane zero   = LaneFalse();
+    const Lane one    = LaneSet(1.0f);
+    const Lane no_hit = LaneSet(SWEEP_NO_HIT);
+    const Lane lane_radius = LaneSet(radius);
+
+    size_t hits = 0;
+    for (size_t first = 0; first < boxes.count; first += LANE_WIDTH)
+    {
+        Lane s[3], v[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            s[k] = LaneSub(LaneSet(from[k]), LaneLoad(&boxes.c[k][first]));
+            v[k] = LaneSub(LaneSet(motion[k]), LaneLoad(&set.d[k][first]));
+        }
+
+        // Em cada eixo j da caixa, o intervalo de t em que o centro do tiro
+        // está entre os planos a +-(e[j] + raio) do centro. Com a velocidade
+        // nula no eixo a divisão dá +-infinito, e o intervalo é ou toda a
+        // reta ou vazio.
+        Lane t_enter = zero;
+        Lane t_exit  = one;
+        for (int j = 0; j < 3; ++j)
+        {
+            const Lane u0 = LaneLoad(&boxes.u[3*j + 0][first]);
+            const Lane u1 = LaneLoad(&boxes.u[3*j + 1][first]);
+            const Lane u2 = LaneLoad(&boxes.u[3*j + 2][first]);
+            const Lane p = LaneAdd(LaneAdd(LaneMul(s[0], u0), LaneMul(s[1], u1)), LaneMul(s[2], u2));
+            const Lane w = LaneAdd(LaneAdd(LaneMul(v[0], u0), LaneMul(v[1], u1)), LaneMul(v[2], u2));
+            const Lane extent = LaneAdd(LaneLoad(&boxes.e[j][first]), lane_radius);
+
+            const Lane t0 = LaneDiv(LaneSub(LaneSub(zero, extent), p), w);
+            const Lane t1 = LaneDiv(LaneSub(extent, p), w);
+            t_enter = LaneMax(t_enter, LaneMin(t0, t1));
+            t_exit  = LaneMin(t_exit, LaneMax(t0, t1));
+        }
+
+        const Lane hit = LaneLessEqual(t_enter, t_exit);
+        hits += StoreToi(LaneSelect(hit, t_enter, no_hit), first, boxes.count, toi);
+    }
+    return hits;
+}
@@ -0,0 +1,551 @@
+// Compressão de texturas em BC1/BC3. Veja "include/texcompress.h".
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "texcompress.h"
+
+// Linhas de blocos por thread abaixo das quais não vale a pena paralelizar
+#define TEXCOMPRESS_MIN_ROWS_PER_THREAD 4
+
+static uint16_t PackRGB565(const float* color)
+{
+    int r = (int)(std::max(0.0f, std::min(255.0f, color[0])) * 31.0f / 255.0f + 0.5f);
+    int g = (int)(std::max(0.0f, std::min(255.0f, color[1])) * 63.0f / 255.0f + 0.5f);
+    int b = (int)(std::max(0.0f, std::min(255.0f, color[2])) * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// Expande RGB565 para 8 bits por canal, replicando os bits mais significativos
+static void UnpackRGB565(uint16_t packed, int* color)
+{
+    const int r = (packed >> 11) & 31;
+    const int g = (packed >> 5) & 63;
+    const int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Paleta de um bloco de cor: modo de 4 cores se c0 > c1 (ou sempre, nos
+// blocos BC3), ou 3 cores e preto (transparente em BC1) caso contrário.
+static void ColorPalette(uint16_t c0, uint16_t c1, bool four_colors, int palette[4][3])
+{
+    UnpackRGB565(c0, palette[0]);
+    UnpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if (four_colors || c0 > c1)
+        {
+            palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// Escolhe o índice mais próximo de cada pixel, retornando o erro quadrático
+// total do bloco.
+static float ChooseColorIndices(const float block[16][3], const int palette[4][3], uint32_t* indices)
+{
+    float total = 0.0f;
+    *indices = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        float best = std::numeric_limits<float>::max();
+        uint32_t best_index = 0;
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            const float dr = block[i][0] - palette[k][0];
+            const float dg = block[i][1] - palette[k][1];
+            const float db = block[i][2] - palette[k][2];
+            const float error = dr*dr + dg*dg + db*db;
+            if (error < best)
+            {
+                best = error;
+                best_index = k;
+            }
+        }
+        *indices |= best_index << (2*i);
+        total += best;
+    }
+    return total;
+}
+
+// Quantiza as cores de referência e escreve o bloco BC1 em "out". Retorna o
+// erro quadrático do bloco.
+static float EmitColorBlock(const float block[16][3], const float* endpoint0, const float* endpoint1, unsigned char* out)
+{
+    uint16_t c0 = PackRGB565(endpoint0);
+    uint16_t c1 = PackRGB565(endpoint1);
+
+    // No modo de 4 cores c0 deve ser maior que c1; se forem iguais, o bloco
+    // tem uma única cor e todos os índices são 0.
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    int palette[4][3];
+    ColorPalette(c0, c1, true, palette);
+
+    uint32_t indices = 0;
+    float error;
+    if (c0 == c1)
+    {
+        error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 3; ++c)
+                error += (block[i][c] - palette[0][c]) * (block[i][c] - palette[0][c]);
+    }
+    else
+    {
+        error = ChooseColorIndices(block, palette, &indices);
+    }
+
+    out[0] = (unsigned char)(c0 & 0xFF);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xFF);
+    out[3] = (unsigned char)(c1 >> 8);
+    for (int b = 0; b < 4; ++b)
+        out[4 + b] = (unsigned char)((indices >> (8*b)) & 0xFF);
+
+    return error;
+}
+
+// Recalcula as cores de referência por mínimos quadrados, dados os índices
+// escolhidos para cada pixel. Retorna false se o sistema for degenerado.
+static bool RefineEndpoints(const float block[16][3], const unsigned char* encoded, float* endpoint0, float* endpoint1)
+{
+    // Peso da referência 0 para cada índice no modo de 4 cores
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+
+    uint32_t indices = encoded[4] | (encoded[5] << 8) | (encoded[6] << 16) | ((uint32_t)encoded[7] << 24);
+
+    float a2 = 0.0f, b2 = 0.0f, ab = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        const float a = weights[(indices >> (2*i)) & 3];
+        const float b = 1.0f - a;
+        a2 += a*a;
+        b2 += b*b;
+        ab += a*b;
+        for (int c = 0; c < 3; ++c)
+        {
+            ax[c] += a * block[i][c];
+            bx[c] += b * block[i][c];
+        }
+    }
+
+    const float determinant = a2*b2 - ab*ab;
+    if (fabsf(determinant) < 1e-6f)
+        return false;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        endpoint0[c] = (b2*ax[c] - ab*bx[c]) / determinant;
+        endpoint1[c] = (a2*bx[c] - ab*ax[c]) / determinant;
+    }
+    return true;
+}
+
+// Comprime um bloco de 16 cores (0-255) em BC1
+static void EncodeColorBlock(const float block[16][3], int quality, unsigned char* out)
+{
+    float endpoint0[3];
+    float endpoint1[3];
+
+    if (quality == TEXCOMPRESS_QUALITY_FAST)
+    {
+        // Cantos da bounding box das cores, levemente contraídos para dentro
+        float low[3]  = { 255.0f, 255.0f, 255.0f };
+        float high[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                low[c]  = std::min(low[c], block[i][c]);
+                high[c] = std::max(high[c], block[i][c]);
+            }
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            const float inset = (high[c] - low[c]) / 16.0f;
+            endpoint0[c] = high[c] - inset;
+            endpoint1[c] = low[c] + inset;
+        }
+        EmitColorBlock(block, endpoint0, endpoint1, out);
+        return;
+    }
+
+    // Eixo principal da distribuição das cores (maior autovetor da matriz de
+    // covariância, por iteração de potência). As referências são os extremos
+    // das projeções das cores sobre esse eixo.
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += block[i][c] / 16.0f;
+
+    float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr, rg, rb, gg, gb, bb
+    for (int i = 0; i < 16; ++i)
+    {
+        const float r = block[i][0] - mean[0];
+        const float g = block[i][1] - mean[1];
+        const float b = block[i][2] - mean[2];
+        covariance[0] += r*r; covariance[1] += r*g; covariance[2] += r*b;
+        covariance[3] += g*g; covariance[4] += g*b; covariance[5] += b*b;
+    }
+
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float x = covariance[0]*axis[0] + covariance[1]*axis[1] + covariance[2]*axis[2];
+        float y = covariance[1]*axis[0] + covariance[3]*axis[1] + covariance[4]*axis[2];
+        float z = covariance[2]*axis[0] + covariance[4]*axis[1] + covariance[5]*axis[2];
+        const float length = std::max(fabsf(x), std::max(fabsf(y), fabsf(z)));
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float min_projection = std::numeric_limits<float>::max();
+    float max_projection = -std::numeric_limits<float>::max();
+    const float axis_length2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    for (int i = 0; i < 16; ++i)
+    {
+        const float projection = ((block[i][0] - mean[0])*axis[0]
+                                + (block[i][1] - mean[1])*axis[1]
+                                + (block[i][2] - mean[2])*axis[2]) / axis_length2;
+        min_projection = std::min(min_projection, projection);
+        max_projection = std::max(max_projection, projection);
+    }
+    for (int c = 0; c < 3; ++c)
+    {
+        endpoint0[c] = mean[c] + max_projection * axis[c];
+        endpoint1[c] = mean[c] + min_projection * axis[c];
+    }
+
+    float best_error = EmitColorBlock(block, endpoint0, endpoint1, out);
+
+    // Refinamentos: com os índices fixos, as referências ótimas são a
+    // solução de mínimos quadrados; mantemos o melhor bloco encontrado.
+    const int refinements = (quality == TEXCOMPRESS_QUALITY_BEST) ? 8 : 1;
+    unsigned char candidate[8];
+    memcpy(candidate, out, sizeof(candidate));
+    for (int iteration = 0; iteration < refinements && best_error > 0.0f; ++iteration)
+    {
+        if (!RefineEndpoints(block, candidate, endpoint0, endpoint1))
+            break;
+
+        const float error = EmitColorBlock(block, endpoint0, endpoint1, candidate);
+        if (error >= best_error)
+            break;
+
+        best_error = error;
+        memcpy(out, candidate, sizeof(candidate));
+    }
+}
+
+// Valores do bloco de alpha: 8 valores interpolados se a0 > a1, ou 6
+// interpolados mais 0 e 255 caso contrário.
+static void AlphaPalette(int a0, int a1, int palette[8])
+{
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1)
+    {
+        for (int k = 1; k < 7; ++k)
+            palette[1 + k] = ((7 - k)*a0 + k*a1) / 7;
+    }
+    else
+    {
+        for (int k = 1; k < 5; ++k)
+            palette[1 + k] = ((5 - k)*a0 + k*a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Escreve o bloco de alpha com as referências dadas em "out", retornando o
+// erro quadrático.
+static int EmitAlphaBlock(const int alpha[16], int a0, int a1, unsigned char* out)
+{
+    int palette[8];
+    AlphaPalette(a0, a1, palette);
+
+    uint64_t indices = 0;
+    int total = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 1 << 30;
+        int best_index = 0;
+        for (int k = 0; k < 8; ++k)
+        {
+            const int error = (alpha[i] - palette[k]) * (alpha[i] - palette[k]);
+            if (error < best)
+            {
+                best = error;
+                best_index = k;
+            }
+        }
+        indices |= (uint64_t)best_index << (3*i);
+        total += best;
+    }
+
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    for (int b = 0; b < 6; ++b)
+        out[2 + b] = (unsigned char)((indices >> (8*b)) & 0xFF);
+
+    return total;
+}
+
+static void EncodeAlphaBlock(const int alpha[16], int quality, unsigned char* out)
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        low  = std::min(low, alpha[i]);
+        high = std::max(high, alpha[i]);
+    }
+
+    // Modo de 8 valores entre os extremos
+    int error = EmitAlphaBlock(alpha, high, low, out);
+
+    // Modo de 6 valores, com 0 e 255 exatos: bom para blocos com pixels
+    // totalmente transparentes ou opacos e o resto intermediário.
+    if (quality == TEXCOMPRESS_QUALITY_BEST && error > 0)
+    {
+        int inner_low = 255, inner_high = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (alpha[i] != 0 && alpha[i] != 255)
+            {
+                inner_low  = std::min(inner_low, alpha[i]);
+                inner_high = std::max(inner_high, alpha[i]);
+            }
+        }
+        if (inner_low > inner_high)
+            inner_low = inner_high = 0;
+
+        unsigned char candidate[8];
+        if (EmitAlphaBlock(alpha, inner_low, inner_high, candidate) < error)
+            memcpy(out, candidate, sizeof(candidate));
+    }
+}
+
+// Lê o bloco de 4x4 pixels na posição (bx, by), repetindo os pixels da borda
+// quando o bloco passa dos limites do nível.
+static void GatherBlock(const unsigned char* pixels, int channels, int width, int height, int bx, int by,
+                        float colors[16][3], int alpha[16])
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        const int py = std::min(4*by + y, height - 1);
+        for (int x = 0; x < 4; ++x)
+        {
+            const int px = std::min(4*bx + x, width - 1);
+            const unsigned char* p = &pixels[channels*((size_t)py*width + px)];
+            for (int c = 0; c < 3; ++c)
+                colors[4*y + x][c] = p[c];
+            alpha[4*y + x] = (channels == 4) ? p[3] : 255;
+        }
+    }
+}
+
+struct EncodeJob
+{
+    const unsigned char* pixels;
+    int                  channels;
+    int                  width;
+    int                  height;
+    int                  quality;
+    bool                 with_alpha; // BC3 em vez de BC1
+    unsigned char*       out;
+};
+
+static void EncodeRows(const EncodeJob& job, int first_row, int last_row)
+{
+    const int blocks_x = (job.width + 3) / 4;
+    const size_t block_size = job.with_alpha ? 16 : 8;
+
+    float colors[16][3];
+    int   alpha[16];
+    for (int by = first_row; by < last_row; ++by)
+    {
+        for (int bx = 0; bx < blocks_x; ++bx)
+        {
+            unsigned char* out = job.out + ((size_t)by*blocks_x + bx) * block_size;
+            GatherBlock(job.pixels, job.channels, job.width, job.height, bx, by, colors, alpha);
+            if (job.with_alpha)
+            {
+                EncodeAlphaBlock(alpha, job.quality, out);
+                out += 8;
+            }
+            EncodeColorBlock(colors, job.quality, out);
+        }
+    }
+}
+
+// Divide as linhas de blocos do nível entre threads
+static void EncodeParallel(const EncodeJob& job)
+{
+    const int blocks_y = (job.height + 3) / 4;
+
+    int num_threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::max(1, std::min(num_threads, blocks_y / TEXCOMPRESS_MIN_ROWS_PER_THREAD));
+
+    if (num_threads == 1)
+    {
+        EncodeRows(job, 0, blocks_y);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        const int first_row = (int)((int64_t)blocks_y * t / num_threads);
+        const int last_row  = (int)((int64_t)blocks_y * (t + 1) / num_threads);
+        workers.push_back(std::thread(EncodeRows, std::cref(job), first_row, last_row));
+    }
+    for (size_t t = 0; t < workers.size(); ++t)
+        workers[t].join();
+}
+
+void TexCompress_EncodeBC1(const unsigned char* pixels, int channels, int width, int height, int quality, unsigned char* out)
+{
+    EncodeJob job = { pixels, channels, width, height, quality, false, out };
+    EncodeParallel(job);
+}
+
+void TexCompress_EncodeBC3(const unsigned char* rgba, int width, int height, int quality, unsigned char* out)
+{
+    EncodeJob job = { rgba, 4, width, height, quality, true, out };
+    EncodeParallel(job);
+}
+
+void TexCompress_Decode(uint32_t format, const unsigned char* blocks, int width, int height, unsigned char* rgba)
+{
+    const bool with_alpha = (format == TEXTURE_FORMAT_BC3);
+    const size_t block_size = with_alpha ? 16 : 8;
+    const int blocks_x = (width + 3) / 4;
+    const int blocks_y = (height + 3) / 4;
+
+    for (int by = 0; by < blocks_y; ++by)
+    {
+        for (int bx = 0; bx < blocks_x; ++bx)
+        {
+            const unsigned char* block = blocks + ((size_t)by*blocks_x + bx) * block_size;
+
+            int alpha_palette[8];
+            uint64_t alpha_indices = 0;
+            if (with_alpha)
+            {
+                AlphaPalette(block[0], block[1], alpha_palette);
+                for (int b = 0; b < 6; ++b)
+                    alpha_indices |= (uint64_t)block[2 + b] << (8*b);
+                block += 8;
+            }
+
+            const uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+            const uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+            const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+            // Nos blocos BC3 a cor é sempre decodificada no modo de 4 cores
+            int palette[4][3];
+            ColorPalette(c0, c1, with_alpha, palette);
+
+            for (int i = 0; i < 16; ++i)
+            {
+                const int px = 4*bx + i % 4;
+                const int py = 4*by + i / 4;
+                if (px >= width || py >= height)
+                    continue;
+
+                unsigned char* p = &rgba[4*((size_t)py*width + px)];
+                const uint32_t index = (indices >> (2*i)) & 3;
+                p[0] = (unsigned char)palette[index][0];
+                p[1] = (unsigned char)palette[index][1];
+                p[2] = (unsigned char)palette[index][2];
+                if (with_alpha)
+                    p[3] = (unsigned char)alpha_palette[(alpha_indices >> (3*i)) & 7];
+                else
+                    p[3] = (c0 <= c1 && index == 3) ? 0 : 255;
+            }
+        }
+    }
+}
+
+float TexCompress_PSNR(const TextureLevel& original, uint32_t original_format,
+                       const TextureLevel& compressed, uint32_t compressed_format)
+{
+    const int width  = original.width;
+    const int height = original.height;
+    const int channels = (original_format == TEXTURE_FORMAT_RGBA8) ? 4 : 3;
+
+    std::vector<unsigned char> decoded(4 * (size_t)width * height);
+    TexCompress_Decode(compressed_format, compressed.data, width, height, decoded.data());
+
+    double sum = 0.0;
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const double difference = (double)original.data[channels*i + c] - decoded[4*i + c];
+            sum += difference * difference;
+        }
+    }
+
+    const double mse = sum / (3.0 * width * height);
+    if (mse == 0.0)
+        return std::numeric_limits<float>::infinity();
+    return (float)(10.0 * log10(255.0 * 255.0 / mse));
+}
+
+float TexCompress_CompressTexture(TextureData* texture, int quality)
+{
+    const bool with_alpha = (texture->format == TEXTURE_FORMAT_RGBA8);
+    const uint32_t format = with_alpha ? TEXTURE_FORMAT_BC3 : TEXTURE_FORMAT_BC1;
+    const int channels = with_alpha ? 4 : 3;
+
+    std::vector<TextureLevel> levels(texture->levels);
+    size_t total = 0;
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        levels[l].size = TextureCache_LevelSize(format, levels[l].width, levels[l].height);
+        total += levels[l].size;
+    }
+
+    std::vector<unsigned char> storage(total);
+    size_t offset = 0;
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        const TextureLevel& source = texture->levels[l];
+        unsigned char* out = storage.data() + offset;
+        if (with_alpha)
+            TexCompress_EncodeBC3(source.data, source.width, source.height, quality, out);
+        else
+            TexCompress_EncodeBC1(source.data, channels, source.width, source.height, quality, out);
+
+        levels[l].data = out;
+        offset += levels[l].size;
+    }
+
+    float psnr = levels.empty() ? 0.0f : TexCompress_PSNR(texture->levels[0], texture->format, levels[0], format);
+
+    MappedFile_Close(&texture->mapping);
+    texture->storage.swap(storage);
+    texture->levels.swap(levels);
+    texture->format = format;
+
+    return psnr;
+}
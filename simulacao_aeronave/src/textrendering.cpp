@@ -1,6 +1,8 @@
 // Based on http://hamelot.io/visualization/opengl-text-without-any-external-libraries/
 //   and on https://github.com/rougier/freetype-gl
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -10,6 +12,8 @@
 
 #include "utils.h"
 #include "dejavufont.h"
+#include "resources.h"
+#include "framering.h"
 
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Função definida em main.cpp
 
@@ -89,12 +93,10 @@ GLuint texttexture_id;
 
 void TextRendering_Init()
 {
-    GLuint sampler;
-
-    glGenBuffers(1, &textVBO);
-    glGenVertexArrays(1, &textVAO);
-    glGenTextures(1, &texttexture_id);
-    glGenSamplers(1, &sampler);
+    textVBO = Resource_Create(RESOURCE_BUFFER, RESOURCE_TEXT, "texto");
+    textVAO = Resource_Create(RESOURCE_VERTEX_ARRAY, RESOURCE_TEXT, "texto");
+    texttexture_id = Resource_Create(RESOURCE_TEXTURE, RESOURCE_TEXT, "texto");
+    GLuint sampler = Resource_Create(RESOURCE_SAMPLER, RESOURCE_TEXT, "texto");
     glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -122,12 +124,12 @@ void TextRendering_Init()
     glBindTexture(GL_TEXTURE_2D, texttexture_id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, dejavufont.tex_width, dejavufont.tex_height, 0, GL_RED, GL_UNSIGNED_BYTE, dejavufont.tex_data);
     glBindSampler(textureunit, sampler);
+    Resource_SetGpuBytes(RESOURCE_TEXTURE, texttexture_id, (size_t)dejavufont.tex_width * dejavufont.tex_height);
     glCheckError();
 
     glBindVertexArray(textVAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
     glCheckError();
@@ -152,6 +154,13 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
     float sx = scale / width;
     float sy = scale / height;
 
+    // Os vértices de todos os glifos são gerados primeiro e desenhados com uma
+    // única chamada, a partir do buffer circular do quadro (veja
+    // "framering.h").
+    struct TextVertex {float x, y, s, t;};
+    static std::vector<TextVertex> vertices;
+    vertices.clear();
+
     for (size_t i = 0; i < str.size(); i++)
     {
         // Find the glyph for the character we are looking for
@@ -178,7 +187,7 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
         float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
         float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
 
-        struct {float x, y, s, t;} data[6] = {
+        TextVertex data[6] = {
             { x0, y0, s0, t0 },
             { x0, y1, s0, t1 },
             { x1, y1, s1, t1 },
@@ -186,29 +195,52 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
             { x1, y1, s1, t1 },
             { x1, y0, s1, t0 }
         };
+        vertices.insert(vertices.end(), data, data + 6);
+
+        x += (glyph->advance_x * sx);
+    }
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (vertices.empty())
+        return;
 
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDepthFunc(GL_ALWAYS);
+    const size_t bytes = vertices.size() * sizeof(TextVertex);
+    GLintptr offset = 0;
+    void* mapped = FrameRing_Allocate(bytes, sizeof(TextVertex), &offset);
+    if (mapped != NULL)
+    {
+        memcpy(mapped, &vertices[0], bytes);
+        FrameRing_Commit();
+    }
+
+    glBindVertexArray(textVAO);
+    if (mapped != NULL)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, FrameRing_Buffer());
+    }
+    else
+    {
+        // Sem espaço no buffer circular: buffer próprio, descartado a cada string
         glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, 24 * sizeof(float), data);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBufferData(GL_ARRAY_BUFFER, bytes, &vertices[0], GL_STREAM_DRAW);
+        Resource_SetGpuBytes(RESOURCE_BUFFER, textVBO, bytes);
+    }
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (void*)offset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glUseProgram(textprogram_id);
-        glBindVertexArray(textVAO);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glDepthFunc(GL_LESS);
+    glUseProgram(textprogram_id);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
 
-        glDisable(GL_BLEND);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
 
-        x += (glyph->advance_x * sx);
-    }
+    glDisable(GL_BLEND);
 }
 
 float TextRendering_LineHeight(GLFWwindow* window)
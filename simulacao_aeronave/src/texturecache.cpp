@@ -0,0 +1,325 @@
+// Cadeia de mipmaps e cache binário de texturas. Veja "include/texturecache.h".
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "texturecache.h"
+
+static const char TEXTURECACHE_MAGIC[8] = { 'F','C','G','T','E','X','\0','\0' };
+
+struct TextureCacheHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t format;
+    uint32_t num_levels;
+    uint32_t reserved;
+    uint64_t source_size;
+    int64_t  source_mtime;
+    uint32_t width;
+    uint32_t height;
+    uint64_t levels_offset;
+    uint64_t file_size;
+};
+
+struct TextureCacheLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset; // Relativo ao início do arquivo
+    uint64_t size;
+};
+
+size_t TextureCache_LevelSize(uint32_t format, int width, int height)
+{
+    const size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    switch (format)
+    {
+    case TEXTURE_FORMAT_RGB8:  return 3 * (size_t)width * height;
+    case TEXTURE_FORMAT_RGBA8: return 4 * (size_t)width * height;
+    case TEXTURE_FORMAT_BC1:   return 8 * blocks;
+    case TEXTURE_FORMAT_BC3:   return 16 * blocks;
+    }
+    return 0;
+}
+
+// Conversões entre sRGB (8 bits) e intensidade linear
+static float SrgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static unsigned char LinearToSrgb8(float c)
+{
+    c = std::max(0.0f, std::min(1.0f, c));
+    float s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+    return (unsigned char)(s * 255.0f + 0.5f);
+}
+
+// Reduz um nível para o seguinte. Em uma dimensão par cada pixel do destino é
+// a média de dois pixels da origem; em uma dimensão ímpar (2n+1 -> n) cada
+// pixel cobre três pixels da origem, com pesos proporcionais à área coberta
+// (filtro de caixa polifásico), de forma que todos os pixels contribuem.
+// "linear" contém os canais da origem em espaço linear.
+static void Downsample(const TextureLevel& source, const float* linear, int channels, TextureLevel* destination, unsigned char* out)
+{
+    const int sw = source.width;
+    const int sh = source.height;
+    const int dw = destination->width;
+    const int dh = destination->height;
+
+    for (int y = 0; y < dh; ++y)
+    {
+        int   y_taps[3];
+        float y_weights[3];
+        int   num_y = 0;
+        if (sh == 1)
+        {
+            y_taps[0] = 0; y_weights[0] = 1.0f; num_y = 1;
+        }
+        else if (sh % 2 == 0)
+        {
+            y_taps[0] = 2*y; y_taps[1] = 2*y + 1;
+            y_weights[0] = y_weights[1] = 0.5f; num_y = 2;
+        }
+        else
+        {
+            const float w0 = (float)(dh - y) / (float)sh;
+            const float w1 = (float)dh / (float)sh;
+            const float w2 = (float)(y + 1) / (float)sh;
+            y_taps[0] = 2*y; y_taps[1] = 2*y + 1; y_taps[2] = 2*y + 2;
+            y_weights[0] = w0; y_weights[1] = w1; y_weights[2] = w2; num_y = 3;
+        }
+
+        for (int x = 0; x < dw; ++x)
+        {
+            int   x_taps[3];
+            float x_weights[3];
+            int   num_x = 0;
+            if (sw == 1)
+            {
+                x_taps[0] = 0; x_weights[0] = 1.0f; num_x = 1;
+            }
+            else if (sw % 2 == 0)
+            {
+                x_taps[0] = 2*x; x_taps[1] = 2*x + 1;
+                x_weights[0] = x_weights[1] = 0.5f; num_x = 2;
+            }
+            else
+            {
+                const float w0 = (float)(dw - x) / (float)sw;
+                const float w1 = (float)dw / (float)sw;
+                const float w2 = (float)(x + 1) / (float)sw;
+                x_taps[0] = 2*x; x_taps[1] = 2*x + 1; x_taps[2] = 2*x + 2;
+                x_weights[0] = w0; x_weights[1] = w1; x_weights[2] = w2; num_x = 3;
+            }
+
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int j = 0; j < num_y; ++j)
+            {
+                for (int i = 0; i < num_x; ++i)
+                {
+                    const float w = y_weights[j] * x_weights[i];
+                    const float* p = &linear[channels*((size_t)y_taps[j]*sw + x_taps[i])];
+                    for (int c = 0; c < channels; ++c)
+                        sum[c] += w * p[c];
+                }
+            }
+
+            unsigned char* q = &out[channels*((size_t)y*dw + x)];
+            for (int c = 0; c < 3; ++c)
+                q[c] = LinearToSrgb8(sum[c]);
+            if (channels == 4)
+                q[3] = (unsigned char)(std::max(0.0f, std::min(1.0f, sum[3])) * 255.0f + 0.5f);
+        }
+    }
+}
+
+void TextureCache_BuildMipmaps(const unsigned char* pixels, int width, int height, int channels, TextureData* texture)
+{
+    const uint32_t format = (channels == 4) ? TEXTURE_FORMAT_RGBA8 : TEXTURE_FORMAT_RGB8;
+
+    // Dimensões e posições de todos os níveis, para alocar "storage" de uma vez
+    std::vector<TextureLevel> levels;
+    size_t total = 0;
+    int w = width, h = height;
+    for (;;)
+    {
+        TextureLevel level;
+        level.width  = w;
+        level.height = h;
+        level.data   = NULL;
+        level.size   = TextureCache_LevelSize(format, w, h);
+        levels.push_back(level);
+        total += level.size;
+
+        if ((w == 1 && h == 1) || levels.size() == TEXTURE_MAX_LEVELS)
+            break;
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+
+    std::vector<unsigned char> storage(total);
+    memcpy(storage.data(), pixels, levels[0].size);
+
+    // Tabelas de conversão para espaço linear: cores em sRGB, alpha já linear
+    float srgb_to_linear[256];
+    float alpha_to_linear[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        srgb_to_linear[i] = SrgbToLinear(i / 255.0f);
+        alpha_to_linear[i] = i / 255.0f;
+    }
+
+    std::vector<float> linear;
+    size_t offset = 0;
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        if (l > 0)
+        {
+            // Cada nível é gerado a partir do anterior em espaço linear
+            const TextureLevel& previous = levels[l - 1];
+            const unsigned char* source = storage.data() + offset - previous.size;
+            linear.resize(previous.size);
+            for (size_t i = 0; i < previous.size; ++i)
+                linear[i] = (channels == 4 && i % 4 == 3) ? alpha_to_linear[source[i]] : srgb_to_linear[source[i]];
+
+            Downsample(previous, linear.data(), channels, &levels[l], storage.data() + offset);
+        }
+        offset += levels[l].size;
+    }
+
+    // Os ponteiros só são definidos depois que "storage" tem seu tamanho final
+    offset = 0;
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        levels[l].data = storage.data() + offset;
+        offset += levels[l].size;
+    }
+
+    MappedFile_Close(&texture->mapping);
+    texture->storage.swap(storage);
+    texture->levels.swap(levels);
+    texture->width  = width;
+    texture->height = height;
+    texture->format = format;
+}
+
+std::string TextureCache_PathFor(const char* source_filename)
+{
+    return std::string(source_filename) + ".texcache";
+}
+
+bool TextureCache_Load(const char* source_filename, uint32_t flags, TextureData* texture)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if (!File_GetStamp(source_filename, &source_size, &source_mtime))
+        return false;
+
+    std::string path = TextureCache_PathFor(source_filename);
+
+    MappedFile file;
+    if (!MappedFile_Open(path.c_str(), &file))
+        return false;
+
+    if (file.size < sizeof(TextureCacheHeader))
+        return false;
+
+    TextureCacheHeader header;
+    memcpy(&header, file.data, sizeof(header));
+
+    if (memcmp(header.magic, TEXTURECACHE_MAGIC, sizeof(TEXTURECACHE_MAGIC)) != 0
+        || header.version != TEXTURECACHE_VERSION
+        || header.flags != flags
+        || header.format > TEXTURE_FORMAT_BC3
+        || header.source_size != source_size
+        || header.source_mtime != source_mtime
+        || header.file_size != file.size
+        || header.num_levels == 0 || header.num_levels > TEXTURE_MAX_LEVELS
+        || !File_SectionFits(header.levels_offset, header.num_levels*sizeof(TextureCacheLevel), file.size))
+    {
+        return false;
+    }
+
+    std::vector<TextureLevel> levels(header.num_levels);
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        TextureCacheLevel record;
+        memcpy(&record, file.data + header.levels_offset + l*sizeof(record), sizeof(record));
+
+        if (record.size != TextureCache_LevelSize(header.format, record.width, record.height)
+            || !File_SectionFits(record.offset, record.size, file.size))
+        {
+            return false;
+        }
+
+        levels[l].width  = (int)record.width;
+        levels[l].height = (int)record.height;
+        levels[l].data   = file.data + record.offset;
+        levels[l].size   = (size_t)record.size;
+    }
+
+    // A partir daqui o cache é válido, e o mapeamento passa para "texture"
+    texture->storage.clear();
+    texture->levels.swap(levels);
+    texture->width  = (int)header.width;
+    texture->height = (int)header.height;
+    texture->format = header.format;
+    MappedFile_Swap(&texture->mapping, &file);
+
+    return true;
+}
+
+bool TextureCache_Save(const char* source_filename, uint32_t flags, const TextureData& texture)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if (!File_GetStamp(source_filename, &source_size, &source_mtime))
+        return false;
+
+    TextureCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEXTURECACHE_MAGIC, sizeof(TEXTURECACHE_MAGIC));
+    header.version      = TEXTURECACHE_VERSION;
+    header.flags        = flags;
+    header.format       = texture.format;
+    header.num_levels   = (uint32_t)texture.levels.size();
+    header.source_size  = source_size;
+    header.source_mtime = source_mtime;
+    header.width        = (uint32_t)texture.width;
+    header.height       = (uint32_t)texture.height;
+
+    std::vector<TextureCacheLevel> records(texture.levels.size());
+    uint64_t offset = File_AlignTo16(sizeof(header));
+    header.levels_offset = offset;  offset = File_AlignTo16(offset + records.size()*sizeof(TextureCacheLevel));
+    for (size_t l = 0; l < records.size(); ++l)
+    {
+        records[l].width  = (uint32_t)texture.levels[l].width;
+        records[l].height = (uint32_t)texture.levels[l].height;
+        records[l].offset = offset;
+        records[l].size   = texture.levels[l].size;
+        offset = File_AlignTo16(offset + records[l].size);
+    }
+    header.file_size = offset;
+
+    std::vector<unsigned char> buffer(header.file_size, 0);
+    unsigned char* out = buffer.data();
+
+    memcpy(out, &header, sizeof(header));
+    if (!records.empty())
+        memcpy(out + header.levels_offset, records.data(), records.size()*sizeof(TextureCacheLevel));
+    for (size_t l = 0; l < records.size(); ++l)
+        memcpy(out + records[l].offset, texture.levels[l].data, records[l].size);
+
+    std::string path = TextureCache_PathFor(source_filename);
+    if (!File_WriteAtomic(path.c_str(), buffer.data(), buffer.size()))
+    {
+        fprintf(stderr, "WARNING: Cannot write texture cache \"%s\".\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,408 @@
+// Textura virtual esparsa. Veja "include/vtexture.h".
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "vtexture.h"
+#include "texturecache.h"
+#include "texcompress.h"
+
+static const char VTEX_MAGIC[8] = { 'F','C','G','V','T','E','X','\0' };
+
+struct VirtualTextureHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pages;
+    uint32_t num_levels;
+    uint32_t reserved;
+    uint64_t source_size;
+    int64_t  source_mtime;
+    uint64_t offsets_offset;
+    uint64_t page_size;
+    uint64_t file_size;
+};
+
+// Número de níveis de uma textura com "pages" páginas por lado no nível 0
+static int LevelsFor(int pages)
+{
+    int levels = 1;
+    while ((1 << (levels - 1)) < pages)
+        levels += 1;
+    return levels;
+}
+
+// Uma página está vazia se nenhum de seus texels pertence à imagem fonte
+static bool PageIsEmpty(int width, int height, int level, int x, int y)
+{
+    return ((int64_t)x * VTEX_PAGE_SIZE << level) >= width
+        || ((int64_t)y * VTEX_PAGE_SIZE << level) >= height;
+}
+
+int VirtualTexture_PagesAt(const VirtualTexture& vt, int level)
+{
+    return vt.pages >> level;
+}
+
+size_t VirtualTexture_PageIndex(const VirtualTexture& vt, int level, int x, int y)
+{
+    size_t first = 0;
+    for (int l = 0; l < level; ++l)
+        first += (size_t)VirtualTexture_PagesAt(vt, l) * VirtualTexture_PagesAt(vt, l);
+    return first + (size_t)y * VirtualTexture_PagesAt(vt, level) + x;
+}
+
+size_t VirtualTexture_NumPages(const VirtualTexture& vt)
+{
+    return VirtualTexture_PageIndex(vt, vt.num_levels, 0, 0);
+}
+
+const unsigned char* VirtualTexture_PageData(const VirtualTexture& vt, int level, int x, int y)
+{
+    const uint64_t offset = vt.page_offsets[VirtualTexture_PageIndex(vt, level, x, y)];
+    return offset == 0 ? NULL : vt.mapping.data + offset;
+}
+
+std::string VirtualTexture_PathFor(const char* source_filename)
+{
+    return std::string(source_filename) + ".vtex";
+}
+
+bool VirtualTexture_Load(const char* source_filename, uint32_t flags, VirtualTexture* vt)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if (!File_GetStamp(source_filename, &source_size, &source_mtime))
+        return false;
+
+    std::string path = VirtualTexture_PathFor(source_filename);
+
+    MappedFile file;
+    if (!MappedFile_Open(path.c_str(), &file))
+        return false;
+
+    if (file.size < sizeof(VirtualTextureHeader))
+        return false;
+
+    VirtualTextureHeader header;
+    memcpy(&header, file.data, sizeof(header));
+
+    if (memcmp(header.magic, VTEX_MAGIC, sizeof(VTEX_MAGIC)) != 0
+        || header.version != VTEX_VERSION
+        || header.flags != flags
+        || (header.format != TEXTURE_FORMAT_RGB8 && header.format != TEXTURE_FORMAT_BC1)
+        || header.page_size != TextureCache_LevelSize(header.format, VTEX_PAGE_STRIDE, VTEX_PAGE_STRIDE)
+        || header.source_size != source_size
+        || header.source_mtime != source_mtime
+        || header.file_size != file.size
+        || header.pages == 0 || header.pages > VTEX_MAX_PAGES || (header.pages & (header.pages - 1)) != 0
+        || header.num_levels != (uint32_t)LevelsFor((int)header.pages))
+    {
+        return false;
+    }
+
+    VirtualTexture loaded;
+    loaded.width      = (int)header.width;
+    loaded.height     = (int)header.height;
+    loaded.pages      = (int)header.pages;
+    loaded.num_levels = (int)header.num_levels;
+
+    const size_t num_pages = VirtualTexture_NumPages(loaded);
+    if (!File_SectionFits(header.offsets_offset, num_pages*sizeof(uint64_t), file.size))
+        return false;
+
+    std::vector<uint64_t> offsets(num_pages);
+    memcpy(offsets.data(), file.data + header.offsets_offset, num_pages*sizeof(uint64_t));
+    for (size_t i = 0; i < num_pages; ++i)
+    {
+        if (offsets[i] != 0 && !File_SectionFits(offsets[i], header.page_size, file.size))
+            return false;
+    }
+
+    // A partir daqui o arquivo é válido, e o mapeamento passa para "vt"
+    vt->width      = loaded.width;
+    vt->height     = loaded.height;
+    vt->pages      = loaded.pages;
+    vt->num_levels = loaded.num_levels;
+    vt->format     = header.format;
+    vt->page_size  = (size_t)header.page_size;
+    vt->page_offsets.swap(offsets);
+    MappedFile_Swap(&vt->mapping, &file);
+
+    return true;
+}
+
+bool VirtualTexture_Build(const char* source_filename, uint32_t flags, const unsigned char* pixels, int width, int height)
+{
+    uint64_t source_size;
+    int64_t  source_mtime;
+    if (!File_GetStamp(source_filename, &source_size, &source_mtime))
+        return false;
+
+    // O nível 0 é um quadrado de "pages" páginas por lado (potência de 2),
+    // para que cada nível tenha exatamente metade das páginas do anterior e a
+    // tabela de indireção seja uma textura com mipmaps comum.
+    const int min_pages = std::max((width + VTEX_PAGE_SIZE - 1) / VTEX_PAGE_SIZE, (height + VTEX_PAGE_SIZE - 1) / VTEX_PAGE_SIZE);
+    int pages = 1;
+    while (pages < min_pages)
+        pages *= 2;
+    if (pages > VTEX_MAX_PAGES)
+    {
+        fprintf(stderr, "ERROR: Image \"%s\" is too large for a virtual texture (%dx%d).\n", source_filename, width, height);
+        return false;
+    }
+
+    const int size = pages * VTEX_PAGE_SIZE;
+    const int num_levels = LevelsFor(pages);
+
+    // Estendemos a imagem até o quadrado repetindo as bordas, de forma que a
+    // filtragem junto às bordas da imagem não misture texels inexistentes.
+    std::vector<unsigned char> padded(3 * (size_t)size * size);
+    for (int y = 0; y < size; ++y)
+    {
+        const unsigned char* row = pixels + 3 * (size_t)std::min(y, height - 1) * width;
+        unsigned char* out = &padded[3 * (size_t)y * size];
+        memcpy(out, row, 3 * (size_t)width);
+        for (int x = width; x < size; ++x)
+            memcpy(out + 3*x, row + 3*(width - 1), 3);
+    }
+
+    TextureData mipmaps;
+    TextureCache_BuildMipmaps(padded.data(), size, size, 3, &mipmaps);
+    std::vector<unsigned char>().swap(padded);
+
+    const bool compressed = (flags & TEXTURECACHE_FLAG_COMPRESSED) != 0;
+    const int  quality = (int)((flags >> TEXTURECACHE_QUALITY_SHIFT) & 0xFF);
+    const uint32_t format = compressed ? TEXTURE_FORMAT_BC1 : TEXTURE_FORMAT_RGB8;
+    const size_t page_size = TextureCache_LevelSize(format, VTEX_PAGE_STRIDE, VTEX_PAGE_STRIDE);
+
+    VirtualTexture layout;
+    layout.pages      = pages;
+    layout.num_levels = num_levels;
+    const size_t num_pages = VirtualTexture_NumPages(layout);
+
+    VirtualTextureHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, VTEX_MAGIC, sizeof(VTEX_MAGIC));
+    header.version      = VTEX_VERSION;
+    header.flags        = flags;
+    header.format       = format;
+    header.width        = (uint32_t)width;
+    header.height       = (uint32_t)height;
+    header.pages        = (uint32_t)pages;
+    header.num_levels   = (uint32_t)num_levels;
+    header.source_size  = source_size;
+    header.source_mtime = source_mtime;
+    header.page_size    = page_size;
+
+    std::vector<uint64_t> offsets(num_pages, 0);
+    uint64_t offset = File_AlignTo16(sizeof(header));
+    header.offsets_offset = offset;  offset = File_AlignTo16(offset + num_pages*sizeof(uint64_t));
+    for (int level = 0; level < num_levels; ++level)
+    {
+        for (int y = 0; y < VirtualTexture_PagesAt(layout, level); ++y)
+        {
+            for (int x = 0; x < VirtualTexture_PagesAt(layout, level); ++x)
+            {
+                if (PageIsEmpty(width, height, level, x, y))
+                    continue;
+                offsets[VirtualTexture_PageIndex(layout, level, x, y)] = offset;
+                offset = File_AlignTo16(offset + page_size);
+            }
+        }
+    }
+    header.file_size = offset;
+
+    std::vector<unsigned char> buffer(header.file_size, 0);
+    memcpy(buffer.data(), &header, sizeof(header));
+    memcpy(buffer.data() + header.offsets_offset, offsets.data(), num_pages*sizeof(uint64_t));
+
+    // Copiamos cada página com suas bordas, repetindo os texels da borda do
+    // nível onde a página ultrapassa a imagem.
+    std::vector<unsigned char> page(3 * VTEX_PAGE_STRIDE * VTEX_PAGE_STRIDE);
+    for (int level = 0; level < num_levels; ++level)
+    {
+        const TextureLevel& source = mipmaps.levels[level];
+        for (int y = 0; y < VirtualTexture_PagesAt(layout, level); ++y)
+        {
+            for (int x = 0; x < VirtualTexture_PagesAt(layout, level); ++x)
+            {
+                const uint64_t page_offset = offsets[VirtualTexture_PageIndex(layout, level, x, y)];
+                if (page_offset == 0)
+                    continue;
+
+                for (int ty = 0; ty < VTEX_PAGE_STRIDE; ++ty)
+                {
+                    const int sy = std::max(0, std::min(source.height - 1, y*VTEX_PAGE_SIZE - VTEX_PAGE_BORDER + ty));
+                    for (int tx = 0; tx < VTEX_PAGE_STRIDE; ++tx)
+                    {
+                        const int sx = std::max(0, std::min(source.width - 1, x*VTEX_PAGE_SIZE - VTEX_PAGE_BORDER + tx));
+                        memcpy(&page[3 * (ty*VTEX_PAGE_STRIDE + tx)], source.data + 3 * ((size_t)sy*source.width + sx), 3);
+                    }
+                }
+
+                unsigned char* out = buffer.data() + page_offset;
+                if (compressed)
+                    TexCompress_EncodeBC1(page.data(), 3, VTEX_PAGE_STRIDE, VTEX_PAGE_STRIDE, quality, out);
+                else
+                    memcpy(out, page.data(), page_size);
+            }
+        }
+    }
+
+    std::string path = VirtualTexture_PathFor(source_filename);
+    if (!File_WriteAtomic(path.c_str(), buffer.data(), buffer.size()))
+    {
+        fprintf(stderr, "WARNING: Cannot write virtual texture \"%s\".\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void VirtualTexture_InitCache(const VirtualTexture& vt, int slots, VirtualTextureCache* cache)
+{
+    const VirtualTexturePage free_slot = { -1, 0, 0 };
+    const size_t num_pages = VirtualTexture_NumPages(vt);
+
+    cache->slots = slots;
+    cache->slot_pages.assign(slots * slots, free_slot);
+    cache->slot_last_used.assign(slots * slots, 0);
+    cache->page_slots.assign(num_pages, -1);
+    cache->page_requested.assign(num_pages, 0);
+    cache->requests.clear();
+    cache->indirection.assign(4 * num_pages, 0);
+    cache->frame = 0;
+    cache->indirection_dirty = true;
+}
+
+static bool LessDetailedFirst(const VirtualTexturePage& a, const VirtualTexturePage& b)
+{
+    return a.level > b.level;
+}
+
+void VirtualTexture_ProcessFeedback(const VirtualTexture& vt, VirtualTextureCache* cache, const unsigned char* pixels, size_t num_pixels)
+{
+    cache->frame += 1;
+    cache->requests.clear();
+
+    // A página do último nível cobre toda a imagem, e está sempre em uso
+    const size_t root = VirtualTexture_PageIndex(vt, vt.num_levels - 1, 0, 0);
+    if (cache->page_slots[root] >= 0)
+        cache->slot_last_used[cache->page_slots[root]] = cache->frame;
+
+    for (size_t i = 0; i < num_pixels; ++i)
+    {
+        const unsigned char* p = pixels + 4*i;
+        if (p[2] == 0)
+            continue;
+
+        int level = p[2] - 1;
+        int x = p[0];
+        int y = p[1];
+        if (level >= vt.num_levels || x >= VirtualTexture_PagesAt(vt, level) || y >= VirtualTexture_PagesAt(vt, level))
+            continue;
+
+        // Marcamos a página e as que a contêm, até encontrar uma já marcada
+        // neste quadro (e portanto também as seguintes).
+        for (; level < vt.num_levels; ++level, x /= 2, y /= 2)
+        {
+            const size_t index = VirtualTexture_PageIndex(vt, level, x, y);
+            if (cache->page_requested[index] == cache->frame)
+                break;
+            cache->page_requested[index] = cache->frame;
+
+            if (vt.page_offsets[index] == 0)
+                continue;
+
+            const int slot = cache->page_slots[index];
+            if (slot >= 0)
+            {
+                cache->slot_last_used[slot] = cache->frame;
+            }
+            else
+            {
+                VirtualTexturePage page = { level, x, y };
+                cache->requests.push_back(page);
+            }
+        }
+    }
+
+    // As páginas menos detalhadas primeiro: cobrem mais área da tela, e são
+    // a base para as mais detalhadas quando o cache está cheio.
+    std::stable_sort(cache->requests.begin(), cache->requests.end(), LessDetailedFirst);
+}
+
+int VirtualTexture_AllocateSlot(const VirtualTexture& vt, VirtualTextureCache* cache, const VirtualTexturePage& page)
+{
+    int slot = -1;
+    for (size_t s = 0; s < cache->slot_pages.size(); ++s)
+    {
+        const VirtualTexturePage& resident = cache->slot_pages[s];
+        if (resident.level < 0)
+        {
+            slot = (int)s;
+            break;
+        }
+        if (cache->slot_last_used[s] == cache->frame || resident.level == vt.num_levels - 1)
+            continue;
+        if (slot < 0 || cache->slot_last_used[s] < cache->slot_last_used[slot])
+            slot = (int)s;
+    }
+    if (slot < 0)
+        return -1;
+
+    const VirtualTexturePage& evicted = cache->slot_pages[slot];
+    if (evicted.level >= 0)
+        cache->page_slots[VirtualTexture_PageIndex(vt, evicted.level, evicted.x, evicted.y)] = -1;
+
+    cache->slot_pages[slot] = page;
+    cache->slot_last_used[slot] = cache->frame;
+    cache->page_slots[VirtualTexture_PageIndex(vt, page.level, page.x, page.y)] = slot;
+    cache->indirection_dirty = true;
+    return slot;
+}
+
+bool VirtualTexture_UpdateIndirection(const VirtualTexture& vt, VirtualTextureCache* cache)
+{
+    if (!cache->indirection_dirty)
+        return false;
+
+    // Do nível menos detalhado para o mais detalhado: uma página não
+    // residente herda a entrada da página que a contém no nível seguinte.
+    for (int level = vt.num_levels - 1; level >= 0; --level)
+    {
+        const int pages = VirtualTexture_PagesAt(vt, level);
+        for (int y = 0; y < pages; ++y)
+        {
+            for (int x = 0; x < pages; ++x)
+            {
+                const size_t index = VirtualTexture_PageIndex(vt, level, x, y);
+                unsigned char* entry = &cache->indirection[4*index];
+                const int slot = cache->page_slots[index];
+                if (slot >= 0)
+                {
+                    entry[0] = (unsigned char)(slot % cache->slots);
+                    entry[1] = (unsigned char)(slot / cache->slots);
+                    entry[2] = (unsigned char)level;
+                    entry[3] = 255;
+                }
+                else if (level + 1 < vt.num_levels)
+                {
+                    memcpy(entry, &cache->indirection[4*VirtualTexture_PageIndex(vt, level + 1, x/2, y/2)], 4);
+                }
+                else
+                {
+                    memset(entry, 0, 4);
+                }
+            }
+        }
+    }
+
+    cache->indirection_dirty = false;
+    return true;
+}